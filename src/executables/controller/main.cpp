@@ -1,10 +1,9 @@
 #include<cstdio>
-#include<opencv2/highgui/highgui.hpp>
-#include<opencv2/imgproc/imgproc.hpp>
 #include<string>
 #include "SOMException.hpp"
 #include<zmq.hpp>
 #include<memory>
+#include "dummyController.hpp"
 
 //Dummy controller that just streams video to aid development of GUI
 int main(int argc, char **argv)
@@ -12,7 +11,7 @@ int main(int argc, char **argv)
 
 if(argc < 4)
 {
-fprintf(stderr, "Error, incorrect number of arguments.  \nUsage: videoDeviceNumber commandInterfacePortNumberToBind videStreamingPortNumberToBind\n");
+fprintf(stderr, "Error, incorrect number of arguments.  \nUsage: videoDeviceNumber commandInterfaceEndpointToBind videStreamingEndpointToBind [emergencyStopEndpointToBind]\n(endpoints can be port numbers or full ZMQ endpoints such as ipc:///tmp/soaringPenVideo, and the video endpoint can be shm://name to share raw frames with GUIs on the same host)\n");
 return 1;
 }
 
@@ -21,46 +20,6 @@ SOM_TRY
 videoDeviceNumber = std::stol(std::string(argv[1]));
 SOM_CATCH("Error, unable to read video device number\n")
 
-int commandInterfacePortNumberToBind = 0;
-SOM_TRY
-commandInterfacePortNumberToBind = std::stol(std::string(argv[2]));
-SOM_CATCH("Error, unable to read commandInterfacePortNumberToBind\n")
-
-int videoStreamingPortNumberToBind = 0;
-SOM_TRY
-videoStreamingPortNumberToBind = std::stol(std::string(argv[3]));
-SOM_CATCH("Error, unable to read videoStreamingPortNumberToBind\n")
-
-cv::VideoCapture imageSource;
-cv::Mat sourceImage;
-
-//Open image source
-if(imageSource.open(videoDeviceNumber) != true)
-{
-fprintf(stderr, "Error, unable to open video device\n");
-return 1;
-}
-
-//Could hardcode/set camera resolution
-//imageSource.set(CV_CAP_PROP_FRAME_WIDTH,1080);
-//imageSource.set(CV_CAP_PROP_FRAME_HEIGHT,720);
-
-imageSource.set(CV_CAP_PROP_FRAME_WIDTH,1280);
-imageSource.set(CV_CAP_PROP_FRAME_HEIGHT,720);
-
-
-//Get first image (used for automatic dimension detection)
-SOM_TRY
-imageSource >> sourceImage;
-SOM_CATCH("Error retrieving first image\n")
-
-//Create display interface using opencv
-cv::namedWindow("Display", 1);
-
-SOM_TRY
-cv::imshow("Display", sourceImage);
-SOM_CATCH("Error showing image\n")
-
 //Create ZMQ context
 std::unique_ptr<zmq::context_t> context;
 
@@ -68,74 +27,18 @@ SOM_TRY
 context.reset(new zmq::context_t);
 SOM_CATCH("Error initializing context\n")
 
-//Create dummy PAIR interface so that GUI can initialize correctly
-std::unique_ptr<zmq::socket_t> commandReceiver;
-
-SOM_TRY //Initialize
-commandReceiver.reset(new zmq::socket_t(*(context), ZMQ_PAIR));
-SOM_CATCH("Error initializing command socket\n")
-
-SOM_TRY //Bind
-std::string bindingAddress = "tcp://*:"+ std::to_string(commandInterfacePortNumberToBind);
-commandReceiver->bind(bindingAddress.c_str());
-SOM_CATCH("Error binding command receiver\n")
-
+std::unique_ptr<soaringPen::dummyController> controller;
 
-//Setup ZMQ pub socket to share video with
-std::unique_ptr<zmq::socket_t> videoPublisher;
-
-SOM_TRY //Initialize
-videoPublisher.reset(new zmq::socket_t(*(context), ZMQ_PUB));
-SOM_CATCH("Error initializing video sharing socket\n")
-
-SOM_TRY //Bind
-std::string bindingAddress = "tcp://*:"+ std::to_string(videoStreamingPortNumberToBind);
-videoPublisher->bind(bindingAddress.c_str());
-SOM_CATCH("Error binding video publisher\n")
-
-
-//Display video and share it
-while(true)
-{
-if(imageSource.grab() != true)
+try
 {
-fprintf(stderr, "Error, unable to get image from video source\n");
-return 1;
+controller.reset(new soaringPen::dummyController(*context, videoDeviceNumber, std::string(argv[2]), std::string(argv[3]), true, argc > 4 ? std::string(argv[4]) : ""));
+controller->run();
 }
-
-//Get image from camera
-if(imageSource.retrieve(sourceImage) != true)
+catch(const std::exception &inputException)
 {
-fprintf(stderr, "Error getting image\n");
+fprintf(stderr, "Error: %s\n", inputException.what());
 return 1;
 }
 
-//Compress/encode it for transmission
-std::vector<unsigned char> encodedImage;
-std::vector<int> options; //Pairs of format type:value
-
-//Set jpg quality
-options.push_back(CV_IMWRITE_JPEG_QUALITY);
-options.push_back(95);
-
-if(cv::imencode(".jpg", sourceImage, encodedImage, options) != true)
-{
-fprintf(stderr, "Error encoding image\n");
-return 1;
-}
-
-//Publish image
-SOM_TRY
-videoPublisher->send(encodedImage.data(), encodedImage.size());
-SOM_CATCH("Error publishing image\n");
-
-//Display the image with labeled markers/axis
-cv::imshow("Display", sourceImage);
-
-//Wait, enabling opencv to display the image
-auto key = cv::waitKey(10); //Wait 10 milliseconds
-}
-
-
 return 0;
 }
@@ -2,9 +2,12 @@
 #include<opencv2/highgui/highgui.hpp>
 #include<opencv2/imgproc/imgproc.hpp>
 #include<string>
+#include<cstring>
 #include "SOMException.hpp"
 #include<zmq.hpp>
 #include<memory>
+#include "utilityFunctions.hpp"
+#include "linkQualityMonitor.hpp"
 
 
 int main(int argc, char **argv)
@@ -12,7 +15,7 @@ int main(int argc, char **argv)
 
 if(argc < 3)
 {
-fprintf(stderr, "Error, incorrect number of arguments.  \nUsage: videoDeviceNumber portNumberToBind\n");
+fprintf(stderr, "Error, incorrect number of arguments.  \nUsage: videoDeviceNumber endpointToBind (port number or full ZMQ endpoint)\n");
 return 1;
 }
 
@@ -21,10 +24,10 @@ SOM_TRY
 videoDeviceNumber = std::stol(std::string(argv[1]));
 SOM_CATCH("Error, unable to read video device number\n")
 
-int portNumberToBind = 0;
+std::string endpointToBind;
 SOM_TRY
-portNumberToBind = std::stol(std::string(argv[2]));
-SOM_CATCH("Error, unable to read portNumberToBind\n")
+endpointToBind = pylongps::normalizeZMQBindEndpoint(std::string(argv[2]));
+SOM_CATCH("Error, unable to read endpointToBind\n")
 
 cv::VideoCapture imageSource;
 cv::Mat sourceImage;
@@ -72,8 +75,7 @@ videoPublisher.reset(new zmq::socket_t(*(context), ZMQ_PUB));
 SOM_CATCH("Error initializing video sharing socket\n")
 
 SOM_TRY //Bind
-std::string bindingAddress = "tcp://*:"+ std::to_string(portNumberToBind);
-videoPublisher->bind(bindingAddress.c_str());
+videoPublisher->bind(endpointToBind.c_str());
 SOM_CATCH("Error binding video publisher\n")
 
 
@@ -86,6 +88,8 @@ fprintf(stderr, "Error, unable to get image from video source\n");
 return 1;
 }
 
+int64_t captureTime = soaringPen::monotonicMicroseconds();
+
 //Get image from camera
 if(imageSource.retrieve(sourceImage) != true)
 {
@@ -107,9 +111,12 @@ fprintf(stderr, "Error encoding image\n");
 return 1;
 }
 
-//Publish image
+//Publish image, prefixed with when it was captured
 SOM_TRY
-videoPublisher->send(encodedImage.data(), encodedImage.size());
+zmq::message_t frameMessage(soaringPen::VIDEO_FRAME_CAPTURE_TIME_SIZE + encodedImage.size());
+memcpy(frameMessage.data(), &captureTime, soaringPen::VIDEO_FRAME_CAPTURE_TIME_SIZE);
+memcpy(((char *) frameMessage.data()) + soaringPen::VIDEO_FRAME_CAPTURE_TIME_SIZE, encodedImage.data(), encodedImage.size());
+videoPublisher->send(frameMessage);
 SOM_CATCH("Error publishing image\n");
 
 //Display the image with labeled markers/axis
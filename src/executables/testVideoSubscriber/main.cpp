@@ -2,9 +2,12 @@
 #include<opencv2/highgui/highgui.hpp>
 #include<opencv2/imgproc/imgproc.hpp>
 #include<string>
+#include<cstring>
 #include "SOMException.hpp"
 #include<zmq.hpp>
 #include<memory>
+#include "utilityFunctions.hpp"
+#include "linkQualityMonitor.hpp"
 
 
 int main(int argc, char **argv)
@@ -12,7 +15,7 @@ int main(int argc, char **argv)
 
 if(argc < 2)
 {
-fprintf(stderr, "Error, incorrect number of arguments.  \nUsage: IPOfSource:portOfSource\n");
+fprintf(stderr, "Error, incorrect number of arguments.  \nUsage: IPOfSource:portOfSource (or full ZMQ endpoint)\n");
 return 1;
 }
 
@@ -42,7 +45,7 @@ videoSubscriber->setsockopt(ZMQ_SUBSCRIBE, nullptr, 0);
 SOM_CATCH("Error setting subscription filter\n")
 
 SOM_TRY //Connect
-std::string bindingAddress = std::string("tcp://")+ argv[1];
+std::string bindingAddress = pylongps::normalizeZMQConnectionEndpoint(argv[1]);
 videoSubscriber->connect(bindingAddress.c_str());
 SOM_CATCH("Error connecting to video publisher\n")
 
@@ -62,7 +65,12 @@ continue; //No message received
 }
 SOM_CATCH("Error receiving message\n")
 
-std::vector<unsigned char> encodedImage((unsigned char *) messageBuffer->data(), ((unsigned char *) messageBuffer->data())+messageBuffer->size()); //Copy to vector
+if(messageBuffer->size() <= soaringPen::VIDEO_FRAME_CAPTURE_TIME_SIZE)
+{ //Too short to have an image after the capture time
+continue;
+}
+
+std::vector<unsigned char> encodedImage(((unsigned char *) messageBuffer->data()) + soaringPen::VIDEO_FRAME_CAPTURE_TIME_SIZE, ((unsigned char *) messageBuffer->data())+messageBuffer->size()); //Copy to vector, skipping the capture time
 
 //Decompress/decode image for display
 SOM_TRY
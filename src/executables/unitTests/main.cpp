@@ -2,6 +2,24 @@
 #include "catch.hpp"
 
 #include "exampleHeaderFile.hpp"
+#include "linearPath.hpp"
+#include "linearPathSegmentGrid.hpp"
+#include "catmullRomPath.hpp"
+#include "batchGeometry.hpp"
+#include "geofence.hpp"
+#include "pathEncoding.hpp"
+#include "commandScheduler.hpp"
+#include "telemetryBatcher.hpp"
+#include "latestValueBuffer.hpp"
+#include "linkQualityMonitor.hpp"
+#include "utilityFunctions.hpp"
+#include "sharedMemoryFrameRing.hpp"
+#include "asynchronousRemoteProcedureCallClient.hpp"
+#include "emergencyStopChannel.hpp"
+#include "videoRelay.hpp"
+#include "SOMScopeGuard.hpp"
+#include<thread>
+#include<sstream>
 
 #include <board.h>
 
@@ -34,3 +52,844 @@ REQUIRE(std::to_string(*((int32_t *) &testFloat)) == "-1085485875");
 }
 
 }
+
+TEST_CASE("Test point arithmetic", "[fPoint]")
+{
+//Point arithmetic can be evaluated at compile time
+constexpr soaringPen::fPoint point(1.0, 2.0);
+static_assert((.5*point + point - soaringPen::fPoint(1.0, 1.0)) == soaringPen::fPoint(.5, 2.0), "Constexpr point arithmetic failed");
+static_assert(soaringPen::dot(point, point) == 5.0, "Constexpr dot product failed");
+
+soaringPen::fPoint accumulator(point);
+accumulator += point;
+accumulator *= 3.0;
+accumulator -= soaringPen::fPoint(1.0, 1.0);
+accumulator /= 5.0;
+REQUIRE(accumulator == soaringPen::fPoint(1.0, 2.2));
+REQUIRE(point.distance(soaringPen::fPoint(4.0, 6.0)) == 5.0);
+}
+
+TEST_CASE("Test linear path interpolation", "[linearPath]")
+{
+soaringPen::linearPath path;
+path.addPoint(soaringPen::fPoint(0.0, 0.0));
+path.addPoint(soaringPen::fPoint(1.0, 0.0));
+path.addPoint(soaringPen::fPoint(1.0, 2.0));
+
+SECTION("Interpolation and derivative")
+{
+REQUIRE(path.pathLength == Approx(3.0));
+REQUIRE(path.interpolate(0.5).val[0] == Approx(0.5));
+REQUIRE(path.interpolate(2.0).val[1] == Approx(1.0));
+REQUIRE(path.derivative(0.5).val[0] == Approx(1.0));
+REQUIRE(path.derivative(2.0).val[1] == Approx(1.0));
+REQUIRE_THROWS(path.interpolate(-1.0));
+REQUIRE_THROWS(path.interpolate(3.5));
+}
+
+SECTION("Batch sampling")
+{
+double locations[] = {0.0, 0.5, 2.0, 3.0, 4.0};
+double xCoordinates[5];
+double yCoordinates[5];
+REQUIRE(path.interpolateMany(locations, 5, xCoordinates, yCoordinates) == false); //4.0 is past the end
+REQUIRE(xCoordinates[1] == Approx(0.5));
+REQUIRE(yCoordinates[2] == Approx(1.0));
+REQUIRE(yCoordinates[4] == Approx(2.0));
+
+REQUIRE(path.derivativeMany(locations, 4, xCoordinates, yCoordinates));
+REQUIRE(xCoordinates[1] == Approx(1.0));
+REQUIRE(yCoordinates[3] == Approx(1.0));
+}
+
+SECTION("Cursor")
+{
+soaringPen::linearPath::cursor pathCursor(path);
+for(double location = 0.0; location <= 3.0; location += .25)
+{ //Move forward
+auto result = pathCursor.moveTo(location);
+REQUIRE(std::get<0>(result) == path.interpolate(location));
+REQUIRE(std::get<1>(result) == path.derivative(location));
+REQUIRE(std::get<2>(result) == Approx(3.0 - location));
+}
+
+auto result = pathCursor.moveTo(0.5); //Move backward
+REQUIRE(std::get<0>(result).val[0] == Approx(0.5));
+REQUIRE(pathCursor.segmentEndIndex == 1);
+REQUIRE_THROWS(pathCursor.moveTo(3.5));
+}
+
+SECTION("Truncation")
+{
+path.truncate(1.5);
+REQUIRE(path.points.size() == 3);
+REQUIRE(path.pathLength == Approx(1.5));
+REQUIRE(path.points.back().val[1] == Approx(0.5));
+}
+}
+
+TEST_CASE("Test linear path resampling and simplification", "[linearPath]")
+{
+soaringPen::linearPath path;
+for(int i=0; i<=100; i++)
+{ //Slightly noisy line from (0,0) to (1,0), then a corner up to (1,1)
+path.addPoint(soaringPen::fPoint(i/100.0, (i % 2)*.001));
+}
+path.addPoint(soaringPen::fPoint(1.0, 1.0));
+
+SECTION("Simplification")
+{
+soaringPen::linearPath simplifiedPath = path.simplify(.01);
+REQUIRE(simplifiedPath.points.size() == 3);
+REQUIRE(simplifiedPath.points[1].val[0] == Approx(1.0));
+REQUIRE(simplifiedPath.points.back().val[1] == Approx(1.0));
+}
+
+SECTION("Resampling")
+{
+soaringPen::linearPath resampledPath = path.simplify(.01).resample(.3);
+REQUIRE(resampledPath.points.size() == 8);
+REQUIRE(resampledPath.pathLength <= path.pathLength);
+REQUIRE(resampledPath.points.back().val[1] == Approx(1.0));
+REQUIRE_THROWS(path.resample(0.0));
+}
+
+SECTION("Resampling keeping points")
+{
+const double maximumLateralError = .01;
+soaringPen::linearPath simplifiedPath = path.simplify(maximumLateralError);
+soaringPen::linearPath resampledPath = simplifiedPath.resample(.3, true);
+REQUIRE(resampledPath.points.size() == 9);
+REQUIRE(resampledPath.pathLength == Approx(simplifiedPath.pathLength));
+
+for(int i=1; i<resampledPath.points.size(); i++)
+{
+REQUIRE((resampledPath.associatedPathLocations[i] - resampledPath.associatedPathLocations[i-1]) <= .3 + 1e-9);
+}
+
+//Every drawn point has to be within the lateral error of the path that would be sent, and the sent path can't stray from the drawn one
+soaringPen::linearPathSegmentGrid resampledGrid(resampledPath, .05);
+for(const soaringPen::fPoint &point : path.points)
+{
+REQUIRE(std::get<0>(resampledGrid.findNearestPoint(point)) <= maximumLateralError);
+}
+
+soaringPen::linearPathSegmentGrid drawnGrid(path, .05);
+for(const soaringPen::fPoint &point : resampledPath.points)
+{
+REQUIRE(std::get<0>(drawnGrid.findNearestPoint(point)) <= maximumLateralError);
+}
+}
+}
+
+TEST_CASE("Test linear path segment grid", "[linearPath]")
+{
+soaringPen::linearPath path;
+soaringPen::linearPathSegmentGrid grid(path, .1);
+path.addPoint(soaringPen::fPoint(0.0, 0.0));
+path.addPoint(soaringPen::fPoint(1.0, 0.0));
+
+auto result = grid.findNearestPoint(soaringPen::fPoint(.5, .2));
+REQUIRE(std::get<0>(result) == Approx(.2));
+REQUIRE(std::get<1>(result) == Approx(.5));
+
+//Appended segments are picked up incrementally
+path.addPoint(soaringPen::fPoint(1.0, 1.0));
+result = grid.findNearestPoint(soaringPen::fPoint(1.3, .8));
+REQUIRE(std::get<0>(result) == Approx(.3));
+REQUIRE(std::get<1>(result) == Approx(1.8));
+
+//Removed points cause a rebuild
+path.popBack();
+result = grid.findNearestPoint(soaringPen::fPoint(1.3, .8));
+REQUIRE(std::get<0>(result) == Approx(soaringPen::fPoint(.3, .8).mag()));
+
+//Far off queries only search the occupied cells (this would take ~10^26 cell visits otherwise)
+result = grid.findNearestPoint(soaringPen::fPoint(1e12, -1e12));
+REQUIRE(std::get<0>(result) == Approx(soaringPen::fPoint(1e12 - 1.0, 1e12).mag()));
+REQUIRE(std::get<1>(result) == Approx(1.0));
+result = grid.findNearestPoint(soaringPen::fPoint(-1e150, .05));
+REQUIRE(std::get<0>(result) == Approx(1e150));
+REQUIRE_THROWS(grid.findNearestPoint(soaringPen::fPoint(NAN, 0.0)));
+REQUIRE_THROWS(grid.findNearestPoint(soaringPen::fPoint(0.0, INFINITY)));
+}
+
+TEST_CASE("Test 3D and single precision paths", "[linearPath]")
+{
+soaringPen::linearPath3D path;
+path.addPoint(soaringPen::fPoint3D(0.0, 0.0, 0.0));
+path.addPoint(soaringPen::fPoint3D(0.0, 3.0, 4.0));
+
+REQUIRE(path.pathLength == Approx(5.0));
+REQUIRE(path.interpolate(2.5).val[2] == Approx(2.0));
+REQUIRE(path.derivative(1.0).val[1] == Approx(.6));
+
+soaringPen::linearPath2DFloat floatPath;
+floatPath.addPoint(soaringPen::fPoint2DFloat(soaringPen::fPoint(0.0, 0.0)));
+floatPath.addPoint(soaringPen::fPoint2DFloat(3.0, 4.0));
+REQUIRE(floatPath.pathLength == Approx(5.0f));
+REQUIRE(sizeof(soaringPen::fPoint2DFloat) == 2*sizeof(float));
+}
+
+TEST_CASE("Test Catmull-Rom spline path", "[catmullRomPath]")
+{
+soaringPen::linearPath circle;
+for(int i=0; i<=64; i++)
+{
+double angle = i*2*PI/64;
+circle.addPoint(soaringPen::fPoint(cos(angle), sin(angle)));
+}
+
+soaringPen::catmullRomPath spline(circle);
+REQUIRE(spline.pathLength == Approx(2*PI).epsilon(.001));
+
+//Spline through points on the unit circle should stay on it, tangent to it, with a curvature of about 1
+soaringPen::fPoint point = spline.interpolate(1.0);
+REQUIRE(point.mag() == Approx(1.0).epsilon(.001));
+REQUIRE(fabs(soaringPen::dot(point, spline.derivative(1.0))) < .001);
+REQUIRE(spline.curvature(1.0) == Approx(1.0).epsilon(.01));
+REQUIRE_THROWS(spline.interpolate(7.0));
+}
+
+TEST_CASE("Test batch geometry functions", "[batchGeometry]")
+{
+//Odd number of points to exercise the remainder handling of the vector versions
+std::vector<soaringPen::fPoint> points;
+for(int i=0; i<7; i++)
+{
+points.push_back(soaringPen::fPoint(i*.5, i*i*.25));
+}
+
+std::vector<double> cumulativeLengths(points.size());
+soaringPen::computeCumulativeLengths(points.data(), points.size(), cumulativeLengths.data());
+REQUIRE(cumulativeLengths[0] == 0.0);
+for(int i=1; i<points.size(); i++)
+{
+REQUIRE(cumulativeLengths[i] == Approx(cumulativeLengths[i-1] + points[i-1].distance(&points[i])));
+}
+
+double matrix[4] = {0.0, -2.0, 2.0, 0.0}; //Rotate and scale
+std::vector<soaringPen::fPoint> transformedPoints(points.size());
+soaringPen::affineTransformPoints(points.data(), points.size(), matrix, soaringPen::fPoint(1.0, 1.0), transformedPoints.data());
+REQUIRE(transformedPoints[6].val[0] == Approx(1.0 - 2.0*points[6].val[1]));
+REQUIRE(transformedPoints[6].val[1] == Approx(1.0 + 2.0*points[6].val[0]));
+
+soaringPen::clampPoints(transformedPoints.data(), transformedPoints.size(), soaringPen::fPoint(-1.0, 0.0), soaringPen::fPoint(1.0, 2.0));
+REQUIRE(transformedPoints[6].val[0] == -1.0);
+REQUIRE(transformedPoints[6].val[1] == 2.0);
+REQUIRE(transformedPoints[0].val[0] == 1.0);
+
+std::vector<double> ratios = {0.0, .25, .5, .75, 1.0, .5, .5};
+std::vector<soaringPen::fPoint> interpolatedPoints(points.size());
+soaringPen::lerpPoints(points.data(), transformedPoints.data(), ratios.data(), points.size(), interpolatedPoints.data());
+REQUIRE(interpolatedPoints[0] == points[0]);
+REQUIRE(interpolatedPoints[4] == transformedPoints[4]);
+REQUIRE(interpolatedPoints[6].val[1] == Approx(.5*(points[6].val[1] + transformedPoints[6].val[1])));
+
+//Every implementation must give the same (scalar fmin/fmax) results, including when the bounds are NaN (such as bounds computed from an image size of 0)
+std::string defaultInstructionSet = soaringPen::batchGeometryInstructionSet();
+double notANumber = std::nan("");
+for(const std::string &instructionSet : {"scalar", "SSE2", "AVX2"})
+{
+if(!soaringPen::setBatchGeometryInstructionSet(instructionSet))
+{ //Not supported by this processor
+continue;
+}
+REQUIRE(soaringPen::batchGeometryInstructionSet() == instructionSet);
+
+std::vector<soaringPen::fPoint> clampedPoints = points;
+soaringPen::clampPoints(clampedPoints.data(), clampedPoints.size(), soaringPen::fPoint(notANumber, notANumber), soaringPen::fPoint(notANumber, notANumber));
+for(int i=0; i<points.size(); i++)
+{
+REQUIRE(clampedPoints[i] == points[i]);
+}
+
+soaringPen::clampPoints(clampedPoints.data(), clampedPoints.size(), soaringPen::fPoint(.5, notANumber), soaringPen::fPoint(notANumber, 4.0));
+for(int i=0; i<points.size(); i++)
+{
+REQUIRE(clampedPoints[i].val[0] == fmax(points[i].val[0], .5));
+REQUIRE(clampedPoints[i].val[1] == fmin(points[i].val[1], 4.0));
+}
+}
+REQUIRE(soaringPen::setBatchGeometryInstructionSet(defaultInstructionSet));
+}
+
+TEST_CASE("Test geofence zones", "[geofence]")
+{
+//Square with an interior point and a colinear edge point that shouldn't end up in the hull
+soaringPen::convexZone square({soaringPen::fPoint(0.0, 0.0), soaringPen::fPoint(1.0, 0.0), soaringPen::fPoint(.5, 0.0), soaringPen::fPoint(1.0, 1.0), soaringPen::fPoint(.5, .5), soaringPen::fPoint(0.0, 1.0)});
+REQUIRE(square.hull.size() == 4);
+REQUIRE(square.contains(soaringPen::fPoint(.2, .9)));
+REQUIRE(square.contains(soaringPen::fPoint(1.0, .5)));
+REQUIRE(!square.contains(soaringPen::fPoint(1.1, .5)));
+REQUIRE(square.intersects(soaringPen::fPoint(-1.0, .5), soaringPen::fPoint(2.0, .7)));
+REQUIRE(!square.intersects(soaringPen::fPoint(-1.0, .5), soaringPen::fPoint(-.1, 2.0)));
+REQUIRE(!square.intersects(soaringPen::fPoint(1.5, -1.0), soaringPen::fPoint(3.0, 2.0)));
+REQUIRE_THROWS(soaringPen::convexZone({soaringPen::fPoint(0.0, 0.0), soaringPen::fPoint(1.0, 1.0), soaringPen::fPoint(2.0, 2.0)}));
+
+soaringPen::geofence fence;
+fence.addKeepInZone({soaringPen::fPoint(-2.0, -2.0), soaringPen::fPoint(2.0, -2.0), soaringPen::fPoint(2.0, 2.0), soaringPen::fPoint(-2.0, 2.0)});
+fence.addKeepOutZone(square.hull);
+
+soaringPen::linearPath path;
+path.addPoint(soaringPen::fPoint(-1.0, -1.0));
+path.addPoint(soaringPen::fPoint(-1.0, 1.5));
+REQUIRE(fence.findFirstViolation(path) == -1);
+path.addPoint(soaringPen::fPoint(1.5, .5)); //Cuts through the keep-out zone
+REQUIRE(fence.findFirstViolation(path) == 2);
+REQUIRE(!fence.isAllowed(soaringPen::fPoint(3.0, 0.0)));
+
+//Zones read from a file's text
+std::istringstream zoneText("# Field boundary\nkeepIn -2 -2 2 -2 2 2 -2 2\n\nkeepOut 0 0 1 0 1 1 0 1\n");
+soaringPen::geofence readFence;
+readFence.readZones(zoneText);
+REQUIRE(readFence.keepInZones.size() == 1);
+REQUIRE(readFence.keepOutZones.size() == 1);
+REQUIRE(readFence.findFirstViolation(path) == 2);
+
+std::istringstream badZoneText("keepOut 0 0 1 0 1\n");
+REQUIRE_THROWS(readFence.readZones(badZoneText));
+std::istringstream unknownZoneText("keepNear 0 0 1 0 1 1\n");
+REQUIRE_THROWS(readFence.readZones(unknownZoneText));
+REQUIRE_THROWS(readFence.readZonesFromFile("/nonexistent/geofence.txt"));
+}
+
+TEST_CASE("Test follow path command encoding", "[pathEncoding]")
+{
+soaringPen::linearPath path;
+for(int i=0; i<200; i++)
+{
+double angle = i*2*PI/200;
+path.addPoint(soaringPen::fPoint(.4*cos(angle), .3*sin(angle) - .2));
+}
+
+soaringPen::follow_path_command plainCommand;
+soaringPen::encodePath(path, plainCommand);
+REQUIRE(soaringPen::decodePath(plainCommand).points == path.points);
+
+soaringPen::follow_path_command quantizedCommand;
+soaringPen::encodeQuantizedPath(path, soaringPen::DEFAULT_PATH_QUANTIZATION_RESOLUTION, quantizedCommand);
+soaringPen::linearPath decodedPath = soaringPen::decodePath(quantizedCommand);
+REQUIRE(decodedPath.points.size() == path.points.size());
+for(int i=0; i<path.points.size(); i++)
+{
+REQUIRE(decodedPath.points[i].distance(path.points[i]) <= soaringPen::DEFAULT_PATH_QUANTIZATION_RESOLUTION);
+}
+
+//Compact form should be much smaller
+REQUIRE(quantizedCommand.ByteSizeLong()*4 < plainCommand.ByteSizeLong());
+
+REQUIRE_THROWS(soaringPen::encodeQuantizedPath(path, 0.0, quantizedCommand));
+quantizedCommand.add_quantized_path_x_deltas(1);
+REQUIRE_THROWS(soaringPen::decodePath(quantizedCommand));
+}
+
+TEST_CASE("Test command scheduler", "[commandScheduler]")
+{
+soaringPen::commandScheduler scheduler;
+std::vector<int> dispatchedPathSizes;
+int numberOfEmergencyStops = 0;
+
+scheduler.registerHandler(soaringPen::follow_path_command::kFollowPathCommandFieldFieldNumber, [&](const soaringPen::command_message &inputCommand)
+{
+dispatchedPathSizes.push_back(inputCommand.GetExtension(soaringPen::follow_path_command::follow_path_command_field).path_x_coordinates_size());
+});
+
+//Path size is used to tell the commands apart
+auto makePathCommand = [](int inputPriority, int inputPathSize)
+{
+soaringPen::command_message command;
+command.set_priority(inputPriority);
+for(int i=0; i<inputPathSize; i++)
+{
+command.MutableExtension(soaringPen::follow_path_command::follow_path_command_field)->add_path_x_coordinates(i);
+}
+return command;
+};
+
+soaringPen::command_message emergencyStop;
+emergencyStop.MutableExtension(soaringPen::emergency_stop_command::emergency_stop_command_field)->set_stop(true);
+REQUIRE_THROWS(scheduler.enqueue(emergencyStop)); //No handler yet
+
+scheduler.enqueue(makePathCommand(1, 1));
+scheduler.enqueue(makePathCommand(5, 2));
+scheduler.enqueue(makePathCommand(5, 3));
+REQUIRE(scheduler.dispatchAll() == 3);
+REQUIRE(dispatchedPathSizes == std::vector<int>({2, 3, 1}));
+
+scheduler.registerHandler(soaringPen::emergency_stop_command::kEmergencyStopCommandFieldFieldNumber, [&](const soaringPen::command_message &inputCommand)
+{
+numberOfEmergencyStops++;
+});
+
+//Emergency stop discards the waiting commands and goes first
+scheduler.enqueue(makePathCommand(100, 4));
+scheduler.enqueue(makePathCommand(100, 5));
+scheduler.enqueue(emergencyStop);
+scheduler.enqueue(makePathCommand(100, 6));
+REQUIRE(scheduler.preemptionRequested());
+REQUIRE(scheduler.size() == 2);
+REQUIRE(scheduler.dispatchNext());
+REQUIRE(numberOfEmergencyStops == 1);
+REQUIRE(!scheduler.preemptionRequested());
+REQUIRE(scheduler.dispatchAll() == 1);
+REQUIRE(dispatchedPathSizes.back() == 6);
+
+soaringPen::commandSchedulerLatencyStatistics statistics = scheduler.getLatencyStatistics();
+REQUIRE(statistics.numberOfDispatchedCommands == 5);
+REQUIRE(statistics.numberOfPreemptedCommands == 2);
+REQUIRE(statistics.maximumLatency >= statistics.meanLatency);
+REQUIRE(statistics.numberOfFailedCommands == 0);
+
+//A handler throwing (such as for a malformed path) is counted, but doesn't stop the commands after it
+int numberOfDecodedPaths = 0;
+scheduler.registerHandler(soaringPen::follow_path_command::kFollowPathCommandFieldFieldNumber, [&](const soaringPen::command_message &inputCommand)
+{
+soaringPen::decodePath(inputCommand.GetExtension(soaringPen::follow_path_command::follow_path_command_field));
+numberOfDecodedPaths++;
+});
+scheduler.enqueue(makePathCommand(1, 3)); //X coordinates without Y coordinates
+soaringPen::linearPath validPath;
+validPath.addPoint(soaringPen::fPoint(0.0, 0.0));
+validPath.addPoint(soaringPen::fPoint(.1, .1));
+soaringPen::command_message validPathCommand;
+soaringPen::encodePath(validPath, *validPathCommand.MutableExtension(soaringPen::follow_path_command::follow_path_command_field));
+scheduler.enqueue(validPathCommand);
+REQUIRE(scheduler.dispatchAll() == 2);
+REQUIRE(numberOfDecodedPaths == 1);
+REQUIRE(scheduler.getLatencyStatistics().numberOfFailedCommands == 1);
+}
+
+TEST_CASE("Test telemetry batching", "[telemetryBatcher]")
+{
+soaringPen::telemetryBatcher batcher(4);
+soaringPen::controller_status_update statusUpdate;
+REQUIRE(!batcher.flush(statusUpdate));
+REQUIRE(soaringPen::getTelemetryPositions(statusUpdate).size() == 0);
+
+for(int i=0; i<4; i++)
+{
+batcher.addSample(1000000 + i*10000, soaringPen::fPoint(.1*i, -.1*i), soaringPen::fPoint(i, 2*i));
+}
+REQUIRE(batcher.isFull());
+REQUIRE_THROWS(batcher.addSample(0, soaringPen::fPoint(), soaringPen::fPoint())); //Before the first sample
+
+REQUIRE(batcher.flush(statusUpdate));
+REQUIRE(batcher.size() == 0);
+REQUIRE(statusUpdate.telemetry_batch_field().first_sample_time() == 1000000);
+REQUIRE(statusUpdate.telemetry_batch_field().sample_time_offsets(3) == 30000);
+REQUIRE(statusUpdate.x_position() == Approx(.3)); //Latest sample for GUIs that don't use batches
+
+std::vector<soaringPen::fPoint> positions = soaringPen::getTelemetryPositions(statusUpdate);
+std::vector<soaringPen::fPoint> velocities = soaringPen::getTelemetryVelocities(statusUpdate);
+REQUIRE(positions.size() == 4);
+REQUIRE(velocities.size() == 4);
+REQUIRE(positions[2] == soaringPen::fPoint(.1*2, -.1*2));
+REQUIRE(velocities[3] == soaringPen::fPoint(3, 6));
+
+//Single sample updates are still understood
+soaringPen::controller_status_update singleSampleUpdate;
+singleSampleUpdate.set_x_position(.5);
+singleSampleUpdate.set_y_position(.25);
+REQUIRE(soaringPen::getTelemetryPositions(singleSampleUpdate) == std::vector<soaringPen::fPoint>({soaringPen::fPoint(.5, .25)}));
+
+statusUpdate.mutable_telemetry_batch_field()->add_x_positions(1.0);
+REQUIRE_THROWS(soaringPen::getTelemetryPositions(statusUpdate));
+}
+
+TEST_CASE("Test latest value buffer", "[latestValueBuffer]")
+{
+soaringPen::latestValueBuffer<std::pair<int64_t, int64_t> > buffer;
+std::pair<int64_t, int64_t> value(-1, -1);
+REQUIRE(!buffer.consume(value));
+
+buffer.publish(std::pair<int64_t, int64_t>(1, -1));
+buffer.publish(std::pair<int64_t, int64_t>(2, -2));
+REQUIRE(buffer.consume(value));
+REQUIRE(value.first == 2); //Only the latest is kept
+REQUIRE(!buffer.consume(value));
+
+//Values should never be torn or go backwards when published from another thread
+const int64_t numberOfValues = 200000;
+std::thread producer([&]()
+{
+for(int64_t i=3; i<=numberOfValues; i++)
+{
+buffer.publish(std::pair<int64_t, int64_t>(i, -i));
+}
+});
+
+int64_t lastValue = 2;
+bool valuesConsistent = true;
+while(lastValue < numberOfValues)
+{
+if(buffer.consume(value))
+{
+valuesConsistent = valuesConsistent && value.first > lastValue && value.second == -value.first;
+lastValue = value.first;
+}
+}
+producer.join();
+REQUIRE(valuesConsistent);
+}
+
+TEST_CASE("Test link quality monitor", "[linkQualityMonitor]")
+{
+soaringPen::linkQualityMonitor monitor(1.0, 4);
+
+//Controller clock is 5 seconds ahead, 10 ms each way on the network and 1 ms in the controller
+auto respond = [](soaringPen::link_probe inputProbe, int64_t inputOneWayDelay)
+{
+inputProbe.set_receive_time(inputProbe.origin_time() + inputOneWayDelay + 5000000);
+inputProbe.set_transmit_time(inputProbe.receive_time() + 1000);
+return inputProbe;
+};
+
+soaringPen::link_probe probe = monitor.createProbe(0);
+REQUIRE(monitor.processResponse(respond(probe, 10000), 21000));
+REQUIRE(!monitor.processResponse(respond(probe, 10000), 21000)); //Duplicate
+
+const soaringPen::linkQualityStatistics &statistics = monitor.getStatistics();
+REQUIRE(statistics.roundTripTime == Approx(.02));
+REQUIRE(statistics.clockOffset == Approx(5.0));
+REQUIRE(monitor.controllerTimeToLocalTime(5000000) == 0);
+
+//Asymmetric delay on a slower probe shouldn't move the offset estimate
+probe = monitor.createProbe(100000);
+REQUIRE(monitor.processResponse(respond(probe, 50000), 100000 + 50000 + 1000 + 10000));
+REQUIRE(statistics.roundTripTime == Approx(.06));
+REQUIRE(statistics.clockOffset == Approx(5.0));
+REQUIRE(statistics.minimumRoundTripTime == Approx(.02));
+
+//Unanswered probes are lost after the timeout
+probe = monitor.createProbe(200000);
+monitor.expireProbes(1000000);
+REQUIRE(statistics.numberOfLostProbes == 0);
+monitor.expireProbes(1300000);
+REQUIRE(statistics.numberOfLostProbes == 1);
+REQUIRE(statistics.lossFraction == Approx(1.0/3.0));
+REQUIRE(!monitor.processResponse(respond(probe, 10000), 1400000)); //Too late
+
+probe.clear_receive_time();
+REQUIRE_THROWS(monitor.processResponse(probe, 0));
+}
+
+TEST_CASE("Test ZMQ endpoint normalization", "[utilityFunctions]")
+{
+REQUIRE(pylongps::normalizeZMQConnectionEndpoint("127.0.0.1:9001") == "tcp://127.0.0.1:9001");
+REQUIRE(pylongps::normalizeZMQConnectionEndpoint("ipc:///tmp/soaringPenVideo") == "ipc:///tmp/soaringPenVideo");
+REQUIRE(pylongps::normalizeZMQBindEndpoint("9001") == "tcp://*:9001");
+REQUIRE(pylongps::normalizeZMQBindEndpoint("inproc://soaringPenVideo") == "inproc://soaringPenVideo");
+REQUIRE_THROWS(pylongps::normalizeZMQBindEndpoint("udp://127.0.0.1:9001"));
+REQUIRE_THROWS(pylongps::normalizeZMQConnectionEndpoint(""));
+}
+
+TEST_CASE("Test shared memory frame ring", "[sharedMemoryFrameRing]")
+{
+REQUIRE(soaringPen::sharedMemoryFrameRingName("shm://soaringPenVideo") == "/soaringPenVideo");
+REQUIRE_THROWS(soaringPen::sharedMemoryFrameRingName("tcp://127.0.0.1:9001"));
+
+std::string ringName = "/soaringPenUnitTest" + std::to_string(getpid());
+soaringPen::sharedMemoryFrameRing publisher(ringName, 2, 64);
+soaringPen::sharedMemoryFrameRing subscriber(ringName);
+REQUIRE(subscriber.latestFrameNumber() == 0);
+REQUIRE(subscriber.slotSize() == 64);
+
+std::vector<unsigned char> frame(48, 7);
+soaringPen::sharedMemoryFrameInformation information;
+information.width = 4;
+information.height = 4;
+information.step = 12;
+REQUIRE(publisher.publish(frame.data(), frame.size(), information) == 1);
+REQUIRE(subscriber.latestFrameNumber() == 1);
+
+soaringPen::sharedMemoryFrameView view;
+REQUIRE(subscriber.beginRead(1, view));
+REQUIRE(view.size == 48);
+REQUIRE(view.information.width == 4);
+REQUIRE(std::vector<unsigned char>(view.data, view.data + view.size) == frame);
+REQUIRE(subscriber.endRead(view));
+
+//Overwriting the slot while it is being read invalidates the read
+publisher.publish(frame.data(), frame.size(), information);
+REQUIRE(subscriber.beginRead(1, view));
+publisher.publish(frame.data(), frame.size(), information);
+REQUIRE(!subscriber.endRead(view));
+REQUIRE(!subscriber.beginRead(1, view));
+
+REQUIRE_THROWS(publisher.publish(frame.data(), 65, information)); //Too big
+REQUIRE_THROWS(soaringPen::sharedMemoryFrameRing(ringName + "Missing"));
+}
+
+TEST_CASE("Test asynchronous remote procedure calls", "[asynchronousRemoteProcedureCallClient]")
+{
+zmq::context_t context;
+zmq::socket_t serverSocket(context, ZMQ_ROUTER);
+zmq::socket_t clientSocket(context, ZMQ_DEALER);
+serverSocket.bind("inproc://remoteProcedureCallUnitTest");
+clientSocket.connect("inproc://remoteProcedureCallUnitTest");
+
+pylongps::asynchronousRemoteProcedureCallClient client(clientSocket);
+
+soaringPen::link_probe request;
+request.set_sequence_number(1);
+std::future<soaringPen::link_probe> firstReply = client.call<soaringPen::link_probe>(request, 10.0);
+
+request.set_sequence_number(2);
+std::vector<std::tuple<pylongps::remoteProcedureCallStatus, uint64_t> > callbackResults;
+auto callback = [&](pylongps::remoteProcedureCallStatus inputStatus, const soaringPen::link_probe &inputReply)
+{
+callbackResults.emplace_back(inputStatus, inputReply.sequence_number());
+};
+client.call<soaringPen::link_probe>(request, 10.0, callback);
+
+request.set_sequence_number(3);
+client.call<soaringPen::link_probe>(request, 0.0, callback); //Never answered
+REQUIRE(client.numberOfOutstandingCalls() == 3);
+REQUIRE(client.timeUntilNextDeadline() >= 0);
+
+//Answer the first two requests in reverse order, echoing the envelope and correlation ID
+std::vector<std::vector<std::string> > requests;
+for(int requestIndex = 0; requestIndex < 3; requestIndex++)
+{
+std::vector<std::string> frames;
+zmq::message_t frame;
+do
+{
+serverSocket.recv(&frame);
+frames.emplace_back((const char *) frame.data(), frame.size());
+}
+while(frame.more());
+requests.push_back(frames);
+}
+
+for(int requestIndex = 1; requestIndex >= 0; requestIndex--)
+{
+std::vector<std::string> &frames = requests[requestIndex];
+soaringPen::link_probe reply;
+REQUIRE(reply.ParseFromString(frames.back().substr(pylongps::RPC_CORRELATION_ID_SIZE)));
+reply.set_receive_time(reply.sequence_number()*10);
+
+for(int frameIndex = 0; frameIndex + 1 < frames.size(); frameIndex++)
+{
+serverSocket.send(frames[frameIndex].c_str(), frames[frameIndex].size(), ZMQ_SNDMORE);
+}
+pylongps::sendProtobufMessage(serverSocket, reply, frames.back().substr(0, pylongps::RPC_CORRELATION_ID_SIZE));
+}
+
+int numberOfCallsCompleted = 0;
+while(numberOfCallsCompleted < 3)
+{
+numberOfCallsCompleted += client.processReplies(true);
+}
+REQUIRE(client.numberOfOutstandingCalls() == 0);
+REQUIRE(client.timeUntilNextDeadline() == -1);
+
+REQUIRE(firstReply.get().receive_time() == 10);
+REQUIRE(callbackResults.size() == 2);
+REQUIRE(std::get<0>(callbackResults[0]) == pylongps::RPC_REPLY_RECEIVED);
+REQUIRE(std::get<1>(callbackResults[0]) == 2);
+REQUIRE(std::get<0>(callbackResults[1]) == pylongps::RPC_TIMED_OUT);
+
+//Timed out futures throw
+std::future<soaringPen::link_probe> timedOutReply = client.call<soaringPen::link_probe>(request, 0.0);
+REQUIRE(client.expireCalls() == 1);
+REQUIRE_THROWS(timedOutReply.get());
+
+//Waiting for a reply the server never sends returns once the call's deadline has passed
+callbackResults.clear();
+client.call<soaringPen::link_probe>(request, .05, callback);
+REQUIRE(client.processReplies(true) == 1);
+REQUIRE(callbackResults.size() == 1);
+REQUIRE(std::get<0>(callbackResults[0]) == pylongps::RPC_TIMED_OUT);
+}
+
+TEST_CASE("Benchmark emergency stop latency", "[emergencyStopChannel]")
+{
+const int numberOfStops = 100;
+const double maximumMeanLatency = .002; //Seconds, which the 1 ms command loop turnaround alone would use half of
+const double maximumLatency = .05; //Seconds, generous for loaded test machines
+
+zmq::context_t context;
+std::atomic<int> numberOfStopsHandled{0};
+soaringPen::emergencyStopReceiver receiver(context, "inproc://emergencyStopUnitTest", [&](bool inputStop)
+{
+numberOfStopsHandled++;
+});
+soaringPen::emergencyStopSender sender(context, "inproc://emergencyStopUnitTest");
+
+for(int stopIndex = 0; stopIndex < numberOfStops; stopIndex++)
+{
+uint64_t sequenceNumber = sender.sendStop(stopIndex % 2 == 0);
+REQUIRE(sender.waitForAcknowledgement(sequenceNumber, 1.0));
+}
+
+soaringPen::emergencyStopLatencyStatistics statistics = sender.getLatencyStatistics();
+REQUIRE(statistics.numberOfAcknowledgedStops == numberOfStops);
+REQUIRE(numberOfStopsHandled == numberOfStops);
+REQUIRE(!receiver.stopActive);
+REQUIRE(statistics.meanLatency < maximumMeanLatency);
+REQUIRE(statistics.maximumLatency < maximumLatency);
+}
+
+TEST_CASE("Test emergency stops from a restarted GUI", "[emergencyStopChannel]")
+{
+zmq::context_t context;
+std::atomic<int> numberOfStopsHandled{0};
+soaringPen::emergencyStopReceiver receiver(context, "inproc://emergencyStopRestartUnitTest", [&](bool inputStop)
+{
+numberOfStopsHandled++;
+});
+
+{
+soaringPen::emergencyStopSender firstSender(context, "inproc://emergencyStopRestartUnitTest");
+uint64_t sequenceNumber = firstSender.sendStop(false);
+REQUIRE(firstSender.waitForAcknowledgement(sequenceNumber, 1.0));
+}
+REQUIRE(numberOfStopsHandled == 1);
+
+//The new sender's first stop has the same sequence number as the last one handled, but must still be acted on
+soaringPen::emergencyStopSender secondSender(context, "inproc://emergencyStopRestartUnitTest");
+uint64_t sequenceNumber = secondSender.sendStop(true);
+REQUIRE(sequenceNumber == 1);
+REQUIRE(secondSender.waitForAcknowledgement(sequenceNumber, 1.0));
+REQUIRE(numberOfStopsHandled == 2);
+REQUIRE(receiver.stopActive);
+}
+
+TEST_CASE("Test video relay", "[videoRelay]")
+{
+zmq::context_t context;
+zmq::socket_t sourceSocket(context, ZMQ_PUB);
+sourceSocket.bind("inproc://videoRelayUnitTestSource");
+
+soaringPen::videoRelay relay(context, "inproc://videoRelayUnitTestSource", "inproc://videoRelayUnitTestSubscribers", 0.0, 0.0);
+std::thread relayThread([&]()
+{
+try
+{
+relay.run();
+}
+catch(const std::exception &inputException)
+{
+fprintf(stderr, "Error: %s\n", inputException.what());
+}
+});
+SOMScopeGuard relayThreadGuard([&]()
+{ //Stop the relay even if a check fails
+relay.shutdown = true;
+relayThread.join();
+});
+
+//Returns an empty string if no frame arrives within the timeout (milliseconds)
+auto receiveFrame = [](zmq::socket_t &inputSocket, long inputTimeout)
+{
+zmq::pollitem_t pollItem = {(void *) inputSocket, 0, ZMQ_POLLIN, 0};
+if(zmq::poll(&pollItem, 1, inputTimeout) == 0)
+{
+return std::string();
+}
+
+zmq::message_t frame;
+inputSocket.recv(&frame);
+return std::string((const char *) frame.data(), frame.size());
+};
+
+zmq::socket_t firstViewer(context, ZMQ_SUB);
+firstViewer.setsockopt(ZMQ_SUBSCRIBE, nullptr, 0);
+firstViewer.connect("inproc://videoRelayUnitTestSubscribers");
+
+//Keep publishing until the subscription has made it through the relay to the source
+std::string frame;
+for(int attempt = 0; attempt < 500 && frame.size() == 0; attempt++)
+{
+sourceSocket.send("frame1", 6);
+frame = receiveFrame(firstViewer, 10);
+}
+REQUIRE(frame == "frame1");
+
+sourceSocket.send("frame2", 6);
+do
+{
+frame = receiveFrame(firstViewer, 1000);
+}
+while(frame == "frame1");
+REQUIRE(frame == "frame2");
+
+//A late joiner gets the last frame right away, without the current viewers getting it again
+zmq::socket_t secondViewer(context, ZMQ_SUB);
+secondViewer.setsockopt(ZMQ_SUBSCRIBE, nullptr, 0);
+secondViewer.connect("inproc://videoRelayUnitTestSubscribers");
+REQUIRE(receiveFrame(secondViewer, 1000) == "frame2");
+REQUIRE(receiveFrame(firstViewer, 100) == "");
+
+sourceSocket.send("frame3", 6);
+REQUIRE(receiveFrame(firstViewer, 1000) == "frame3");
+REQUIRE(receiveFrame(secondViewer, 1000) == "frame3");
+REQUIRE(relay.numberOfFramesRelayed >= 3);
+}
+
+TEST_CASE("Test video relay cached frame interval", "[videoRelay]")
+{
+zmq::context_t context;
+zmq::socket_t sourceSocket(context, ZMQ_PUB);
+sourceSocket.bind("inproc://videoRelayIntervalUnitTestSource");
+
+//The cached frame is only updated every 1000 seconds, so late joiners get the first frame
+soaringPen::videoRelay relay(context, "inproc://videoRelayIntervalUnitTestSource", "inproc://videoRelayIntervalUnitTestSubscribers", 0.0, 1000.0);
+std::thread relayThread([&]()
+{
+try
+{
+relay.run();
+}
+catch(const std::exception &inputException)
+{
+fprintf(stderr, "Error: %s\n", inputException.what());
+}
+});
+SOMScopeGuard relayThreadGuard([&]()
+{ //Stop the relay even if a check fails
+relay.shutdown = true;
+relayThread.join();
+});
+
+auto receiveFrame = [](zmq::socket_t &inputSocket, long inputTimeout)
+{
+zmq::pollitem_t pollItem = {(void *) inputSocket, 0, ZMQ_POLLIN, 0};
+if(zmq::poll(&pollItem, 1, inputTimeout) == 0)
+{
+return std::string();
+}
+
+zmq::message_t frame;
+inputSocket.recv(&frame);
+return std::string((const char *) frame.data(), frame.size());
+};
+
+zmq::socket_t firstViewer(context, ZMQ_SUB);
+firstViewer.setsockopt(ZMQ_SUBSCRIBE, nullptr, 0);
+firstViewer.connect("inproc://videoRelayIntervalUnitTestSubscribers");
+
+std::string frame;
+for(int attempt = 0; attempt < 500 && frame.size() == 0; attempt++)
+{
+sourceSocket.send("frame1", 6);
+frame = receiveFrame(firstViewer, 10);
+}
+REQUIRE(frame == "frame1");
+
+sourceSocket.send("frame2", 6);
+do
+{
+frame = receiveFrame(firstViewer, 1000);
+}
+while(frame == "frame1");
+REQUIRE(frame == "frame2");
+
+zmq::socket_t secondViewer(context, ZMQ_SUB);
+secondViewer.setsockopt(ZMQ_SUBSCRIBE, nullptr, 0);
+secondViewer.connect("inproc://videoRelayIntervalUnitTestSubscribers");
+REQUIRE(receiveFrame(secondViewer, 1000) == "frame1");
+REQUIRE(receiveFrame(firstViewer, 100) == "");
+}
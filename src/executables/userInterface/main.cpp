@@ -1,18 +1,42 @@
 #include "userInterface.hpp"
+#include "dummyController.hpp"
 #include<cstdio>
 #include<QApplication>
 #include "SOMException.hpp"
+#include "SOMScopeGuard.hpp"
 #include<memory>
+#include<thread>
+#include<vector>
+#include<string>
 
 using namespace soaringPen;
 
+const std::string ALL_IN_ONE_COMMAND_ENDPOINT = "inproc://soaringPenCommands";
+const std::string ALL_IN_ONE_VIDEO_ENDPOINT = "inproc://soaringPenVideo";
+const std::string ALL_IN_ONE_EMERGENCY_STOP_ENDPOINT = "inproc://soaringPenEmergencyStop";
+
 int main(int argc, char **argv)
 {
 QApplication app(argc, argv);
 
-if(argc < 3)
+//Pull out the options, leaving the positional arguments
+std::vector<std::string> arguments;
+std::string geofenceFileName;
+for(int argumentIndex = 1; argumentIndex < argc; argumentIndex++)
+{
+if(std::string(argv[argumentIndex]) == "--geofence" && (argumentIndex + 1) < argc)
+{
+geofenceFileName = argv[argumentIndex + 1];
+argumentIndex++;
+continue;
+}
+arguments.push_back(argv[argumentIndex]);
+}
+
+if(arguments.size() < 2)
 {
-fprintf(stderr, "Error, missing arguments\nUsage: %s 'ipOfController:portNumberOfController' 'ipOfVideoSource:portNumberOfVideoSource'", argv[0]);
+fprintf(stderr, "Error, missing arguments\nUsage: %s [--geofence zoneFile] 'ipOfController:portNumberOfController' 'ipOfVideoSource:portNumberOfVideoSource' ['ipOfController:portNumberOfEmergencyStopInterface']\n(full ZMQ endpoints such as ipc:///tmp/soaringPenVideo can be used instead, as can shm://name for the video of a controller on the same host)\nor: %s [--geofence zoneFile] --all-in-one videoDeviceNumber (runs the dummy controller in this process over inproc)\nZone files have a line per zone: keepIn or keepOut followed by x y pairs in normalized image coordinates\n", argv[0], argv[0]);
+return 1;
 }
 
 std::unique_ptr<zmq::context_t> context;
@@ -21,11 +45,62 @@ SOM_TRY
 context.reset(new zmq::context_t);
 SOM_CATCH("Error initializing context\n");
 
+std::string controllerPairInterfaceURI = arguments[0];
+std::string controllerVideoPublishingURI = arguments[1];
+std::string controllerEmergencyStopURI = arguments.size() > 2 ? arguments[2] : "";
+
+//Run the controller on a thread in this process if requested, so nothing goes through the network stack
+std::unique_ptr<dummyController> controller;
+std::thread controllerThread;
+SOMScopeGuard controllerThreadGuard([&]()
+{ //Stop the controller thread however main exits (such as the user interface failing to start), since destroying a joinable thread terminates the program
+if(controllerThread.joinable())
+{
+controller->shutdown = true;
+controllerThread.join();
+}
+});
+if(controllerPairInterfaceURI == "--all-in-one")
+{
+int videoDeviceNumber = 0;
+SOM_TRY
+videoDeviceNumber = std::stol(controllerVideoPublishingURI);
+SOM_CATCH("Error, unable to read video device number\n")
+
+SOM_TRY //Binds before the GUI connects
+controller.reset(new dummyController(*context, videoDeviceNumber, ALL_IN_ONE_COMMAND_ENDPOINT, ALL_IN_ONE_VIDEO_ENDPOINT, false, ALL_IN_ONE_EMERGENCY_STOP_ENDPOINT));
+SOM_CATCH("Error, unable to initialize controller\n")
+
+controllerThread = std::thread([&]()
+{
+try
+{
+controller->run();
+}
+catch(const std::exception &inputException)
+{
+fprintf(stderr, "Controller error: %s\n", inputException.what());
+}
+});
+
+controllerPairInterfaceURI = ALL_IN_ONE_COMMAND_ENDPOINT;
+controllerVideoPublishingURI = ALL_IN_ONE_VIDEO_ENDPOINT;
+controllerEmergencyStopURI = ALL_IN_ONE_EMERGENCY_STOP_ENDPOINT;
+}
+
 std::unique_ptr<userInterface> myUserInterface;
 
+try
+{ //Return rather than letting the exception escape main, so the controller thread guard gets to run
 SOM_TRY
-myUserInterface.reset(new userInterface(*context, std::string(argv[1]), std::string(argv[2]) ));
+myUserInterface.reset(new userInterface(*context, controllerPairInterfaceURI, controllerVideoPublishingURI, controllerEmergencyStopURI, geofenceFileName));
 SOM_CATCH("Error, unable to initialize user interface\n")
+}
+catch(const std::exception &inputException)
+{
+fprintf(stderr, "Error: %s\n", inputException.what());
+return 1;
+}
 
 myUserInterface->show();
 
@@ -0,0 +1,47 @@
+#include<cstdio>
+#include<string>
+#include "SOMException.hpp"
+#include<zmq.hpp>
+#include<memory>
+#include "videoRelay.hpp"
+
+//Relay which receives the video stream once and fans it out to any number of GUIs/recorders
+int main(int argc, char **argv)
+{
+
+if(argc < 3)
+{
+fprintf(stderr, "Error, incorrect number of arguments.  \nUsage: videoSourceEndpoint subscriberEndpointToBind [statisticsIntervalInSeconds]\n(endpoints can be IP:port/port numbers or full ZMQ endpoints such as ipc:///tmp/soaringPenVideo)\n");
+return 1;
+}
+
+double statisticsInterval = soaringPen::DEFAULT_VIDEO_RELAY_STATISTICS_INTERVAL;
+if(argc > 3)
+{
+SOM_TRY
+statisticsInterval = std::stod(std::string(argv[3]));
+SOM_CATCH("Error, unable to read statistics interval\n")
+}
+
+//Create ZMQ context
+std::unique_ptr<zmq::context_t> context;
+
+SOM_TRY
+context.reset(new zmq::context_t);
+SOM_CATCH("Error initializing context\n")
+
+std::unique_ptr<soaringPen::videoRelay> relay;
+
+try
+{
+relay.reset(new soaringPen::videoRelay(*context, std::string(argv[1]), std::string(argv[2]), statisticsInterval));
+relay->run();
+}
+catch(const std::exception &inputException)
+{
+fprintf(stderr, "Error: %s\n", inputException.what());
+return 1;
+}
+
+return 0;
+}
@@ -0,0 +1,199 @@
+#include "asynchronousRemoteProcedureCallClient.hpp"
+
+using namespace pylongps;
+
+/**
+This function initializes the client to use the given socket.
+@param inputDealerSocket: The connected ZMQ DEALER socket to send requests and receive replies with (must outlive the client and only be used by it)
+*/
+asynchronousRemoteProcedureCallClient::asynchronousRemoteProcedureCallClient(zmq::socket_t &inputDealerSocket) : socket(&inputDealerSocket)
+{
+}
+
+/**
+This function receives the replies waiting on the socket (completing their calls) and then times out any calls which have passed their deadlines.
+@param inputWaitForFirstReply: True if the function should block until a message arrives or the next outstanding call's deadline passes (it doesn't block if there are no outstanding calls)
+@return: The number of calls completed (including timed out ones)
+
+@throws: This function can throw exceptions
+*/
+int asynchronousRemoteProcedureCallClient::processReplies(bool inputWaitForFirstReply)
+{
+int numberOfCallsCompleted = 0;
+
+long pollTimeout = timeUntilNextDeadline();
+if(inputWaitForFirstReply && pollTimeout != 0 && pollTimeout != -1)
+{ //Wait for a reply, but no longer than it takes for a call to time out, so an unresponsive server can't block this forever
+zmq::pollitem_t pollItem = {(void *) (*socket), 0, ZMQ_POLLIN, 0};
+SOM_TRY
+zmq::poll(&pollItem, 1, pollTimeout);
+SOM_CATCH("Error waiting for remote procedure call reply\n")
+}
+
+while(true)
+{
+bool messageReceived = false;
+SOM_TRY
+messageReceived = socket->recv(&messageBuffer, ZMQ_DONTWAIT);
+SOM_CATCH("Error receiving remote procedure call reply\n")
+
+if(!messageReceived)
+{
+break;
+}
+
+//Skip the delimiter (and anything else the server put in the envelope) to get to the reply frame
+while(messageBuffer.more())
+{
+SOM_TRY
+socket->recv(&messageBuffer);
+SOM_CATCH("Error receiving remote procedure call reply\n")
+}
+
+if(messageBuffer.size() < RPC_CORRELATION_ID_SIZE)
+{ //Not a reply to anything
+continue;
+}
+
+uint64_t correlationID = 0;
+memcpy((void *) &correlationID, messageBuffer.data(), RPC_CORRELATION_ID_SIZE);
+
+auto callIterator = outstandingCalls.find(correlationID);
+if(callIterator == outstandingCalls.end())
+{ //Reply to a call which has already timed out
+continue;
+}
+
+replyHandler handler = callIterator->second.second;
+callDeadlines.erase(std::make_pair(callIterator->second.first, correlationID));
+outstandingCalls.erase(callIterator);
+
+handler(RPC_REPLY_RECEIVED, ((const char *) messageBuffer.data()) + RPC_CORRELATION_ID_SIZE, messageBuffer.size() - RPC_CORRELATION_ID_SIZE);
+numberOfCallsCompleted++;
+}
+
+return numberOfCallsCompleted + expireCalls();
+}
+
+/**
+This function times out any calls which have passed their deadlines.
+@return: The number of calls timed out
+*/
+int asynchronousRemoteProcedureCallClient::expireCalls()
+{
+std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+int numberOfCallsExpired = 0;
+
+while(callDeadlines.size() > 0 && callDeadlines.begin()->first <= now)
+{
+uint64_t correlationID = callDeadlines.begin()->second;
+callDeadlines.erase(callDeadlines.begin());
+
+auto callIterator = outstandingCalls.find(correlationID);
+if(callIterator == outstandingCalls.end())
+{
+continue;
+}
+
+replyHandler handler = callIterator->second.second;
+outstandingCalls.erase(callIterator);
+
+handler(RPC_TIMED_OUT, nullptr, 0);
+numberOfCallsExpired++;
+}
+
+return numberOfCallsExpired;
+}
+
+/**
+This function returns the number of calls waiting for replies.
+@return: The number of outstanding calls
+*/
+int asynchronousRemoteProcedureCallClient::numberOfOutstandingCalls() const
+{
+return outstandingCalls.size();
+}
+
+/**
+This function returns how long it will be until the next outstanding call times out, which is the longest it is useful to poll the socket for before calling processReplies.
+@return: Milliseconds until the next deadline (0 if one has passed, -1 if there are no outstanding calls)
+*/
+long asynchronousRemoteProcedureCallClient::timeUntilNextDeadline() const
+{
+if(callDeadlines.size() == 0)
+{
+return -1;
+}
+
+long millisecondsUntilDeadline = std::chrono::duration_cast<std::chrono::milliseconds>(callDeadlines.begin()->first - std::chrono::steady_clock::now()).count();
+
+//Round up so a poll using it doesn't return just before the deadline
+return std::max(millisecondsUntilDeadline + 1, 0L);
+}
+
+/**
+This function converts a call status to a string for error messages.
+@param inputStatus: The status to convert
+@return: The status as a string
+*/
+std::string asynchronousRemoteProcedureCallClient::remoteProcedureCallStatusToString(remoteProcedureCallStatus inputStatus)
+{
+switch(inputStatus)
+{
+case RPC_REPLY_RECEIVED:
+return "reply received";
+case RPC_INVALID_REPLY:
+return "invalid reply";
+case RPC_TIMED_OUT:
+return "timed out";
+case RPC_SEND_FAILED:
+return "unable to send request";
+}
+
+return "unknown status";
+}
+
+/**
+This function sends a request with a new correlation ID and registers the handler for its reply.
+@param inputRequest: The request object to send
+@param inputTimeout: How long (seconds) to wait for the reply
+@param inputHandler: The function to call with the reply's status and serialized reply (called immediately with RPC_SEND_FAILED if the request can't be sent)
+
+@throws: This function can throw exceptions (such as if the request is missing required fields)
+*/
+void asynchronousRemoteProcedureCallClient::sendRequest(const google::protobuf::Message &inputRequest, double inputTimeout, const replyHandler &inputHandler)
+{
+if(!inputRequest.IsInitialized())
+{
+throw SOMException("Remote procedure call request is missing required fields\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+if(inputTimeout < 0.0)
+{
+throw SOMException("Remote procedure call timeout is negative\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+uint64_t correlationID = nextCorrelationID;
+nextCorrelationID++;
+
+//ZMQ queues multipart messages atomically, so once the delimiter is accepted the request frame will be too
+bool requestSent = false;
+SOM_TRY
+zmq::message_t delimiter;
+if(socket->send(delimiter, ZMQ_SNDMORE | ZMQ_DONTWAIT))
+{
+requestSent = trySendProtobufMessage(*socket, inputRequest, ZMQ_DONTWAIT, (const char *) &correlationID, RPC_CORRELATION_ID_SIZE);
+}
+SOM_CATCH("Error sending remote procedure call request\n")
+
+if(!requestSent)
+{
+inputHandler(RPC_SEND_FAILED, nullptr, 0);
+return;
+}
+
+std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(inputTimeout));
+
+outstandingCalls[correlationID] = std::make_pair(deadline, inputHandler);
+callDeadlines.insert(std::make_pair(deadline, correlationID));
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "zmq.hpp"
+#include "SOMException.hpp"
+#include "utilityFunctions.hpp"
+#include<map>
+#include<set>
+#include<chrono>
+#include<future>
+#include<memory>
+#include<functional>
+#include<cstring>
+#include<algorithm>
+#include<google/protobuf/message.h>
+
+namespace pylongps
+{
+
+enum remoteProcedureCallStatus
+{
+RPC_REPLY_RECEIVED,
+RPC_INVALID_REPLY, //The reply couldn't be deserialized
+RPC_TIMED_OUT, //No reply before the call's deadline
+RPC_SEND_FAILED //The request couldn't be sent without blocking
+};
+
+const int RPC_CORRELATION_ID_SIZE = sizeof(uint64_t);
+
+/**
+This class makes remote procedure calls over a ZMQ DEALER socket without waiting for each reply before sending the next request, so many calls can be in flight at once and none of them can hang forever.  Each request is sent as an empty delimiter frame followed by a frame holding an 8 byte correlation ID and then the serialized request object.  The server (a ROUTER, or a REP which receives/sends with the 8 byte ID as preappended data) must put the same ID in front of its reply, which is how replies are matched with calls regardless of the order they come back in.
+
+The client doesn't have a thread of its own: processReplies must be called (typically when the socket polls readable, with a poll timeout of at most timeUntilNextDeadline) to receive replies, complete their calls and time out calls that have passed their deadlines.  Calls complete by invoking their callback or by setting their future, so a future should only be waited on from a different thread than the one calling processReplies.
+*/
+class asynchronousRemoteProcedureCallClient
+{
+public:
+/**
+This function initializes the client to use the given socket.
+@param inputDealerSocket: The connected ZMQ DEALER socket to send requests and receive replies with (must outlive the client and only be used by it)
+*/
+asynchronousRemoteProcedureCallClient(zmq::socket_t &inputDealerSocket);
+
+/**
+This function sends a request and returns a future which is given the reply.
+@param inputRequest: The request object to send
+@param inputTimeout: How long (seconds) to wait for the reply
+@return: The future reply (which throws a SOMException if the call times out, the reply is invalid or the request couldn't be sent)
+
+@throws: This function can throw exceptions (such as if the request is missing required fields)
+*/
+template<class replyType> std::future<replyType> call(const google::protobuf::Message &inputRequest, double inputTimeout)
+{
+std::shared_ptr<std::promise<replyType> > promise = std::make_shared<std::promise<replyType> >();
+std::future<replyType> futureReply = promise->get_future();
+
+sendRequest(inputRequest, inputTimeout, [promise](remoteProcedureCallStatus inputStatus, const char *inputReplyData, int inputReplySize)
+{
+replyType reply;
+if(inputStatus == RPC_REPLY_RECEIVED && reply.ParseFromArray(inputReplyData, inputReplySize))
+{
+promise->set_value(reply);
+return;
+}
+
+promise->set_exception(std::make_exception_ptr(SOMException(std::string("Remote procedure call failed: ") + remoteProcedureCallStatusToString(inputStatus == RPC_REPLY_RECEIVED ? RPC_INVALID_REPLY : inputStatus) + "\n", SERVER_REQUEST_FAILED, __FILE__, __LINE__)));
+});
+
+return futureReply;
+}
+
+/**
+This function sends a request and invokes the callback (from processReplies, or immediately if the request can't be sent) with the reply.
+@param inputRequest: The request object to send
+@param inputTimeout: How long (seconds) to wait for the reply
+@param inputCallback: The function to call with the status and the reply (the reply is only valid if the status is RPC_REPLY_RECEIVED)
+
+@throws: This function can throw exceptions (such as if the request is missing required fields)
+*/
+template<class replyType> void call(const google::protobuf::Message &inputRequest, double inputTimeout, const std::function<void(remoteProcedureCallStatus, const replyType &)> &inputCallback)
+{
+sendRequest(inputRequest, inputTimeout, [inputCallback](remoteProcedureCallStatus inputStatus, const char *inputReplyData, int inputReplySize)
+{
+replyType reply;
+if(inputStatus == RPC_REPLY_RECEIVED && !reply.ParseFromArray(inputReplyData, inputReplySize))
+{
+inputStatus = RPC_INVALID_REPLY;
+}
+
+inputCallback(inputStatus, reply);
+});
+}
+
+/**
+This function receives the replies waiting on the socket (completing their calls) and then times out any calls which have passed their deadlines.
+@param inputWaitForFirstReply: True if the function should block until a message arrives or the next outstanding call's deadline passes (it doesn't block if there are no outstanding calls)
+@return: The number of calls completed (including timed out ones)
+
+@throws: This function can throw exceptions
+*/
+int processReplies(bool inputWaitForFirstReply = false);
+
+/**
+This function times out any calls which have passed their deadlines.
+@return: The number of calls timed out
+*/
+int expireCalls();
+
+/**
+This function returns the number of calls waiting for replies.
+@return: The number of outstanding calls
+*/
+int numberOfOutstandingCalls() const;
+
+/**
+This function returns how long it will be until the next outstanding call times out, which is the longest it is useful to poll the socket for before calling processReplies.
+@return: Milliseconds until the next deadline (0 if one has passed, -1 if there are no outstanding calls)
+*/
+long timeUntilNextDeadline() const;
+
+/**
+This function converts a call status to a string for error messages.
+@param inputStatus: The status to convert
+@return: The status as a string
+*/
+static std::string remoteProcedureCallStatusToString(remoteProcedureCallStatus inputStatus);
+
+zmq::socket_t *socket;
+
+protected:
+typedef std::function<void(remoteProcedureCallStatus, const char *, int)> replyHandler;
+
+/**
+This function sends a request with a new correlation ID and registers the handler for its reply.
+@param inputRequest: The request object to send
+@param inputTimeout: How long (seconds) to wait for the reply
+@param inputHandler: The function to call with the reply's status and serialized reply (called immediately with RPC_SEND_FAILED if the request can't be sent)
+
+@throws: This function can throw exceptions (such as if the request is missing required fields)
+*/
+void sendRequest(const google::protobuf::Message &inputRequest, double inputTimeout, const replyHandler &inputHandler);
+
+uint64_t nextCorrelationID = 1;
+std::map<uint64_t, std::pair<std::chrono::steady_clock::time_point, replyHandler> > outstandingCalls; //Correlation ID -> <deadline, handler>
+std::set<std::pair<std::chrono::steady_clock::time_point, uint64_t> > callDeadlines; //Ordered so that expired calls can be found without a scan
+zmq::message_t messageBuffer; //Reused for each received frame
+};
+
+}
@@ -0,0 +1,387 @@
+#include "batchGeometry.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include<immintrin.h>
+#define SOARING_PEN_BATCH_GEOMETRY_X86
+#endif
+
+using namespace soaringPen;
+
+//The batch functions treat an array of points as a flat array of interleaved x/y doubles
+static_assert(sizeof(fPoint) == 2*sizeof(double), "fPoint must be two tightly packed doubles for the batch geometry functions");
+static_assert(std::is_standard_layout<fPoint>::value, "fPoint must be standard layout for the batch geometry functions");
+
+namespace
+{
+
+/**
+This function is the scalar implementation of affineTransformPoints (see the header for details).
+*/
+void affineTransformPointsScalar(const fPoint *inputPoints, int inputNumberOfPoints, const double inputMatrix[4], const fPoint &inputOffset, fPoint *outputPoints)
+{
+for(int i=0; i<inputNumberOfPoints; i++)
+{
+double x = inputPoints[i].val[0];
+double y = inputPoints[i].val[1];
+outputPoints[i].val[0] = inputMatrix[0]*x + inputMatrix[1]*y + inputOffset.val[0];
+outputPoints[i].val[1] = inputMatrix[2]*x + inputMatrix[3]*y + inputOffset.val[1];
+}
+}
+
+/**
+This function is the scalar implementation of computeCumulativeLengths (see the header for details).
+*/
+void computeCumulativeLengthsScalar(const fPoint *inputPoints, int inputNumberOfPoints, double *outputCumulativeLengths)
+{
+if(inputNumberOfPoints <= 0)
+{
+return;
+}
+
+outputCumulativeLengths[0] = 0.0;
+for(int i=1; i<inputNumberOfPoints; i++)
+{
+double xDifference = inputPoints[i].val[0] - inputPoints[i-1].val[0];
+double yDifference = inputPoints[i].val[1] - inputPoints[i-1].val[1];
+outputCumulativeLengths[i] = outputCumulativeLengths[i-1] + sqrt(xDifference*xDifference + yDifference*yDifference);
+}
+}
+
+/**
+This function is the scalar implementation of clampPoints (see the header for details).
+*/
+void clampPointsScalar(fPoint *inputOutputPoints, int inputNumberOfPoints, const fPoint &inputMinimum, const fPoint &inputMaximum)
+{
+for(int i=0; i<inputNumberOfPoints; i++)
+{
+for(int dimension=0; dimension<2; dimension++)
+{
+inputOutputPoints[i].val[dimension] = fmin(fmax(inputOutputPoints[i].val[dimension], inputMinimum.val[dimension]), inputMaximum.val[dimension]);
+}
+}
+}
+
+/**
+This function is the scalar implementation of lerpPoints (see the header for details).
+*/
+void lerpPointsScalar(const fPoint *inputStartPoints, const fPoint *inputEndPoints, const double *inputRatios, int inputNumberOfPoints, fPoint *outputPoints)
+{
+for(int i=0; i<inputNumberOfPoints; i++)
+{
+for(int dimension=0; dimension<2; dimension++)
+{
+outputPoints[i].val[dimension] = inputStartPoints[i].val[dimension] + inputRatios[i]*(inputEndPoints[i].val[dimension] - inputStartPoints[i].val[dimension]);
+}
+}
+}
+
+#ifdef SOARING_PEN_BATCH_GEOMETRY_X86
+//SSE2 versions (one point per register)
+
+void affineTransformPointsSSE2(const fPoint *inputPoints, int inputNumberOfPoints, const double inputMatrix[4], const fPoint &inputOffset, fPoint *outputPoints)
+{
+//output = (xx, yx)*x + (xy, yy)*y + offset
+__m128d xColumn = _mm_set_pd(inputMatrix[2], inputMatrix[0]);
+__m128d yColumn = _mm_set_pd(inputMatrix[3], inputMatrix[1]);
+__m128d offset = _mm_loadu_pd(inputOffset.val);
+
+for(int i=0; i<inputNumberOfPoints; i++)
+{
+__m128d point = _mm_loadu_pd(inputPoints[i].val);
+__m128d x = _mm_unpacklo_pd(point, point);
+__m128d y = _mm_unpackhi_pd(point, point);
+_mm_storeu_pd(outputPoints[i].val, _mm_add_pd(_mm_add_pd(_mm_mul_pd(xColumn, x), _mm_mul_pd(yColumn, y)), offset));
+}
+}
+
+void computeCumulativeLengthsSSE2(const fPoint *inputPoints, int inputNumberOfPoints, double *outputCumulativeLengths)
+{
+if(inputNumberOfPoints <= 0)
+{
+return;
+}
+
+//Compute two segment lengths at a time, then do the (serial) running sum
+outputCumulativeLengths[0] = 0.0;
+const double *coordinates = inputPoints[0].val;
+int i=1;
+for(; i+1<inputNumberOfPoints; i+=2)
+{ //Segments ending at points i and i+1
+__m128d previous0 = _mm_loadu_pd(coordinates + 2*(i-1));
+__m128d current0 = _mm_loadu_pd(coordinates + 2*i);
+__m128d current1 = _mm_loadu_pd(coordinates + 2*(i+1));
+__m128d difference0 = _mm_sub_pd(current0, previous0);
+__m128d difference1 = _mm_sub_pd(current1, current0);
+__m128d xDifferences = _mm_unpacklo_pd(difference0, difference1);
+__m128d yDifferences = _mm_unpackhi_pd(difference0, difference1);
+__m128d lengths = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(xDifferences, xDifferences), _mm_mul_pd(yDifferences, yDifferences)));
+
+double lengthBuffer[2];
+_mm_storeu_pd(lengthBuffer, lengths);
+outputCumulativeLengths[i] = outputCumulativeLengths[i-1] + lengthBuffer[0];
+outputCumulativeLengths[i+1] = outputCumulativeLengths[i] + lengthBuffer[1];
+}
+
+for(; i<inputNumberOfPoints; i++)
+{
+double xDifference = inputPoints[i].val[0] - inputPoints[i-1].val[0];
+double yDifference = inputPoints[i].val[1] - inputPoints[i-1].val[1];
+outputCumulativeLengths[i] = outputCumulativeLengths[i-1] + sqrt(xDifference*xDifference + yDifference*yDifference);
+}
+}
+
+void clampPointsSSE2(fPoint *inputOutputPoints, int inputNumberOfPoints, const fPoint &inputMinimum, const fPoint &inputMaximum)
+{
+__m128d minimum = _mm_loadu_pd(inputMinimum.val);
+__m128d maximum = _mm_loadu_pd(inputMaximum.val);
+
+for(int i=0; i<inputNumberOfPoints; i++)
+{
+__m128d point = _mm_loadu_pd(inputOutputPoints[i].val);
+//The point goes second, since maxpd/minpd return the second operand if either is NaN (matching fmax/fmin, which ignore NaN bounds)
+_mm_storeu_pd(inputOutputPoints[i].val, _mm_min_pd(maximum, _mm_max_pd(minimum, point)));
+}
+}
+
+void lerpPointsSSE2(const fPoint *inputStartPoints, const fPoint *inputEndPoints, const double *inputRatios, int inputNumberOfPoints, fPoint *outputPoints)
+{
+for(int i=0; i<inputNumberOfPoints; i++)
+{
+__m128d start = _mm_loadu_pd(inputStartPoints[i].val);
+__m128d end = _mm_loadu_pd(inputEndPoints[i].val);
+__m128d ratio = _mm_set1_pd(inputRatios[i]);
+_mm_storeu_pd(outputPoints[i].val, _mm_add_pd(start, _mm_mul_pd(ratio, _mm_sub_pd(end, start))));
+}
+}
+
+//AVX2 versions (two points per register).  These are compiled for AVX2 regardless of the build flags and are only called if the processor reports support.
+
+__attribute__((target("avx2"))) void affineTransformPointsAVX2(const fPoint *inputPoints, int inputNumberOfPoints, const double inputMatrix[4], const fPoint &inputOffset, fPoint *outputPoints)
+{
+__m256d xColumn = _mm256_set_pd(inputMatrix[2], inputMatrix[0], inputMatrix[2], inputMatrix[0]);
+__m256d yColumn = _mm256_set_pd(inputMatrix[3], inputMatrix[1], inputMatrix[3], inputMatrix[1]);
+__m256d offset = _mm256_set_pd(inputOffset.val[1], inputOffset.val[0], inputOffset.val[1], inputOffset.val[0]);
+
+int i=0;
+for(; i+1<inputNumberOfPoints; i+=2)
+{
+__m256d points = _mm256_loadu_pd(inputPoints[i].val);
+__m256d x = _mm256_unpacklo_pd(points, points);
+__m256d y = _mm256_unpackhi_pd(points, points);
+_mm256_storeu_pd(outputPoints[i].val, _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(xColumn, x), _mm256_mul_pd(yColumn, y)), offset));
+}
+
+affineTransformPointsSSE2(inputPoints + i, inputNumberOfPoints - i, inputMatrix, inputOffset, outputPoints + i);
+}
+
+__attribute__((target("avx2"))) void computeCumulativeLengthsAVX2(const fPoint *inputPoints, int inputNumberOfPoints, double *outputCumulativeLengths)
+{
+if(inputNumberOfPoints <= 0)
+{
+return;
+}
+
+//Compute four segment lengths at a time, then do the (serial) running sum
+outputCumulativeLengths[0] = 0.0;
+const double *coordinates = inputPoints[0].val;
+int i=1;
+for(; i+3<inputNumberOfPoints; i+=4)
+{ //Segments ending at points i through i+3
+__m256d previous01 = _mm256_loadu_pd(coordinates + 2*(i-1));
+__m256d current01 = _mm256_loadu_pd(coordinates + 2*i);
+__m256d previous23 = _mm256_loadu_pd(coordinates + 2*(i+1));
+__m256d current23 = _mm256_loadu_pd(coordinates + 2*(i+2));
+__m256d difference01 = _mm256_sub_pd(current01, previous01); //(dx0, dy0, dx1, dy1)
+__m256d difference23 = _mm256_sub_pd(current23, previous23); //(dx2, dy2, dx3, dy3)
+__m256d xDifferences = _mm256_unpacklo_pd(difference01, difference23); //(dx0, dx2, dx1, dx3)
+__m256d yDifferences = _mm256_unpackhi_pd(difference01, difference23);
+__m256d lengths = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(xDifferences, xDifferences), _mm256_mul_pd(yDifferences, yDifferences)));
+
+double lengthBuffer[4];
+_mm256_storeu_pd(lengthBuffer, lengths);
+outputCumulativeLengths[i] = outputCumulativeLengths[i-1] + lengthBuffer[0];
+outputCumulativeLengths[i+1] = outputCumulativeLengths[i] + lengthBuffer[2];
+outputCumulativeLengths[i+2] = outputCumulativeLengths[i+1] + lengthBuffer[1];
+outputCumulativeLengths[i+3] = outputCumulativeLengths[i+2] + lengthBuffer[3];
+}
+
+for(; i<inputNumberOfPoints; i++)
+{
+double xDifference = inputPoints[i].val[0] - inputPoints[i-1].val[0];
+double yDifference = inputPoints[i].val[1] - inputPoints[i-1].val[1];
+outputCumulativeLengths[i] = outputCumulativeLengths[i-1] + sqrt(xDifference*xDifference + yDifference*yDifference);
+}
+}
+
+__attribute__((target("avx2"))) void clampPointsAVX2(fPoint *inputOutputPoints, int inputNumberOfPoints, const fPoint &inputMinimum, const fPoint &inputMaximum)
+{
+__m256d minimum = _mm256_set_pd(inputMinimum.val[1], inputMinimum.val[0], inputMinimum.val[1], inputMinimum.val[0]);
+__m256d maximum = _mm256_set_pd(inputMaximum.val[1], inputMaximum.val[0], inputMaximum.val[1], inputMaximum.val[0]);
+
+int i=0;
+for(; i+1<inputNumberOfPoints; i+=2)
+{
+__m256d points = _mm256_loadu_pd(inputOutputPoints[i].val);
+_mm256_storeu_pd(inputOutputPoints[i].val, _mm256_min_pd(maximum, _mm256_max_pd(minimum, points))); //Point second, as in the SSE2 version
+}
+
+clampPointsSSE2(inputOutputPoints + i, inputNumberOfPoints - i, inputMinimum, inputMaximum);
+}
+
+__attribute__((target("avx2"))) void lerpPointsAVX2(const fPoint *inputStartPoints, const fPoint *inputEndPoints, const double *inputRatios, int inputNumberOfPoints, fPoint *outputPoints)
+{
+int i=0;
+for(; i+1<inputNumberOfPoints; i+=2)
+{
+__m256d start = _mm256_loadu_pd(inputStartPoints[i].val);
+__m256d end = _mm256_loadu_pd(inputEndPoints[i].val);
+__m256d ratios = _mm256_set_pd(inputRatios[i+1], inputRatios[i+1], inputRatios[i], inputRatios[i]);
+_mm256_storeu_pd(outputPoints[i].val, _mm256_add_pd(start, _mm256_mul_pd(ratios, _mm256_sub_pd(end, start))));
+}
+
+lerpPointsSSE2(inputStartPoints + i, inputEndPoints + i, inputRatios + i, inputNumberOfPoints - i, outputPoints + i);
+}
+#endif
+
+/**
+This struct holds the implementations of the batch functions that are best suited to the processor the program is running on.
+*/
+struct batchGeometryImplementation
+{
+batchGeometryImplementation()
+{
+if(!select("AVX2"))
+{
+select("SSE2");
+}
+}
+
+/**
+This function switches to the given instruction set's implementations if the processor supports it.
+@param inputInstructionSet: "AVX2", "SSE2" or "scalar"
+@return: true if the implementations were switched
+*/
+bool select(const std::string &inputInstructionSet)
+{
+if(inputInstructionSet == "scalar")
+{
+instructionSet = "scalar";
+affineTransform = &affineTransformPointsScalar;
+cumulativeLengths = &computeCumulativeLengthsScalar;
+clamp = &clampPointsScalar;
+lerp = &lerpPointsScalar;
+return true;
+}
+
+#ifdef SOARING_PEN_BATCH_GEOMETRY_X86
+__builtin_cpu_init();
+if(inputInstructionSet == "AVX2" && __builtin_cpu_supports("avx2"))
+{
+instructionSet = "AVX2";
+affineTransform = &affineTransformPointsAVX2;
+cumulativeLengths = &computeCumulativeLengthsAVX2;
+clamp = &clampPointsAVX2;
+lerp = &lerpPointsAVX2;
+return true;
+}
+
+if(inputInstructionSet == "SSE2" && __builtin_cpu_supports("sse2"))
+{
+instructionSet = "SSE2";
+affineTransform = &affineTransformPointsSSE2;
+cumulativeLengths = &computeCumulativeLengthsSSE2;
+clamp = &clampPointsSSE2;
+lerp = &lerpPointsSSE2;
+return true;
+}
+#endif
+
+return false;
+}
+
+const char *instructionSet = "scalar";
+void (*affineTransform)(const fPoint *, int, const double [4], const fPoint &, fPoint *) = &affineTransformPointsScalar;
+void (*cumulativeLengths)(const fPoint *, int, double *) = &computeCumulativeLengthsScalar;
+void (*clamp)(fPoint *, int, const fPoint &, const fPoint &) = &clampPointsScalar;
+void (*lerp)(const fPoint *, const fPoint *, const double *, int, fPoint *) = &lerpPointsScalar;
+};
+
+/**
+This function returns the implementation selected for this processor (selected on first use).
+@return: The implementation to use
+*/
+batchGeometryImplementation &getBatchGeometryImplementation()
+{
+static batchGeometryImplementation implementation;
+return implementation;
+}
+
+}
+
+/**
+This function applies the affine transform output = matrix*input + offset to an array of points.  SSE2/AVX2 versions are selected at runtime when the processor supports them.
+@param inputPoints: The array of points to transform
+@param inputNumberOfPoints: The number of points in the array
+@param inputMatrix: The 2x2 transform matrix in row major order (xx, xy, yx, yy)
+@param inputOffset: The offset to add after multiplying by the matrix
+@param outputPoints: The array (of size inputNumberOfPoints) to store the result in (can be the same as inputPoints)
+*/
+void soaringPen::affineTransformPoints(const fPoint *inputPoints, int inputNumberOfPoints, const double inputMatrix[4], const fPoint &inputOffset, fPoint *outputPoints)
+{
+getBatchGeometryImplementation().affineTransform(inputPoints, inputNumberOfPoints, inputMatrix, inputOffset, outputPoints);
+}
+
+/**
+This function computes the cumulative distance along an array of points (output[0] = 0, output[i] = output[i-1] + distance from point i-1 to point i).  SSE2/AVX2 versions are selected at runtime when the processor supports them.
+@param inputPoints: The array of points
+@param inputNumberOfPoints: The number of points in the array
+@param outputCumulativeLengths: The array (of size inputNumberOfPoints) to store the cumulative lengths in
+*/
+void soaringPen::computeCumulativeLengths(const fPoint *inputPoints, int inputNumberOfPoints, double *outputCumulativeLengths)
+{
+getBatchGeometryImplementation().cumulativeLengths(inputPoints, inputNumberOfPoints, outputCumulativeLengths);
+}
+
+/**
+This function limits each coordinate of an array of points to be within the given bounds (such as the edges of an image).  As with fmin/fmax, a NaN bound leaves the coordinate unchanged.  SSE2/AVX2 versions are selected at runtime when the processor supports them.
+@param inputOutputPoints: The array of points to clamp (modified in place)
+@param inputNumberOfPoints: The number of points in the array
+@param inputMinimum: The smallest permitted x and y values
+@param inputMaximum: The largest permitted x and y values
+*/
+void soaringPen::clampPoints(fPoint *inputOutputPoints, int inputNumberOfPoints, const fPoint &inputMinimum, const fPoint &inputMaximum)
+{
+getBatchGeometryImplementation().clamp(inputOutputPoints, inputNumberOfPoints, inputMinimum, inputMaximum);
+}
+
+/**
+This function linearly interpolates between two arrays of points (output[i] = start[i] + ratio[i]*(end[i] - start[i])).  SSE2/AVX2 versions are selected at runtime when the processor supports them.
+@param inputStartPoints: The points to interpolate from
+@param inputEndPoints: The points to interpolate to
+@param inputRatios: How far from the start point to the end point each output should be (0.0 to 1.0)
+@param inputNumberOfPoints: The number of points in each array
+@param outputPoints: The array (of size inputNumberOfPoints) to store the interpolated points in
+*/
+void soaringPen::lerpPoints(const fPoint *inputStartPoints, const fPoint *inputEndPoints, const double *inputRatios, int inputNumberOfPoints, fPoint *outputPoints)
+{
+getBatchGeometryImplementation().lerp(inputStartPoints, inputEndPoints, inputRatios, inputNumberOfPoints, outputPoints);
+}
+
+/**
+This function returns the name of the instruction set the batch geometry functions are using on this processor ("AVX2", "SSE2" or "scalar").
+@return: The instruction set name
+*/
+const char *soaringPen::batchGeometryInstructionSet()
+{
+return getBatchGeometryImplementation().instructionSet;
+}
+
+/**
+This function overrides the instruction set the batch geometry functions use, such as to compare the implementations in tests or benchmarks.  It must not be called while other threads are using the batch geometry functions.
+@param inputInstructionSet: "AVX2", "SSE2" or "scalar"
+@return: true if the processor supports the instruction set (otherwise the current one is kept)
+*/
+bool soaringPen::setBatchGeometryInstructionSet(const std::string &inputInstructionSet)
+{
+return getBatchGeometryImplementation().select(inputInstructionSet);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "fPoint.hpp"
+#include<cmath>
+#include<string>
+
+namespace soaringPen
+{
+
+/**
+This function applies the affine transform output = matrix*input + offset to an array of points.  SSE2/AVX2 versions are selected at runtime when the processor supports them.
+@param inputPoints: The array of points to transform
+@param inputNumberOfPoints: The number of points in the array
+@param inputMatrix: The 2x2 transform matrix in row major order (xx, xy, yx, yy)
+@param inputOffset: The offset to add after multiplying by the matrix
+@param outputPoints: The array (of size inputNumberOfPoints) to store the result in (can be the same as inputPoints)
+*/
+void affineTransformPoints(const fPoint *inputPoints, int inputNumberOfPoints, const double inputMatrix[4], const fPoint &inputOffset, fPoint *outputPoints);
+
+/**
+This function computes the cumulative distance along an array of points (output[0] = 0, output[i] = output[i-1] + distance from point i-1 to point i).  SSE2/AVX2 versions are selected at runtime when the processor supports them.
+@param inputPoints: The array of points
+@param inputNumberOfPoints: The number of points in the array
+@param outputCumulativeLengths: The array (of size inputNumberOfPoints) to store the cumulative lengths in
+*/
+void computeCumulativeLengths(const fPoint *inputPoints, int inputNumberOfPoints, double *outputCumulativeLengths);
+
+/**
+This function computes the cumulative distance along an array of points of any type (see the fPoint overload for details).  This is the scalar version used for points without a SIMD implementation.
+@param inputPoints: The array of points
+@param inputNumberOfPoints: The number of points in the array
+@param outputCumulativeLengths: The array (of size inputNumberOfPoints) to store the cumulative lengths in
+*/
+template<class pointType> void computeCumulativeLengths(const pointType *inputPoints, int inputNumberOfPoints, typename pointType::valueType *outputCumulativeLengths)
+{
+if(inputNumberOfPoints <= 0)
+{
+return;
+}
+
+outputCumulativeLengths[0] = 0.0;
+for(int i=1; i<inputNumberOfPoints; i++)
+{
+outputCumulativeLengths[i] = outputCumulativeLengths[i-1] + (inputPoints[i] - inputPoints[i-1]).mag();
+}
+}
+
+/**
+This function limits each coordinate of an array of points to be within the given bounds (such as the edges of an image).  As with fmin/fmax, a NaN bound leaves the coordinate unchanged.  SSE2/AVX2 versions are selected at runtime when the processor supports them.
+@param inputOutputPoints: The array of points to clamp (modified in place)
+@param inputNumberOfPoints: The number of points in the array
+@param inputMinimum: The smallest permitted x and y values
+@param inputMaximum: The largest permitted x and y values
+*/
+void clampPoints(fPoint *inputOutputPoints, int inputNumberOfPoints, const fPoint &inputMinimum, const fPoint &inputMaximum);
+
+/**
+This function linearly interpolates between two arrays of points (output[i] = start[i] + ratio[i]*(end[i] - start[i])).  SSE2/AVX2 versions are selected at runtime when the processor supports them.
+@param inputStartPoints: The points to interpolate from
+@param inputEndPoints: The points to interpolate to
+@param inputRatios: How far from the start point to the end point each output should be (0.0 to 1.0)
+@param inputNumberOfPoints: The number of points in each array
+@param outputPoints: The array (of size inputNumberOfPoints) to store the interpolated points in
+*/
+void lerpPoints(const fPoint *inputStartPoints, const fPoint *inputEndPoints, const double *inputRatios, int inputNumberOfPoints, fPoint *outputPoints);
+
+/**
+This function returns the name of the instruction set the batch geometry functions are using on this processor ("AVX2", "SSE2" or "scalar").
+@return: The instruction set name
+*/
+const char *batchGeometryInstructionSet();
+
+/**
+This function overrides the instruction set the batch geometry functions use, such as to compare the implementations in tests or benchmarks.  It must not be called while other threads are using the batch geometry functions.
+@param inputInstructionSet: "AVX2", "SSE2" or "scalar"
+@return: true if the processor supports the instruction set (otherwise the current one is kept)
+*/
+bool setBatchGeometryInstructionSet(const std::string &inputInstructionSet);
+
+}
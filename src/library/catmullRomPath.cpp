@@ -0,0 +1,209 @@
+#include "catmullRomPath.hpp"
+
+using namespace soaringPen;
+
+/**
+This function builds the spline through the points of the given path.  Consecutive duplicate points are ignored.
+@param inputPath: The path whose points the spline should pass through
+@param inputNumberOfSamplesPerSegment: How many entries each segment gets in the path length table (more gives a more accurate path length parameterization)
+
+@throws: This function can throw exceptions
+*/
+template<class pointType> basicCatmullRomPath<pointType>::basicCatmullRomPath(const basicLinearPath<pointType> &inputPath, int inputNumberOfSamplesPerSegment) : numberOfSamplesPerSegment(inputNumberOfSamplesPerSegment)
+{
+if(inputNumberOfSamplesPerSegment < 1)
+{
+throw SOMException("Invalid number of samples per segment\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+//Drop duplicates, since they would make knot intervals of zero
+std::vector<pointType> controlPoints;
+for(const pointType &point : inputPath.points)
+{
+if(controlPoints.size() == 0 || !(point == controlPoints.back()))
+{
+controlPoints.push_back(point);
+}
+}
+
+if(controlPoints.size() < 2)
+{
+throw SOMException("Spline requires at least two distinct points\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+//Add phantom end points by reflection so the spline reaches the first and last points
+controlPoints.insert(controlPoints.begin(), 2.0*controlPoints[0] - controlPoints[1]);
+controlPoints.push_back(2.0*controlPoints[controlPoints.size()-1] - controlPoints[controlPoints.size()-2]);
+
+int numberOfSegments = controlPoints.size() - 3;
+coefficients.reserve(4*numberOfSegments);
+for(int i=0; i<numberOfSegments; i++)
+{
+const pointType &point0 = controlPoints[i];
+const pointType &point1 = controlPoints[i+1];
+const pointType &point2 = controlPoints[i+2];
+const pointType &point3 = controlPoints[i+3];
+
+//Centripetal knot intervals (square root of chord length)
+valueType interval01 = sqrt((point1 - point0).mag());
+valueType interval12 = sqrt((point2 - point1).mag());
+valueType interval23 = sqrt((point3 - point2).mag());
+
+//Tangents at point1 and point2, scaled to the segment's parameter range
+pointType tangent1 = ((point1 - point0)*(1.0/interval01) - (point2 - point0)*(1.0/(interval01 + interval12)) + (point2 - point1)*(1.0/interval12))*interval12;
+pointType tangent2 = ((point2 - point1)*(1.0/interval12) - (point3 - point1)*(1.0/(interval12 + interval23)) + (point3 - point2)*(1.0/interval23))*interval12;
+
+//Cubic Hermite form
+coefficients.push_back(2.0*point1 - 2.0*point2 + tangent1 + tangent2);
+coefficients.push_back(-3.0*point1 + 3.0*point2 - 2.0*tangent1 - tangent2);
+coefficients.push_back(tangent1);
+coefficients.push_back(point1);
+}
+
+//Build path length table from chords between closely spaced samples
+pathLengthTable.reserve(numberOfSegments*numberOfSamplesPerSegment + 1);
+pathLengthTable.push_back(0.0);
+pointType previousPoint = std::get<0>(evaluateSegment(0, 0.0));
+for(int segmentIndex = 0; segmentIndex < numberOfSegments; segmentIndex++)
+{
+for(int sampleIndex = 1; sampleIndex <= numberOfSamplesPerSegment; sampleIndex++)
+{
+pointType samplePoint = std::get<0>(evaluateSegment(segmentIndex, ((valueType) sampleIndex)/numberOfSamplesPerSegment));
+pathLengthTable.push_back(pathLengthTable.back() + (samplePoint - previousPoint).mag());
+previousPoint = samplePoint;
+}
+}
+
+pathLength = pathLengthTable.back();
+}
+
+/**
+This function returns the point on the spline at the given path length location.
+@param inputPathLengthLocation: The location along the path length (ranging from 0.0 to path length)
+@return: The associated point
+
+@throws: This function can throw exceptions
+*/
+template<class pointType> pointType basicCatmullRomPath<pointType>::interpolate(valueType inputPathLengthLocation) const
+{
+SOM_TRY
+return std::get<0>(evaluate(inputPathLengthLocation));
+SOM_CATCH("Error evaluating spline\n")
+}
+
+/**
+This function returns the normalized derivative (tangent) of the spline at the given path length location.
+@param inputPathLengthLocation: The location along the path length (ranging from 0.0 to path length)
+@return: The associated normalized derivative (x,y,etc)
+
+@throws: This function can throw exceptions
+*/
+template<class pointType> pointType basicCatmullRomPath<pointType>::derivative(valueType inputPathLengthLocation) const
+{
+SOM_TRY
+return std::get<1>(evaluate(inputPathLengthLocation));
+SOM_CATCH("Error evaluating spline\n")
+}
+
+/**
+This function returns the curvature (1/turn radius) of the spline at the given path length location.
+@param inputPathLengthLocation: The location along the path length (ranging from 0.0 to path length)
+@return: The curvature
+
+@throws: This function can throw exceptions
+*/
+template<class pointType> typename basicCatmullRomPath<pointType>::valueType basicCatmullRomPath<pointType>::curvature(valueType inputPathLengthLocation) const
+{
+SOM_TRY
+return std::get<2>(evaluate(inputPathLengthLocation));
+SOM_CATCH("Error evaluating spline\n")
+}
+
+/**
+This function returns the point, normalized derivative and curvature at the given path length location with a single table lookup.
+@param inputPathLengthLocation: The location along the path length (ranging from 0.0 to path length)
+@return: <point, normalized derivative, curvature>
+
+@throws: This function can throw exceptions
+*/
+template<class pointType> std::tuple<pointType, pointType, typename basicCatmullRomPath<pointType>::valueType> basicCatmullRomPath<pointType>::evaluate(valueType inputPathLengthLocation) const
+{
+int segmentIndex = 0;
+valueType parameter = 0.0;
+SOM_TRY
+std::tie(segmentIndex, parameter) = findSegmentParameter(inputPathLengthLocation);
+SOM_CATCH("Error finding spline segment\n")
+
+pointType point;
+pointType firstDerivative;
+pointType secondDerivative;
+std::tie(point, firstDerivative, secondDerivative) = evaluateSegment(segmentIndex, parameter);
+
+//Curvature = |r' x r''|/|r'|^3, with the cross product magnitude found from |r'|^2|r''|^2 - (r' . r'')^2 so it works in any dimension
+valueType speedSquared = dot(firstDerivative, firstDerivative);
+valueType crossSquared = speedSquared*dot(secondDerivative, secondDerivative) - pow(dot(firstDerivative, secondDerivative), 2);
+valueType speed = sqrt(speedSquared);
+valueType pointCurvature = speed > 0.0 ? sqrt(std::max<valueType>(crossSquared, 0.0))/(speedSquared*speed) : 0.0;
+
+firstDerivative.normalize();
+
+return std::tuple<pointType, pointType, valueType>(point, firstDerivative, pointCurvature);
+}
+
+/**
+This function finds the segment and polynomial parameter associated with a path length location using the path length table.
+@param inputPathLengthLocation: The location along the path length (ranging from 0.0 to path length)
+@return: <segment index, polynomial parameter (0.0 to 1.0)>
+
+@throws: This function can throw exceptions
+*/
+template<class pointType> std::tuple<int, typename basicCatmullRomPath<pointType>::valueType> basicCatmullRomPath<pointType>::findSegmentParameter(valueType inputPathLengthLocation) const
+{
+if(inputPathLengthLocation < 0.0)
+{
+throw SOMException("Negative path length\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+if(inputPathLengthLocation > pathLength)
+{
+throw SOMException("Path location could not be found\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+//First table entry at or after the location
+int tableIndex = std::lower_bound(pathLengthTable.begin() + 1, pathLengthTable.end(), inputPathLengthLocation) - pathLengthTable.begin();
+tableIndex = std::min<int>(tableIndex, pathLengthTable.size() - 1);
+
+//Linearly interpolate the parameter between the table entries
+valueType entryLength = pathLengthTable[tableIndex] - pathLengthTable[tableIndex-1];
+valueType entryRatio = entryLength > 0.0 ? (inputPathLengthLocation - pathLengthTable[tableIndex-1])/entryLength : 0.0;
+
+int segmentIndex = (tableIndex-1)/numberOfSamplesPerSegment;
+valueType parameter = (((tableIndex-1) % numberOfSamplesPerSegment) + entryRatio)/numberOfSamplesPerSegment;
+
+return std::tuple<int, valueType>(segmentIndex, parameter);
+}
+
+/**
+This function evaluates the segment polynomial and its first and second derivatives with respect to the polynomial parameter.
+@param inputSegmentIndex: The segment to evaluate
+@param inputParameter: The polynomial parameter (0.0 to 1.0)
+@return: <point, first derivative, second derivative>
+*/
+template<class pointType> std::tuple<pointType, pointType, pointType> basicCatmullRomPath<pointType>::evaluateSegment(int inputSegmentIndex, valueType inputParameter) const
+{
+const pointType &a = coefficients[4*inputSegmentIndex];
+const pointType &b = coefficients[4*inputSegmentIndex+1];
+const pointType &c = coefficients[4*inputSegmentIndex+2];
+const pointType &d = coefficients[4*inputSegmentIndex+3];
+valueType u = inputParameter;
+
+pointType point = ((a*u + b)*u + c)*u + d;
+pointType firstDerivative = (3.0*a*u + 2.0*b)*u + c;
+pointType secondDerivative = 6.0*a*u + 2.0*b;
+
+return std::tuple<pointType, pointType, pointType>(point, firstDerivative, secondDerivative);
+}
+
+//Instantiate the spline types used in the rest of the library
+template class soaringPen::basicCatmullRomPath<fPoint>;
+template class soaringPen::basicCatmullRomPath<fPoint3D>;
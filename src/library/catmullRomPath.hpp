@@ -0,0 +1,95 @@
+#pragma once
+
+#include "fPoint.hpp"
+#include "linearPath.hpp"
+#include<vector>
+#include<tuple>
+#include "SOMException.hpp"
+
+namespace soaringPen
+{
+
+/**
+This class represents a smooth path that passes through the points of a linearPath, using a centripetal Catmull-Rom spline (which avoids the loops and cusps of the uniform version).  Unlike linearPath, the tangent of the path is continuous at the points, so a drone following it does not have to make sudden heading changes.
+
+Each segment is stored as the coefficients of a cubic polynomial and a table of path lengths at evenly spaced polynomial parameter values is computed on construction.  Finding the position, tangent or curvature at a path length location is then a binary search of the table and a polynomial evaluation (no numeric integration is done per query).
+*/
+template<class pointType> class basicCatmullRomPath
+{
+public:
+typedef typename pointType::valueType valueType;
+
+/**
+This function builds the spline through the points of the given path.  Consecutive duplicate points are ignored.
+@param inputPath: The path whose points the spline should pass through
+@param inputNumberOfSamplesPerSegment: How many entries each segment gets in the path length table (more gives a more accurate path length parameterization)
+
+@throws: This function can throw exceptions
+*/
+basicCatmullRomPath(const basicLinearPath<pointType> &inputPath, int inputNumberOfSamplesPerSegment = 16);
+
+/**
+This function returns the point on the spline at the given path length location.
+@param inputPathLengthLocation: The location along the path length (ranging from 0.0 to path length)
+@return: The associated point
+
+@throws: This function can throw exceptions
+*/
+pointType interpolate(valueType inputPathLengthLocation) const;
+
+/**
+This function returns the normalized derivative (tangent) of the spline at the given path length location.
+@param inputPathLengthLocation: The location along the path length (ranging from 0.0 to path length)
+@return: The associated normalized derivative (x,y,etc)
+
+@throws: This function can throw exceptions
+*/
+pointType derivative(valueType inputPathLengthLocation) const;
+
+/**
+This function returns the curvature (1/turn radius) of the spline at the given path length location.
+@param inputPathLengthLocation: The location along the path length (ranging from 0.0 to path length)
+@return: The curvature
+
+@throws: This function can throw exceptions
+*/
+valueType curvature(valueType inputPathLengthLocation) const;
+
+/**
+This function returns the point, normalized derivative and curvature at the given path length location with a single table lookup.
+@param inputPathLengthLocation: The location along the path length (ranging from 0.0 to path length)
+@return: <point, normalized derivative, curvature>
+
+@throws: This function can throw exceptions
+*/
+std::tuple<pointType, pointType, valueType> evaluate(valueType inputPathLengthLocation) const;
+
+valueType pathLength = 0.0;
+int numberOfSamplesPerSegment;
+
+private:
+/**
+This function finds the segment and polynomial parameter associated with a path length location using the path length table.
+@param inputPathLengthLocation: The location along the path length (ranging from 0.0 to path length)
+@return: <segment index, polynomial parameter (0.0 to 1.0)>
+
+@throws: This function can throw exceptions
+*/
+std::tuple<int, valueType> findSegmentParameter(valueType inputPathLengthLocation) const;
+
+/**
+This function evaluates the segment polynomial and its first and second derivatives with respect to the polynomial parameter.
+@param inputSegmentIndex: The segment to evaluate
+@param inputParameter: The polynomial parameter (0.0 to 1.0)
+@return: <point, first derivative, second derivative>
+*/
+std::tuple<pointType, pointType, pointType> evaluateSegment(int inputSegmentIndex, valueType inputParameter) const;
+
+std::vector<pointType> coefficients; //4 per segment (a, b, c, d), with point = ((a*u + b)*u + c)*u + d
+std::vector<valueType> pathLengthTable; //numberOfSamplesPerSegment per segment plus one for the end, entry i is at segment i/numberOfSamplesPerSegment with u = (i%numberOfSamplesPerSegment)/numberOfSamplesPerSegment
+};
+
+typedef basicCatmullRomPath<fPoint> catmullRomPath;
+typedef basicCatmullRomPath<fPoint3D> catmullRomPath3D;
+
+}
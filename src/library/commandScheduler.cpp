@@ -0,0 +1,191 @@
+#include "commandScheduler.hpp"
+
+using namespace soaringPen;
+
+/**
+This function sets the handler to call for commands which have the given extension field set.
+@param inputExtensionFieldNumber: The field number of the command_message extension (such as emergency_stop_command::kEmergencyStopCommandFieldFieldNumber)
+@param inputHandler: The function to call with the command when it is dispatched
+*/
+void commandScheduler::registerHandler(int inputExtensionFieldNumber, const commandHandler &inputHandler)
+{
+std::lock_guard<std::mutex> lock(queueMutex);
+handlers[inputExtensionFieldNumber] = inputHandler;
+}
+
+/**
+This function adds a command to the queue.
+@param inputCommand: The command to add
+
+@throws: This function can throw exceptions (such as if the command has no handler registered for it)
+*/
+void commandScheduler::enqueue(const command_message &inputCommand)
+{
+queuedCommand commandToQueue;
+commandToQueue.enqueueTime = std::chrono::steady_clock::now();
+
+std::lock_guard<std::mutex> lock(queueMutex);
+
+commandToQueue.handlerFieldNumber = findHandlerFieldNumber(inputCommand);
+if(commandToQueue.handlerFieldNumber == 0)
+{
+throw SOMException("Command has no registered handler\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+bool isEmergencyStop = commandToQueue.handlerFieldNumber == emergency_stop_command::kEmergencyStopCommandFieldFieldNumber;
+if(isEmergencyStop)
+{ //Drop everything that was waiting so the stop is next and nothing queued before it runs afterwards
+latencyStatistics.numberOfPreemptedCommands += commandQueue.size() - numberOfPendingEmergencyStops;
+
+std::vector<queuedCommand> pendingEmergencyStops;
+while(!commandQueue.empty())
+{
+if(commandQueue.top().effectivePriority == EMERGENCY_STOP_PRIORITY)
+{
+pendingEmergencyStops.push_back(commandQueue.top());
+}
+commandQueue.pop();
+}
+
+for(const queuedCommand &pendingEmergencyStop : pendingEmergencyStops)
+{
+commandQueue.push(pendingEmergencyStop);
+}
+numberOfPendingEmergencyStops++;
+}
+
+commandToQueue.command = inputCommand;
+commandToQueue.effectivePriority = isEmergencyStop ? EMERGENCY_STOP_PRIORITY : std::min(inputCommand.priority(), EMERGENCY_STOP_PRIORITY - 1);
+commandToQueue.sequenceNumber = nextSequenceNumber++;
+commandQueue.push(std::move(commandToQueue));
+}
+
+/**
+This function removes the highest priority command from the queue and calls its handler.  Exceptions thrown by the handler are printed and counted in the statistics rather than passed on, so one bad command (such as a malformed path) can't stop the commands after it from being handled.
+@return: true if a command was dispatched, false if the queue was empty
+*/
+bool commandScheduler::dispatchNext()
+{
+queuedCommand commandToDispatch;
+commandHandler handler;
+
+{ //Only hold the lock while taking the command off the queue, so commands can be queued while the handler runs
+std::lock_guard<std::mutex> lock(queueMutex);
+if(commandQueue.empty())
+{
+return false;
+}
+
+commandToDispatch = commandQueue.top();
+commandQueue.pop();
+handler = handlers[commandToDispatch.handlerFieldNumber];
+
+double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - commandToDispatch.enqueueTime).count();
+latencyStatistics.numberOfDispatchedCommands++;
+latencyStatistics.meanLatency += (latency - latencyStatistics.meanLatency)/latencyStatistics.numberOfDispatchedCommands;
+latencyStatistics.maximumLatency = std::max(latencyStatistics.maximumLatency, latency);
+
+if(commandToDispatch.effectivePriority == EMERGENCY_STOP_PRIORITY)
+{
+latencyStatistics.lastEmergencyStopLatency = latency;
+numberOfPendingEmergencyStops--;
+}
+}
+
+try
+{
+SOM_TRY
+handler(commandToDispatch.command);
+SOM_CATCH("Error in command handler\n")
+}
+catch(const std::exception &inputException)
+{
+fprintf(stderr, "Error: %s\n", inputException.what());
+std::lock_guard<std::mutex> lock(queueMutex);
+latencyStatistics.numberOfFailedCommands++;
+}
+
+return true;
+}
+
+/**
+This function dispatches commands until the queue is empty.
+@return: The number of commands dispatched (including those whose handler failed)
+*/
+int commandScheduler::dispatchAll()
+{
+int numberOfDispatchedCommands = 0;
+
+while(dispatchNext())
+{
+numberOfDispatchedCommands++;
+}
+
+return numberOfDispatchedCommands;
+}
+
+/**
+This function removes all queued commands without dispatching them.
+*/
+void commandScheduler::clear()
+{
+std::lock_guard<std::mutex> lock(queueMutex);
+commandQueue = decltype(commandQueue)();
+numberOfPendingEmergencyStops = 0;
+}
+
+/**
+This function returns the number of commands waiting to be dispatched.
+@return: The number of queued commands
+*/
+int commandScheduler::size()
+{
+std::lock_guard<std::mutex> lock(queueMutex);
+return commandQueue.size();
+}
+
+/**
+This function returns true if an emergency stop has been queued but not yet dispatched, so running commands should stop.
+@return: true if the current command should stop
+*/
+bool commandScheduler::preemptionRequested() const
+{
+return numberOfPendingEmergencyStops > 0;
+}
+
+/**
+This function returns the time statistics for the commands dispatched so far.
+@return: The statistics
+*/
+commandSchedulerLatencyStatistics commandScheduler::getLatencyStatistics()
+{
+std::lock_guard<std::mutex> lock(queueMutex);
+return latencyStatistics;
+}
+
+/**
+This function finds the extension field number of the command embedded in the command message that has a registered handler.
+@param inputCommand: The command to check
+@return: The field number (0 if none of the set extensions have a handler)
+*/
+int commandScheduler::findHandlerFieldNumber(const command_message &inputCommand)
+{
+//Emergency stops take precedence if a message somehow has more than one command in it
+if(inputCommand.HasExtension(emergency_stop_command::emergency_stop_command_field) && handlers.count(emergency_stop_command::kEmergencyStopCommandFieldFieldNumber) > 0)
+{
+return emergency_stop_command::kEmergencyStopCommandFieldFieldNumber;
+}
+
+std::vector<const google::protobuf::FieldDescriptor *> setFields;
+inputCommand.GetReflection()->ListFields(inputCommand, &setFields);
+
+for(const google::protobuf::FieldDescriptor *field : setFields)
+{
+if(field->is_extension() && handlers.count(field->number()) > 0)
+{
+return field->number();
+}
+}
+
+return 0;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include<queue>
+#include<vector>
+#include<map>
+#include<mutex>
+#include<atomic>
+#include<chrono>
+#include<functional>
+#include<limits>
+#include "SOMException.hpp"
+#include "command_message.pb.h"
+#include "emergency_stop_command.pb.h"
+
+namespace soaringPen
+{
+
+const int EMERGENCY_STOP_PRIORITY = std::numeric_limits<int>::max(); //Emergency stops are always dispatched first, regardless of their priority field
+
+/**
+This struct holds the time commands spent in the scheduler's queue (from being enqueued to being dispatched).
+*/
+struct commandSchedulerLatencyStatistics
+{
+int64_t numberOfDispatchedCommands = 0;
+double meanLatency = 0.0; //Seconds
+double maximumLatency = 0.0; //Seconds
+double lastEmergencyStopLatency = 0.0; //Seconds from the last emergency stop being queued to being dispatched
+int64_t numberOfPreemptedCommands = 0; //Commands discarded from the queue by emergency stops
+int64_t numberOfFailedCommands = 0; //Dispatched commands whose handler threw an exception
+};
+
+/**
+This class is a priority queue of command_message objects which dispatches each command to the handler registered for the command type embedded in it (found by the number of the extension field that is set).  Higher priority values are dispatched first and commands with the same priority are dispatched in the order they were queued.
+
+Emergency stops preempt everything else: they are given the highest possible priority and queuing one discards the commands waiting in the queue, so the next dispatch call always handles the stop (in O(log n) time, rather than after the queued commands).  Handlers of long running commands can check preemptionRequested() to stop early.  Commands can be enqueued from a different thread than the one that dispatches them.
+*/
+class commandScheduler
+{
+public:
+typedef std::function<void(const command_message &)> commandHandler;
+
+/**
+This function sets the handler to call for commands which have the given extension field set.
+@param inputExtensionFieldNumber: The field number of the command_message extension (such as emergency_stop_command::kEmergencyStopCommandFieldFieldNumber)
+@param inputHandler: The function to call with the command when it is dispatched
+*/
+void registerHandler(int inputExtensionFieldNumber, const commandHandler &inputHandler);
+
+/**
+This function adds a command to the queue.
+@param inputCommand: The command to add
+
+@throws: This function can throw exceptions (such as if the command has no handler registered for it)
+*/
+void enqueue(const command_message &inputCommand);
+
+/**
+This function removes the highest priority command from the queue and calls its handler.  Exceptions thrown by the handler are printed and counted in the statistics rather than passed on, so one bad command (such as a malformed path) can't stop the commands after it from being handled.
+@return: true if a command was dispatched, false if the queue was empty
+*/
+bool dispatchNext();
+
+/**
+This function dispatches commands until the queue is empty.
+@return: The number of commands dispatched (including those whose handler failed)
+*/
+int dispatchAll();
+
+/**
+This function removes all queued commands without dispatching them.
+*/
+void clear();
+
+/**
+This function returns the number of commands waiting to be dispatched.
+@return: The number of queued commands
+*/
+int size();
+
+/**
+This function returns true if an emergency stop has been queued but not yet dispatched, so running commands should stop.
+@return: true if the current command should stop
+*/
+bool preemptionRequested() const;
+
+/**
+This function returns the time statistics for the commands dispatched so far.
+@return: The statistics
+*/
+commandSchedulerLatencyStatistics getLatencyStatistics();
+
+private:
+/**
+This struct is a queued command with what is needed to order it.
+*/
+struct queuedCommand
+{
+command_message command;
+int effectivePriority;
+int handlerFieldNumber;
+uint64_t sequenceNumber;
+std::chrono::steady_clock::time_point enqueueTime;
+};
+
+/**
+This struct orders queued commands for the std::priority_queue (true if the left command should be dispatched after the right one).
+*/
+struct queuedCommandComparison
+{
+bool operator()(const queuedCommand &inputLeftHandSide, const queuedCommand &inputRightHandSide) const
+{
+if(inputLeftHandSide.effectivePriority != inputRightHandSide.effectivePriority)
+{
+return inputLeftHandSide.effectivePriority < inputRightHandSide.effectivePriority;
+}
+return inputLeftHandSide.sequenceNumber > inputRightHandSide.sequenceNumber; //First in, first out
+}
+};
+
+/**
+This function finds the extension field number of the command embedded in the command message that has a registered handler.
+@param inputCommand: The command to check
+@return: The field number (0 if none of the set extensions have a handler)
+*/
+int findHandlerFieldNumber(const command_message &inputCommand);
+
+std::mutex queueMutex; //Protects the queue, handlers and statistics
+std::priority_queue<queuedCommand, std::vector<queuedCommand>, queuedCommandComparison> commandQueue;
+std::map<int, commandHandler> handlers; //Extension field number -> handler
+uint64_t nextSequenceNumber = 0;
+std::atomic<int> numberOfPendingEmergencyStops{0};
+commandSchedulerLatencyStatistics latencyStatistics;
+};
+
+}
@@ -0,0 +1,299 @@
+#include "dummyController.hpp"
+
+using namespace soaringPen;
+
+/**
+This function opens the video device and binds the controller's sockets, so the GUI can connect as soon as it returns.
+@param inputContext: The ZMQ context to use (must outlive the controller)
+@param inputVideoDeviceNumber: The OpenCV number of the camera to stream
+@param inputCommandEndpoint: The endpoint to bind the PAIR socket the GUI sends commands to (see normalizeZMQBindEndpoint)
+@param inputVideoEndpoint: The endpoint to bind the PUB socket the video is published on (see normalizeZMQBindEndpoint).  A shared memory endpoint ("shm://name") publishes raw frames in a sharedMemoryFrameRing instead, with only frame numbers going through the PUB socket.
+@param inputShowDisplay: True if the video should also be shown in an OpenCV window (which has to be done from the main thread)
+@param inputEmergencyStopEndpoint: The endpoint to bind the dedicated emergency stop socket to (see normalizeZMQBindEndpoint), or empty if emergency stops only come through the command socket
+
+@throws: This function can throw exceptions
+*/
+dummyController::dummyController(zmq::context_t &inputContext, int inputVideoDeviceNumber, const std::string &inputCommandEndpoint, const std::string &inputVideoEndpoint, bool inputShowDisplay, const std::string &inputEmergencyStopEndpoint) : showDisplay(inputShowDisplay)
+{
+//Open image source
+if(imageSource.open(inputVideoDeviceNumber) != true)
+{
+throw SOMException("Unable to open video device\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+//Could hardcode/set camera resolution
+//imageSource.set(CV_CAP_PROP_FRAME_WIDTH,1080);
+//imageSource.set(CV_CAP_PROP_FRAME_HEIGHT,720);
+
+imageSource.set(CV_CAP_PROP_FRAME_WIDTH,1280);
+imageSource.set(CV_CAP_PROP_FRAME_HEIGHT,720);
+
+
+//Get first image (used for automatic dimension detection)
+SOM_TRY
+imageSource >> sourceImage;
+SOM_CATCH("Error retrieving first image\n")
+
+if(showDisplay)
+{
+//Create display interface using opencv
+cv::namedWindow("Display", 1);
+
+SOM_TRY
+cv::imshow("Display", sourceImage);
+SOM_CATCH("Error showing image\n")
+}
+
+//Create PAIR interface so that GUI can initialize correctly
+SOM_TRY //Initialize
+commandReceiver.reset(new zmq::socket_t(inputContext, ZMQ_PAIR));
+SOM_CATCH("Error initializing command socket\n")
+
+SOM_TRY //Bind
+std::string bindingAddress = pylongps::normalizeZMQBindEndpoint(inputCommandEndpoint);
+commandReceiver->bind(bindingAddress.c_str());
+SOM_CATCH("Error binding command receiver\n")
+
+
+//Setup ZMQ pub socket to share video with
+SOM_TRY //Initialize
+videoPublisher.reset(new zmq::socket_t(inputContext, ZMQ_PUB));
+SOM_CATCH("Error initializing video sharing socket\n")
+
+if(isSharedMemoryEndpoint(inputVideoEndpoint))
+{ //Slots are sized for the camera's frames (with room for a larger resolution than the first image)
+SOM_TRY
+frameRing.reset(new sharedMemoryFrameRing(sharedMemoryFrameRingName(inputVideoEndpoint), DEFAULT_SHARED_MEMORY_FRAME_RING_SIZE, 2*sourceImage.total()*sourceImage.elemSize()));
+SOM_CATCH("Error creating shared memory frame ring\n")
+}
+
+SOM_TRY //Bind
+std::string bindingAddress = frameRing ? sharedMemoryFrameNotificationEndpoint(inputVideoEndpoint) : pylongps::normalizeZMQBindEndpoint(inputVideoEndpoint);
+videoPublisher->bind(bindingAddress.c_str());
+SOM_CATCH("Error binding video publisher\n")
+
+
+//Setup command handling
+scheduler.registerHandler(emergency_stop_command::kEmergencyStopCommandFieldFieldNumber, [](const command_message &inputCommand)
+{
+printf("Emergency stop %s\n", inputCommand.GetExtension(emergency_stop_command::emergency_stop_command_field).stop() ? "activated" : "cleared");
+});
+
+scheduler.registerHandler(follow_path_command::kFollowPathCommandFieldFieldNumber, [](const command_message &inputCommand)
+{
+linearPath pathToFollow = decodePath(inputCommand.GetExtension(follow_path_command::follow_path_command_field));
+printf("Following path with %ld points (length %lf)\n", pathToFollow.points.size(), pathToFollow.pathLength);
+});
+
+commandMessageReceiver.reset(new pylongps::protobufMessageReceiver(*commandReceiver));
+
+if(inputEmergencyStopEndpoint.size() > 0)
+{ //Stops on this channel are acted on as soon as they arrive, rather than waiting for the command loop
+SOM_TRY
+emergencyStopChannel.reset(new emergencyStopReceiver(inputContext, inputEmergencyStopEndpoint, [](bool inputStop)
+{
+printf("Emergency stop %s (dedicated channel)\n", inputStop ? "activated" : "cleared");
+}));
+SOM_CATCH("Error starting emergency stop receiver\n")
+}
+}
+
+/**
+This function handles commands and streams video until shutdown is set.
+
+@throws: This function can throw exceptions (such as if the video source stops working)
+*/
+void dummyController::run()
+{
+//Display video and share it
+while(!shutdown)
+{
+SOM_TRY
+processCommands();
+SOM_CATCH("Error processing commands\n")
+
+sendStatusUpdate();
+
+SOM_TRY
+publishFrame();
+SOM_CATCH("Error publishing frame\n")
+
+if(showDisplay)
+{
+//Display the image with labeled markers/axis
+cv::imshow("Display", sourceImage);
+
+//Wait, enabling opencv to display the image
+cv::waitKey(10); //Wait 10 milliseconds
+}
+}
+}
+
+/**
+This function queues any commands from the GUI (answering pings right away), then dispatches them in priority order.
+
+@throws: This function can throw exceptions
+*/
+void dummyController::processCommands()
+{
+while(true)
+{
+bool messageReceived = false;
+bool messageDeserialized = false;
+SOM_TRY
+std::tie(messageReceived, messageDeserialized) = commandMessageReceiver->receive(receivedCommand, ZMQ_DONTWAIT);
+SOM_CATCH("Error receiving command\n")
+
+if(!messageReceived)
+{
+break;
+}
+
+if(!messageDeserialized)
+{
+fprintf(stderr, "Error, received invalid command\n");
+continue;
+}
+
+if(receivedCommand.has_link_probe_field())
+{ //Answer pings right away so that they measure the link rather than this loop
+int64_t probeReceiveTime = monotonicMicroseconds();
+controller_status_update pong;
+(*pong.mutable_link_probe_field()) = receivedCommand.link_probe_field();
+pong.mutable_link_probe_field()->set_receive_time(probeReceiveTime);
+pong.mutable_link_probe_field()->set_transmit_time(monotonicMicroseconds());
+pylongps::trySendProtobufMessage(*commandReceiver, pong, ZMQ_DONTWAIT); //A dropped pong is counted as loss
+}
+
+command_message command;
+if(receivedCommand.has_emergency_stop_command_field())
+{
+(*command.MutableExtension(emergency_stop_command::emergency_stop_command_field)) = receivedCommand.emergency_stop_command_field();
+}
+else if(receivedCommand.has_follow_path_command_field())
+{
+(*command.MutableExtension(follow_path_command::follow_path_command_field)) = receivedCommand.follow_path_command_field();
+}
+else if(receivedCommand.return_to_home())
+{ //Abandon whatever is queued
+scheduler.clear();
+printf("Returning to home\n");
+continue;
+}
+else
+{
+continue;
+}
+
+SOM_TRY
+scheduler.enqueue(command);
+SOM_CATCH("Error queuing command\n")
+}
+
+SOM_TRY
+scheduler.dispatchAll();
+SOM_CATCH("Error dispatching commands\n")
+}
+
+/**
+This function adds a synthetic drone state sample to the telemetry batch and, once the batch is full, sends it in a status update along with what this controller supports and how long commands are waiting.
+*/
+void dummyController::sendStatusUpdate()
+{
+//There is no drone, so make one up that circles the middle of the image
+double angularVelocity = 2.0*M_PI/DUMMY_DRONE_ORBIT_PERIOD;
+double orbitAngle = angularVelocity*(monotonicMicroseconds()/1000000.0);
+fPoint dronePosition(DUMMY_DRONE_ORBIT_RADIUS*cos(orbitAngle), DUMMY_DRONE_ORBIT_RADIUS*sin(orbitAngle));
+fPoint droneVelocity(-100.0*DUMMY_DRONE_ORBIT_RADIUS*angularVelocity*sin(orbitAngle), 100.0*DUMMY_DRONE_ORBIT_RADIUS*angularVelocity*cos(orbitAngle)); //Hundredths of a unit per second, which is what the GUI displays
+
+int64_t sampleTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+try
+{
+SOM_TRY
+telemetry.addSample(sampleTime, dronePosition, droneVelocity);
+SOM_CATCH("Error adding telemetry sample\n")
+}
+catch(const std::exception &inputException)
+{
+fprintf(stderr, "Error: %s\n", inputException.what());
+}
+
+if(!telemetry.isFull())
+{
+return;
+}
+
+commandSchedulerLatencyStatistics latencyStatistics = scheduler.getLatencyStatistics();
+statusUpdate.set_supports_quantized_paths(true);
+statusUpdate.set_command_queue_mean_latency(latencyStatistics.meanLatency);
+statusUpdate.set_command_queue_maximum_latency(latencyStatistics.maximumLatency);
+statusUpdate.set_emergency_stop_latency(latencyStatistics.lastEmergencyStopLatency);
+telemetry.flush(statusUpdate);
+pylongps::trySendProtobufMessage(*commandReceiver, statusUpdate, ZMQ_DONTWAIT); //Dropped if the GUI isn't keeping up
+}
+
+/**
+This function gets the next image from the camera, then encodes and publishes it (or puts it in the shared memory frame ring and publishes its number).
+
+@throws: This function can throw exceptions
+*/
+void dummyController::publishFrame()
+{
+if(imageSource.grab() != true)
+{
+throw SOMException("Unable to get image from video source\n", SYSTEM_ERROR, __FILE__, __LINE__);
+}
+
+int64_t captureTime = monotonicMicroseconds();
+
+//Get image from camera
+if(imageSource.retrieve(sourceImage) != true)
+{
+throw SOMException("Unable to retrieve image from video source\n", SYSTEM_ERROR, __FILE__, __LINE__);
+}
+
+if(frameRing)
+{ //Raw frame goes in shared memory, so only its number needs to be published
+if(!sourceImage.isContinuous())
+{
+sourceImage = sourceImage.clone();
+}
+
+sharedMemoryFrameInformation frameInformation;
+frameInformation.width = sourceImage.cols;
+frameInformation.height = sourceImage.rows;
+frameInformation.type = sourceImage.type();
+frameInformation.step = sourceImage.step[0];
+frameInformation.captureTime = captureTime;
+
+uint64_t frameNumber = 0;
+SOM_TRY
+frameNumber = frameRing->publish(sourceImage.data, sourceImage.total()*sourceImage.elemSize(), frameInformation);
+SOM_CATCH("Error putting frame in shared memory\n")
+
+SOM_TRY
+videoPublisher->send(&frameNumber, sizeof(frameNumber));
+SOM_CATCH("Error publishing frame number\n")
+return;
+}
+
+//Compress/encode it for transmission
+std::vector<int> options; //Pairs of format type:value
+
+//Set jpg quality
+options.push_back(CV_IMWRITE_JPEG_QUALITY);
+options.push_back(95);
+
+if(cv::imencode(".jpg", sourceImage, encodedImage, options) != true)
+{
+throw SOMException("Unable to encode image\n", SYSTEM_ERROR, __FILE__, __LINE__);
+}
+
+//Publish image, prefixed with when it was captured
+SOM_TRY
+zmq::message_t frameMessage(VIDEO_FRAME_CAPTURE_TIME_SIZE + encodedImage.size());
+memcpy(frameMessage.data(), &captureTime, VIDEO_FRAME_CAPTURE_TIME_SIZE);
+memcpy(((char *) frameMessage.data()) + VIDEO_FRAME_CAPTURE_TIME_SIZE, encodedImage.data(), encodedImage.size());
+videoPublisher->send(frameMessage);
+SOM_CATCH("Error publishing image\n");
+}
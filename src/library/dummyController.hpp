@@ -0,0 +1,95 @@
+#pragma once
+
+#include<cstdio>
+#include<opencv2/highgui/highgui.hpp>
+#include<opencv2/imgproc/imgproc.hpp>
+#include<string>
+#include<cstring>
+#include<memory>
+#include<atomic>
+#include<zmq.hpp>
+#include "SOMException.hpp"
+#include "utilityFunctions.hpp"
+#include "protobufMessageReceiver.hpp"
+#include "commandScheduler.hpp"
+#include "pathEncoding.hpp"
+#include "linkQualityMonitor.hpp"
+#include "telemetryBatcher.hpp"
+#include "sharedMemoryFrameRing.hpp"
+#include "emergencyStopChannel.hpp"
+#include "gui_command.pb.h"
+#include "controller_status_update.pb.h"
+
+namespace soaringPen
+{
+
+const int DUMMY_CONTROLLER_TELEMETRY_BATCH_SIZE = 8; //Samples (one per frame) per status update
+const double DUMMY_DRONE_ORBIT_RADIUS = .2; //The synthetic drone circles the middle of the image (normalized image coordinates)
+const double DUMMY_DRONE_ORBIT_PERIOD = 20.0; //Seconds per lap
+
+/**
+This class is a dummy controller that just streams video (and answers the GUI's commands) to aid development of the GUI.  It can be run as its own process (the controller executable) or on a thread in the GUI's process (all-in-one mode), where using inproc endpoints avoids the network stack entirely.
+*/
+class dummyController
+{
+public:
+/**
+This function opens the video device and binds the controller's sockets, so the GUI can connect as soon as it returns.
+@param inputContext: The ZMQ context to use (must outlive the controller)
+@param inputVideoDeviceNumber: The OpenCV number of the camera to stream
+@param inputCommandEndpoint: The endpoint to bind the PAIR socket the GUI sends commands to (see normalizeZMQBindEndpoint)
+@param inputVideoEndpoint: The endpoint to bind the PUB socket the video is published on (see normalizeZMQBindEndpoint).  A shared memory endpoint ("shm://name") publishes raw frames in a sharedMemoryFrameRing instead, with only frame numbers going through the PUB socket.
+@param inputShowDisplay: True if the video should also be shown in an OpenCV window (which has to be done from the main thread)
+@param inputEmergencyStopEndpoint: The endpoint to bind the dedicated emergency stop socket to (see normalizeZMQBindEndpoint), or empty if emergency stops only come through the command socket
+
+@throws: This function can throw exceptions
+*/
+dummyController(zmq::context_t &inputContext, int inputVideoDeviceNumber, const std::string &inputCommandEndpoint, const std::string &inputVideoEndpoint, bool inputShowDisplay = true, const std::string &inputEmergencyStopEndpoint = "");
+
+/**
+This function handles commands and streams video until shutdown is set.
+
+@throws: This function can throw exceptions (such as if the video source stops working)
+*/
+void run();
+
+std::atomic<bool> shutdown{false}; //Set to make run() return
+
+protected:
+bool showDisplay;
+cv::VideoCapture imageSource;
+cv::Mat sourceImage;
+std::vector<unsigned char> encodedImage;
+
+std::unique_ptr<zmq::socket_t> commandReceiver; //PAIR socket the GUI sends commands on and receives status updates from
+std::unique_ptr<zmq::socket_t> videoPublisher; //PUB socket the video (or shared memory frame numbers) is shared with
+std::unique_ptr<sharedMemoryFrameRing> frameRing; //Raw frames for same host subscribers, if a shared memory endpoint was given
+
+commandScheduler scheduler; //The GUI's commands are queued by priority and dispatched to its handlers
+std::unique_ptr<pylongps::protobufMessageReceiver> commandMessageReceiver;
+std::unique_ptr<emergencyStopReceiver> emergencyStopChannel; //Acts on stops from the dedicated emergency stop socket on its own thread, if an endpoint was given
+gui_command receivedCommand;
+controller_status_update statusUpdate;
+telemetryBatcher telemetry{DUMMY_CONTROLLER_TELEMETRY_BATCH_SIZE}; //Synthetic drone positions/velocities waiting to be sent
+
+/**
+This function queues any commands from the GUI (answering pings right away), then dispatches them in priority order.
+
+@throws: This function can throw exceptions
+*/
+void processCommands();
+
+/**
+This function adds a synthetic drone state sample to the telemetry batch and, once the batch is full, sends it in a status update along with what this controller supports and how long commands are waiting.
+*/
+void sendStatusUpdate();
+
+/**
+This function gets the next image from the camera, then encodes and publishes it (or puts it in the shared memory frame ring and publishes its number).
+
+@throws: This function can throw exceptions
+*/
+void publishFrame();
+};
+
+}
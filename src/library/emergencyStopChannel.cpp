@@ -0,0 +1,385 @@
+#include "emergencyStopChannel.hpp"
+
+using namespace soaringPen;
+
+/**
+This function connects to the controller's emergency stop socket and starts the sending thread.
+@param inputContext: The ZMQ context to use (must outlive the sender)
+@param inputControllerEndpoint: The controller's emergency stop endpoint (see normalizeZMQConnectionEndpoint)
+
+@throws: This function can throw exceptions
+*/
+emergencyStopSender::emergencyStopSender(zmq::context_t &inputContext, const std::string &inputControllerEndpoint)
+{
+//Every sender starts its sequence numbers at 1, so the receiver needs this to tell a new GUI's stops from resends
+std::random_device randomSource;
+sessionID = (((uint64_t) randomSource()) << 32) | ((uint64_t) randomSource());
+
+int linger = 0; //Don't hold up shutdown trying to deliver stops to a controller that isn't there
+
+SOM_TRY //Initialize
+stopSocket.reset(new zmq::socket_t(inputContext, ZMQ_PAIR));
+stopSocket->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+SOM_CATCH("Error initializing emergency stop socket\n")
+
+SOM_TRY //Connect
+std::string connectionAddress = pylongps::normalizeZMQConnectionEndpoint(inputControllerEndpoint);
+stopSocket->connect(connectionAddress.c_str());
+SOM_CATCH("Error connecting emergency stop socket\n")
+
+//Stop requests are handed to the sending thread through an inproc pair, so the thread can block on both sockets at once
+std::string requestEndpoint = "inproc://emergencyStopRequests" + std::to_string((uintptr_t) this);
+SOM_TRY
+requestReceiver.reset(new zmq::socket_t(inputContext, ZMQ_PAIR));
+requestReceiver->bind(requestEndpoint.c_str());
+requestSender.reset(new zmq::socket_t(inputContext, ZMQ_PAIR));
+requestSender->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+requestSender->connect(requestEndpoint.c_str());
+SOM_CATCH("Error making emergency stop request sockets\n")
+
+acknowledgementReceiver.reset(new pylongps::protobufMessageReceiver(*stopSocket));
+
+senderThread = std::thread(&emergencyStopSender::run, this);
+}
+
+/**
+This function stops the sending thread and waits for it to exit.
+*/
+emergencyStopSender::~emergencyStopSender()
+{
+shutdown = true;
+
+try
+{ //Wake the thread up rather than waiting for it to notice
+std::lock_guard<std::mutex> lock(requestSenderMutex);
+zmq::message_t wakeUpMessage;
+requestSender->send(wakeUpMessage, ZMQ_DONTWAIT);
+}
+catch(const std::exception &)
+{ //It will still notice within EMERGENCY_STOP_SHUTDOWN_CHECK_INTERVAL
+}
+
+if(senderThread.joinable())
+{
+senderThread.join();
+}
+}
+
+/**
+This function hands a stop to the sending thread, which sends it immediately.  It can be called from any thread.
+@param inputStop: True if the emergency stop should be activated and false if it should be cleared
+@return: The sequence number of the stop (for waitForAcknowledgement)
+
+@throws: This function can throw exceptions
+*/
+uint64_t emergencyStopSender::sendStop(bool inputStop)
+{
+emergency_stop_command stop;
+stop.set_stop(inputStop);
+stop.set_send_time(monotonicMicroseconds());
+
+std::lock_guard<std::mutex> lock(requestSenderMutex);
+uint64_t sequenceNumber = nextSequenceNumber;
+nextSequenceNumber++;
+stop.set_sequence_number(sequenceNumber);
+stop.set_session_id(sessionID);
+
+bool stopHandedOff = false;
+SOM_TRY
+stopHandedOff = pylongps::trySendProtobufMessage(*requestSender, stop, ZMQ_DONTWAIT);
+SOM_CATCH("Error handing emergency stop to sending thread\n")
+
+if(!stopHandedOff)
+{
+throw SOMException("Unable to hand emergency stop to sending thread\n", ZMQ_ERROR, __FILE__, __LINE__);
+}
+
+return sequenceNumber;
+}
+
+/**
+This function waits until the controller has acknowledged the given stop (or a later one).
+@param inputSequenceNumber: The sequence number returned by sendStop
+@param inputTimeout: The maximum time (seconds) to wait
+@return: true if the stop was acknowledged before the timeout
+*/
+bool emergencyStopSender::waitForAcknowledgement(uint64_t inputSequenceNumber, double inputTimeout)
+{
+std::unique_lock<std::mutex> lock(acknowledgementMutex);
+return acknowledgementCondition.wait_for(lock, std::chrono::duration<double>(inputTimeout), [&]()
+{
+return lastAcknowledgedSequenceNumber >= inputSequenceNumber;
+});
+}
+
+/**
+This function returns the stop latency measurements so far.
+@return: The measurements
+*/
+emergencyStopLatencyStatistics emergencyStopSender::getLatencyStatistics()
+{
+std::lock_guard<std::mutex> lock(acknowledgementMutex);
+return latencyStatistics;
+}
+
+/**
+This function is run by the sending thread.  It forwards stop requests and processes acknowledgements until the sender is destroyed.
+*/
+void emergencyStopSender::run()
+{
+try
+{
+zmq::pollitem_t pollItems[] = { {(void *) (*requestReceiver), 0, ZMQ_POLLIN, 0}, {(void *) (*stopSocket), 0, ZMQ_POLLIN, 0} };
+
+while(!shutdown)
+{
+//Block until there is something to do (or a stop needs to be resent)
+long pollTimeout = EMERGENCY_STOP_SHUTDOWN_CHECK_INTERVAL;
+if(stopUnacknowledged)
+{
+pollTimeout = std::min<long>(pollTimeout, std::max<long>((nextResendTime - monotonicMicroseconds())/1000 + 1, 0));
+}
+
+SOM_TRY
+zmq::poll(pollItems, 2, pollTimeout);
+SOM_CATCH("Error polling\n")
+
+if(pollItems[0].revents & ZMQ_POLLIN)
+{
+SOM_TRY
+forwardStopRequests();
+SOM_CATCH("Error forwarding emergency stop\n")
+}
+
+if(pollItems[1].revents & ZMQ_POLLIN)
+{
+SOM_TRY
+processAcknowledgements();
+SOM_CATCH("Error processing emergency stop acknowledgement\n")
+}
+
+int64_t currentTime = monotonicMicroseconds();
+if(stopUnacknowledged && currentTime >= nextResendTime)
+{ //The stop (or its acknowledgement) may have been lost, so send it again with its original send time
+pylongps::trySendProtobufMessage(*stopSocket, unacknowledgedStop, ZMQ_DONTWAIT);
+nextResendTime = currentTime + EMERGENCY_STOP_RESEND_INTERVAL*1e6;
+
+std::lock_guard<std::mutex> lock(acknowledgementMutex);
+latencyStatistics.numberOfResends++;
+}
+}
+}
+catch(const std::exception &inputException)
+{
+fprintf(stderr, "Error: %s\n", inputException.what());
+}
+}
+
+/**
+This function sends any stop requests waiting on the request socket to the controller.
+
+@throws: This function can throw exceptions
+*/
+void emergencyStopSender::forwardStopRequests()
+{
+while(true)
+{
+bool messageReceived = false;
+SOM_TRY
+messageReceived = requestReceiver->recv(&messageBuffer, ZMQ_DONTWAIT);
+SOM_CATCH("Error receiving emergency stop request\n")
+
+if(!messageReceived)
+{
+break;
+}
+
+if(messageBuffer.size() == 0 || !unacknowledgedStop.ParseFromArray(messageBuffer.data(), messageBuffer.size()))
+{ //Wake up message
+continue;
+}
+
+stopUnacknowledged = true;
+nextResendTime = monotonicMicroseconds() + EMERGENCY_STOP_RESEND_INTERVAL*1e6;
+
+//Send the request message itself rather than serializing the stop again (if it can't be sent now, it will be resent)
+SOM_TRY
+stopSocket->send(messageBuffer, ZMQ_DONTWAIT);
+SOM_CATCH("Error sending emergency stop\n")
+}
+}
+
+/**
+This function processes any acknowledgements waiting on the stop socket.
+
+@throws: This function can throw exceptions
+*/
+void emergencyStopSender::processAcknowledgements()
+{
+while(true)
+{
+bool messageReceived = false;
+bool messageDeserialized = false;
+SOM_TRY
+std::tie(messageReceived, messageDeserialized) = acknowledgementReceiver->receive(acknowledgement, ZMQ_DONTWAIT);
+SOM_CATCH("Error receiving emergency stop acknowledgement\n")
+
+int64_t receiveTime = monotonicMicroseconds();
+
+if(!messageReceived)
+{
+break;
+}
+
+if(!messageDeserialized || !acknowledgement.has_sequence_number())
+{
+continue;
+}
+
+std::lock_guard<std::mutex> lock(acknowledgementMutex);
+if(acknowledgement.sequence_number() <= lastAcknowledgedSequenceNumber)
+{ //Acknowledgement of a resent copy
+continue;
+}
+lastAcknowledgedSequenceNumber = acknowledgement.sequence_number();
+
+if(stopUnacknowledged && acknowledgement.sequence_number() == unacknowledgedStop.sequence_number())
+{
+stopUnacknowledged = false;
+
+double latency = (receiveTime - unacknowledgedStop.send_time())/1e6;
+latencyStatistics.numberOfAcknowledgedStops++;
+latencyStatistics.lastLatency = latency;
+latencyStatistics.meanLatency += (latency - latencyStatistics.meanLatency)/latencyStatistics.numberOfAcknowledgedStops;
+latencyStatistics.maximumLatency = std::max(latencyStatistics.maximumLatency, latency);
+}
+
+acknowledgementCondition.notify_all();
+}
+}
+
+/**
+This function binds the emergency stop socket and starts the receiving thread.
+@param inputContext: The ZMQ context to use (must outlive the receiver)
+@param inputEndpoint: The endpoint to bind (see normalizeZMQBindEndpoint)
+@param inputStopHandler: The function to call (from the receiving thread) with whether the emergency stop has been activated or cleared
+
+@throws: This function can throw exceptions
+*/
+emergencyStopReceiver::emergencyStopReceiver(zmq::context_t &inputContext, const std::string &inputEndpoint, const std::function<void(bool)> &inputStopHandler) : stopHandler(inputStopHandler)
+{
+SOM_TRY //Initialize
+stopSocket.reset(new zmq::socket_t(inputContext, ZMQ_PAIR));
+int linger = 0;
+stopSocket->setsockopt(ZMQ_LINGER, &linger, sizeof(linger));
+SOM_CATCH("Error initializing emergency stop socket\n")
+
+SOM_TRY //Bind
+std::string bindingAddress = pylongps::normalizeZMQBindEndpoint(inputEndpoint);
+stopSocket->bind(bindingAddress.c_str());
+SOM_CATCH("Error binding emergency stop socket\n")
+
+stopMessageReceiver.reset(new pylongps::protobufMessageReceiver(*stopSocket));
+
+receiverThread = std::thread(&emergencyStopReceiver::run, this);
+}
+
+/**
+This function stops the receiving thread and waits for it to exit.
+*/
+emergencyStopReceiver::~emergencyStopReceiver()
+{
+shutdown = true;
+
+if(receiverThread.joinable())
+{
+receiverThread.join();
+}
+}
+
+/**
+This function is run by the receiving thread.  It handles stops until the receiver is destroyed.
+*/
+void emergencyStopReceiver::run()
+{
+try
+{
+zmq::pollitem_t pollItems[] = { {(void *) (*stopSocket), 0, ZMQ_POLLIN, 0} };
+
+while(!shutdown)
+{
+SOM_TRY //Returns as soon as a stop arrives
+zmq::poll(pollItems, 1, EMERGENCY_STOP_SHUTDOWN_CHECK_INTERVAL);
+SOM_CATCH("Error polling\n")
+
+if(pollItems[0].revents & ZMQ_POLLIN)
+{
+SOM_TRY
+processStops();
+SOM_CATCH("Error processing emergency stop\n")
+}
+}
+}
+catch(const std::exception &inputException)
+{
+fprintf(stderr, "Error: %s\n", inputException.what());
+}
+}
+
+/**
+This function handles and acknowledges any stops waiting on the stop socket.  Resent copies of the last stop (same session and sequence number) are acknowledged again without calling the handler.
+
+@throws: This function can throw exceptions
+*/
+void emergencyStopReceiver::processStops()
+{
+while(true)
+{
+bool messageReceived = false;
+bool messageDeserialized = false;
+SOM_TRY
+std::tie(messageReceived, messageDeserialized) = stopMessageReceiver->receive(receivedStop, ZMQ_DONTWAIT);
+SOM_CATCH("Error receiving emergency stop\n")
+
+int64_t receiveTime = monotonicMicroseconds();
+
+if(!messageReceived)
+{
+break;
+}
+
+if(!messageDeserialized)
+{
+fprintf(stderr, "Error, received invalid emergency stop\n");
+continue;
+}
+
+if(!receivedStop.has_sequence_number() || receivedStop.sequence_number() != lastHandledSequenceNumber || receivedStop.session_id() != lastHandledSessionID)
+{
+stopActive = receivedStop.stop();
+
+if(stopHandler)
+{
+try
+{
+stopHandler(receivedStop.stop());
+}
+catch(const std::exception &inputException)
+{ //Still acknowledge, since the stop state has been recorded
+fprintf(stderr, "Error: %s\n", inputException.what());
+}
+}
+
+numberOfStopsHandled++;
+lastHandledSequenceNumber = receivedStop.sequence_number();
+lastHandledSessionID = receivedStop.session_id();
+}
+
+acknowledgement.Clear();
+acknowledgement.set_sequence_number(receivedStop.sequence_number());
+acknowledgement.set_stop(stopActive);
+acknowledgement.set_receive_time(receiveTime);
+acknowledgement.set_handled_time(monotonicMicroseconds());
+pylongps::trySendProtobufMessage(*stopSocket, acknowledgement, ZMQ_DONTWAIT); //A dropped acknowledgement makes the GUI resend the stop
+}
+}
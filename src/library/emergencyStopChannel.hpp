@@ -0,0 +1,175 @@
+#pragma once
+
+#include<cstdio>
+#include<string>
+#include<memory>
+#include<atomic>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<functional>
+#include<algorithm>
+#include<random>
+#include<zmq.hpp>
+#include "SOMException.hpp"
+#include "utilityFunctions.hpp"
+#include "protobufMessageReceiver.hpp"
+#include "linkQualityMonitor.hpp"
+#include "emergency_stop_command.pb.h"
+#include "emergency_stop_acknowledgement.pb.h"
+
+namespace soaringPen
+{
+
+const double EMERGENCY_STOP_RESEND_INTERVAL = .05; //Seconds to wait for an acknowledgement before sending a stop again
+const int EMERGENCY_STOP_SHUTDOWN_CHECK_INTERVAL = 100; //Milliseconds the receiver waits for stops before checking if it should shut down
+
+/**
+This struct holds the measurements of how long emergency stops take.  The latency is from the stop being requested to its acknowledgement arriving back at the GUI, which is an upper bound on how long it took the controller to act on it.  Times are in seconds.
+*/
+struct emergencyStopLatencyStatistics
+{
+int64_t numberOfAcknowledgedStops = 0;
+int64_t numberOfResends = 0; //Times a stop was sent again because it hadn't been acknowledged in time
+double lastLatency = 0.0;
+double meanLatency = 0.0;
+double maximumLatency = 0.0;
+};
+
+/**
+This class sends emergency stops to the controller over a dedicated PAIR socket (separate from the command and status stream), so a stop can't queue behind a large path message.  The socket belongs to a thread of its own which spends its time blocked waiting for either a stop request or an acknowledgement, so a stop goes out as soon as it is requested rather than on the next pass of a polling loop.  Stops are sent again until the controller acknowledges them.
+*/
+class emergencyStopSender
+{
+public:
+/**
+This function connects to the controller's emergency stop socket and starts the sending thread.
+@param inputContext: The ZMQ context to use (must outlive the sender)
+@param inputControllerEndpoint: The controller's emergency stop endpoint (see normalizeZMQConnectionEndpoint)
+
+@throws: This function can throw exceptions
+*/
+emergencyStopSender(zmq::context_t &inputContext, const std::string &inputControllerEndpoint);
+
+/**
+This function stops the sending thread and waits for it to exit.
+*/
+~emergencyStopSender();
+
+/**
+This function hands a stop to the sending thread, which sends it immediately.  It can be called from any thread.
+@param inputStop: True if the emergency stop should be activated and false if it should be cleared
+@return: The sequence number of the stop (for waitForAcknowledgement)
+
+@throws: This function can throw exceptions
+*/
+uint64_t sendStop(bool inputStop = true);
+
+/**
+This function waits until the controller has acknowledged the given stop (or a later one).
+@param inputSequenceNumber: The sequence number returned by sendStop
+@param inputTimeout: The maximum time (seconds) to wait
+@return: true if the stop was acknowledged before the timeout
+*/
+bool waitForAcknowledgement(uint64_t inputSequenceNumber, double inputTimeout);
+
+/**
+This function returns the stop latency measurements so far.
+@return: The measurements
+*/
+emergencyStopLatencyStatistics getLatencyStatistics();
+
+protected:
+/**
+This function is run by the sending thread.  It forwards stop requests and processes acknowledgements until the sender is destroyed.
+*/
+void run();
+
+/**
+This function sends any stop requests waiting on the request socket to the controller.
+
+@throws: This function can throw exceptions
+*/
+void forwardStopRequests();
+
+/**
+This function processes any acknowledgements waiting on the stop socket.
+
+@throws: This function can throw exceptions
+*/
+void processAcknowledgements();
+
+std::unique_ptr<zmq::socket_t> stopSocket; //PAIR socket connected to the controller (only used by the sending thread)
+std::unique_ptr<zmq::socket_t> requestReceiver; //inproc PAIR socket the sending thread gets stop requests from
+std::unique_ptr<zmq::socket_t> requestSender; //Other end of requestReceiver, used by sendStop while holding requestSenderMutex
+std::mutex requestSenderMutex;
+uint64_t nextSequenceNumber = 1; //Protected by requestSenderMutex
+uint64_t sessionID = 0; //Random, set on construction and sent with every stop
+
+//Only used by the sending thread
+emergency_stop_command unacknowledgedStop; //The latest stop sent (later stops supersede earlier ones, so only it needs to be resent)
+bool stopUnacknowledged = false;
+int64_t nextResendTime = 0; //monotonicMicroseconds
+zmq::message_t messageBuffer; //Reused for each stop request
+std::unique_ptr<pylongps::protobufMessageReceiver> acknowledgementReceiver;
+emergency_stop_acknowledgement acknowledgement;
+
+std::mutex acknowledgementMutex; //Protects the members below
+std::condition_variable acknowledgementCondition;
+uint64_t lastAcknowledgedSequenceNumber = 0;
+emergencyStopLatencyStatistics latencyStatistics;
+
+std::atomic<bool> shutdown{false};
+std::thread senderThread;
+};
+
+/**
+This class receives emergency stops on the controller's dedicated emergency stop socket.  It has a thread of its own which calls the stop handler as soon as a stop arrives (rather than queuing it with the other commands), then acknowledges it.
+*/
+class emergencyStopReceiver
+{
+public:
+/**
+This function binds the emergency stop socket and starts the receiving thread.
+@param inputContext: The ZMQ context to use (must outlive the receiver)
+@param inputEndpoint: The endpoint to bind (see normalizeZMQBindEndpoint)
+@param inputStopHandler: The function to call (from the receiving thread) with whether the emergency stop has been activated or cleared
+
+@throws: This function can throw exceptions
+*/
+emergencyStopReceiver(zmq::context_t &inputContext, const std::string &inputEndpoint, const std::function<void(bool)> &inputStopHandler);
+
+/**
+This function stops the receiving thread and waits for it to exit.
+*/
+~emergencyStopReceiver();
+
+std::atomic<bool> stopActive{false}; //The current emergency stop state
+std::atomic<int64_t> numberOfStopsHandled{0};
+
+protected:
+/**
+This function is run by the receiving thread.  It handles stops until the receiver is destroyed.
+*/
+void run();
+
+/**
+This function handles and acknowledges any stops waiting on the stop socket.  Resent copies of the last stop (same session and sequence number) are acknowledged again without calling the handler.
+
+@throws: This function can throw exceptions
+*/
+void processStops();
+
+std::unique_ptr<zmq::socket_t> stopSocket; //PAIR socket the GUI connects to (only used by the receiving thread)
+std::function<void(bool)> stopHandler;
+uint64_t lastHandledSessionID = 0;
+uint64_t lastHandledSequenceNumber = 0;
+emergency_stop_command receivedStop;
+emergency_stop_acknowledgement acknowledgement;
+std::unique_ptr<pylongps::protobufMessageReceiver> stopMessageReceiver;
+
+std::atomic<bool> shutdown{false};
+std::thread receiverThread;
+};
+
+}
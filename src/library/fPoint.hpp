@@ -6,181 +6,256 @@
 #include<iostream>
 #include<stdlib.h>
 #include<limits.h>
+#include<type_traits>
 
 namespace soaringPen
 {
 
 
 /**
-This class is my own version of the generic 2 dimensional floating point vector (recycled from vision mosaics machine learning then PRT simulation)
+This class is my own version of the generic floating point vector (recycled from vision mosaics machine learning then PRT simulation).  The number of dimensions and the type of the elements are template parameters, so that loops over the elements have a compile time length and large collections of points can be stored in single precision when desired.  The point arithmetic is defined inline (and constexpr where the math library allows) so that point expressions in hot loops can be inlined and vectorized rather than going through library calls.
 */
-class fPoint
+template<int dimension, class elementType> class basicPoint
 {
 public:
-const static int numberOfElements = 2;
+typedef elementType valueType;
+static const int numberOfElements = dimension;
 
 /**
-This function initializes the fPoint to all zeros in the absense of input
+This function initializes the point to all zeros in the absense of input
 */
-fPoint();
+constexpr basicPoint() : val{}
+{
+}
 
 /**
-This function initializes the fPoint using the three scalars provided
+This function initializes the first two elements of the point using the scalars provided (any others are set to zero)
 @param inputX: This goes to val[0]
 @param inputY: This goes to val[1]
 */
-fPoint(double inputX, double inputY);
+constexpr basicPoint(valueType inputX, valueType inputY) : val{inputX, inputY}
+{
+}
 
 /**
-This function initializes the fPoint from 2 values in an array
+This function initializes a 3 dimensional point using the three scalars provided
+@param inputX: This goes to val[0]
+@param inputY: This goes to val[1]
+@param inputZ: This goes to val[2]
+*/
+template<int pointDimension = dimension, typename std::enable_if<pointDimension == 3, int>::type = 0> constexpr basicPoint(valueType inputX, valueType inputY, valueType inputZ) : val{inputX, inputY, inputZ}
+{
+}
+
+/**
+This function initializes the point from a point with the same number of dimensions but a different element type.
+@param inputPoint: The point to convert
+*/
+template<class otherElementType> constexpr explicit basicPoint(const basicPoint<dimension, otherElementType> &inputPoint) : val{}
+{
+for(int i=0; i<numberOfElements; i++)
+{
+val[i] = (valueType) inputPoint.val[i];
+}
+}
+
+/**
+This function initializes the point from numberOfElements values in an array
 @param inputArray: A pointer to an array of doubles
 */
-fPoint(double *inputArray);
+constexpr basicPoint(const double *inputArray) : val{}
+{
+for(int i=0; i<numberOfElements; i++)
+{
+val[i]=(valueType) inputArray[i];
+}
+}
 
 /**
-This function initializes the fPoint from 2 values in an array
+This function initializes the point from numberOfElements values in an array
 @param inputArray: A pointer to an array of integers (converts)
 */
-fPoint(int *inputArray);
+constexpr basicPoint(const int *inputArray) : val{}
+{
+for(int i=0; i<numberOfElements; i++)
+{
+val[i]=(valueType) inputArray[i];
+}
+}
 
 /**
 This function normalizes this vector
 */
-void normalize();
+void normalize()
+{
+valueType magBuffer=mag();
+for(int i=0; i<numberOfElements; i++)
+{
+val[i]=val[i]/magBuffer;
+}
+}
 
 /**
 This function returns the magnitude of this vector.
 @return: The magnitude of this vector.
 */
-double mag(void) const;
+valueType mag(void) const
+{
+valueType sum = 0.0;
+for(int i=0; i<numberOfElements; i++)
+{
+sum = sum + val[i]*val[i];
+}
+return sqrt(sum);
+}
 
 /**
-This function returns the angle of the vector relative to the x axis going counterclockwise (valid for 2d).
+This function returns the angle of the vector relative to the x axis going counterclockwise (valid for 2d, uses only x and y otherwise).
 */
-double angle(void) const;
+valueType angle(void) const
+{
+//A dot B = a1*b1 + a2*b2 ... with x axis a1 =1 a2=0
+//Get cos(theta)
+valueType planarMagnitude = sqrt(val[0]*val[0] + val[1]*val[1]);
+valueType cosTheta=val[0]/planarMagnitude;
+valueType angle = acos(cosTheta);
+
+//If this vector is in the third or forth quadrant, the angle from acos isn't valid as the absolute angle of this vector and needs to be adjusted.
+if(val[1] < 0.0)
+{
+angle=-angle;
+angle=angle+2*PI;
+}
+
+return angle;
+}
 
 /**
 This function returns the distance from this point to the inputted one
 @param inputPoint: The point to compute distance from
 @return: The distance from that point
 */
-double distance(fPoint *inputPoint);
-
-/**
-This function returns the distance squared from this point to the inputted one
-@param inputPoint: The point to compute distance squared from
-@return: The distance squared from that point
-*/
-double distanceS(fPoint *inputPoint);
-
-/**
-This function allows these vectors to compute the dot product
-@param inputLeftHandSide:  The first point
-@param inputRightHandSide: The second point
-@return: the dot product of the two points
-*/
-friend double dot(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
-
-/**
-This function returns the angle between this vector and another, going counter clockwise (in radians)
-@param inputLeftHandSide:  The first point
-@param inputRightHandSide: The second point
-@return: The difference in angle (radians) between the two vectors
-*/
-friend double angleDifference(const fPoint &inputLeftHandSide,const fPoint &inputRightHandSide);
-
-/**
-This function allows these vectors to be added.
-@param inputLeftHandSide:  The first point
-@param inputRightHandSide: The second point
-@return: the sum of the two points
-*/
-friend fPoint operator+(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
-
-/**
-This function allows these vectors to be subtracted.
-@param inputLeftHandSide:  The first point
-@param inputRightHandSide: The second point
-@return: The difference of the two points
-*/
-friend fPoint operator-(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
+valueType distance(const basicPoint &inputPoint) const
+{
+return sqrt(distanceS(inputPoint));
+}
 
 /**
-This function allows these vectors to be multiplied (element by element).
-@param inputLeftHandSide:  The first point
-@param inputRightHandSide: The second point
-@return: the element by element multiplication result
+This function returns the distance from this point to the one the pointer refers to
+@param inputPoint: The point to compute distance from
+@return: The distance from that point
 */
-friend fPoint operator*(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
+valueType distance(const basicPoint *inputPoint) const
+{
+return distance(*inputPoint);
+}
 
 /**
-This function allows these vectors to be divided (element by element).
-@param inputLeftHandSide:  The first point
-@param inputRightHandSide: The second point
-@return: The element by element quotion
+This function returns the distance squared from this point to the inputted one
+@param inputPoint: The point to compute distance squared from
+@return: The distance squared from that point
 */
-friend fPoint operator/(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
+constexpr valueType distanceS(const basicPoint &inputPoint) const
+{
+valueType sum = 0.0;
+for(int i=0; i<numberOfElements; i++)
+{
+valueType difference = inputPoint.val[i]-val[i];
+sum = sum + difference*difference;
+}
+return sum;
+}
 
 /**
-This function multiplies this vector by a scalar.
-@param inputLeftHandSide:  The first point
-@param inputRightHandSide: The second point
-@return: the vector multiplied by a scalar
+This function returns the distance squared from this point to the one the pointer refers to
+@param inputPoint: The point to compute distance squared from
+@return: The distance squared from that point
 */
-friend fPoint operator*(const fPoint &inputLeftHandSide, double inputRightHandSide);
+constexpr valueType distanceS(const basicPoint *inputPoint) const
+{
+return distanceS(*inputPoint);
+}
 
 /**
-This function divides this vector by a scalar.
-@param inputLeftHandSide:  The first point
-@param inputRightHandSide: The second point
-@return: This vector divided by a scalar
+This function adds the given point to this one in place.
+@param inputPoint: The point to add
+@return: This point
 */
-friend fPoint operator/(const fPoint &inputLeftHandSide, double &inputRightHandSide);
+constexpr basicPoint &operator+=(const basicPoint &inputPoint)
+{
+for(int i=0; i<numberOfElements; i++)
+{
+val[i] += inputPoint.val[i];
+}
+return *this;
+}
 
 /**
-This function determines if all elements of the vectors are the same.
-@param inputLeftHandSide:  The first point
-@param inputRightHandSide: The second point
-@return: true if the vectors are the same
+This function subtracts the given point from this one in place.
+@param inputPoint: The point to subtract
+@return: This point
 */
-friend bool operator==(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
-
-
+constexpr basicPoint &operator-=(const basicPoint &inputPoint)
+{
+for(int i=0; i<numberOfElements; i++)
+{
+val[i] -= inputPoint.val[i];
+}
+return *this;
+}
 
 /**
-This function prints out the coordinates of the point in simple text format.
-@inputOutStream: The stream to output to
-@inputFPoint: The point to print out
-@return: The stream after this point has been added to it
+This function multiplies this point by a scalar in place.
+@param inputScalar: The scalar to multiply by
+@return: This point
 */
-friend std::ostream &operator<<(std::ostream &inputOutStream, const fPoint &inputFPoint);
+constexpr basicPoint &operator*=(valueType inputScalar)
+{
+for(int i=0; i<numberOfElements; i++)
+{
+val[i] *= inputScalar;
+}
+return *this;
+}
 
 /**
-This function compares the left point to the right one to get lexical order (x, then y)
-@param inputLeftHandSide: The left point
-@param inputRightHandSide: The right point
-@return: true the right point is greater than the left, false otherwise
+This function divides this point by a scalar in place.
+@param inputScalar: The scalar to divide by
+@return: This point
 */
-friend bool operator<(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide); 
+constexpr basicPoint &operator/=(valueType inputScalar)
+{
+for(int i=0; i<numberOfElements; i++)
+{
+val[i] /= inputScalar;
+}
+return *this;
+}
 
-double val[2];
+valueType val[dimension];
 };
 
+typedef basicPoint<2, double> fPoint;
+typedef basicPoint<3, double> fPoint3D; //For paths with altitude
+typedef basicPoint<2, float> fPoint2DFloat; //For large point collections where memory matters more than precision
+typedef basicPoint<3, float> fPoint3DFloat;
+
 /**
 This function allows these vectors to compute the dot product
 @param inputLeftHandSide:  The first point
 @param inputRightHandSide: The second point
 @return: the dot product of the two points
 */
-double dot(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
+template<int dimension, class valueType> constexpr valueType dot(const basicPoint<dimension, valueType> &inputLeftHandSide, const basicPoint<dimension, valueType> &inputRightHandSide)
+{
+valueType sum=0.0;
+for(int i=0; i<dimension; i++)
+{
+sum=sum+inputLeftHandSide.val[i]*inputRightHandSide.val[i];
+}
 
-/**
-This function returns the angle between this vector and another, going counter clockwise (in radians)
-@param inputLeftHandSide:  The first point
-@param inputRightHandSide: The second point
-@return: The difference in angle (radians) between the two vectors
-*/
-double angleDifference(const fPoint &inputLeftHandSide,const fPoint &inputRightHandSide);
+return sum;
+}
 
 /**
 This function allows these vectors to be added.
@@ -188,7 +263,15 @@ This function allows these vectors to be added.
 @param inputRightHandSide: The second point
 @return: the sum of the two points
 */
-fPoint operator+(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
+template<int dimension, class valueType> constexpr basicPoint<dimension, valueType> operator+(const basicPoint<dimension, valueType> &inputLeftHandSide, const basicPoint<dimension, valueType> &inputRightHandSide)
+{
+basicPoint<dimension, valueType> result;
+for(int i=0; i<dimension; i++)
+{
+result.val[i] = inputLeftHandSide.val[i]+inputRightHandSide.val[i];
+}
+return result;
+}
 
 /**
 This function allows these vectors to be subtracted.
@@ -196,7 +279,15 @@ This function allows these vectors to be subtracted.
 @param inputRightHandSide: The second point
 @return: The difference of the two points
 */
-fPoint operator-(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
+template<int dimension, class valueType> constexpr basicPoint<dimension, valueType> operator-(const basicPoint<dimension, valueType> &inputLeftHandSide, const basicPoint<dimension, valueType> &inputRightHandSide)
+{
+basicPoint<dimension, valueType> result;
+for(int i=0; i<dimension; i++)
+{
+result.val[i] = inputLeftHandSide.val[i]-inputRightHandSide.val[i];
+}
+return result;
+}
 
 /**
 This function allows these vectors to be multiplied (element by element).
@@ -204,7 +295,31 @@ This function allows these vectors to be multiplied (element by element).
 @param inputRightHandSide: The second point
 @return: the element by element multiplication result
 */
-fPoint operator*(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
+template<int dimension, class valueType> constexpr basicPoint<dimension, valueType> operator*(const basicPoint<dimension, valueType> &inputLeftHandSide, const basicPoint<dimension, valueType> &inputRightHandSide)
+{
+basicPoint<dimension, valueType> result;
+for(int i=0; i<dimension; i++)
+{
+result.val[i] = inputLeftHandSide.val[i]*inputRightHandSide.val[i];
+}
+return result;
+}
+
+/**
+This function multiplies this vector by a scalar.
+@param inputLeftHandSide:  The first point
+@param inputRightHandSide: The second point
+@return: the vector multiplied by a scalar
+*/
+template<int dimension, class valueType> constexpr basicPoint<dimension, valueType> operator*(const basicPoint<dimension, valueType> &inputLeftHandSide, typename basicPoint<dimension, valueType>::valueType inputRightHandSide)
+{
+basicPoint<dimension, valueType> result;
+for(int i=0; i<dimension; i++)
+{
+result.val[i] = inputLeftHandSide.val[i]*inputRightHandSide;
+}
+return result;
+}
 
 /**
 This function multiplies the vector by a scalar.
@@ -212,7 +327,10 @@ This function multiplies the vector by a scalar.
 @param inputLeftHandSide: The scalar to be multiplied
 @return: The resulting vector
 */
-fPoint  operator*(double inputLeftHandSide, const fPoint &inputRightHandSide);
+template<int dimension, class valueType> constexpr basicPoint<dimension, valueType> operator*(typename basicPoint<dimension, valueType>::valueType inputLeftHandSide, const basicPoint<dimension, valueType> &inputRightHandSide)
+{
+return inputRightHandSide*inputLeftHandSide;
+}
 
 /**
 This function allows these vectors to be divided (element by element).
@@ -220,15 +338,15 @@ This function allows these vectors to be divided (element by element).
 @param inputRightHandSide: The second point
 @return: The element by element quotion
 */
-fPoint operator/(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
-
-/**
-This function multiplies this vector by a scalar.
-@param inputLeftHandSide:  The first point
-@param inputRightHandSide: The second point
-@return: the vector multiplied by a scalar
-*/
-fPoint operator*(const fPoint &inputLeftHandSide, double inputRightHandSide);
+template<int dimension, class valueType> constexpr basicPoint<dimension, valueType> operator/(const basicPoint<dimension, valueType> &inputLeftHandSide, const basicPoint<dimension, valueType> &inputRightHandSide)
+{
+basicPoint<dimension, valueType> result;
+for(int i=0; i<dimension; i++)
+{
+result.val[i] = inputLeftHandSide.val[i]/inputRightHandSide.val[i];
+}
+return result;
+}
 
 /**
 This function divides this vector by a scalar.
@@ -236,7 +354,15 @@ This function divides this vector by a scalar.
 @param inputRightHandSide: The second point
 @return: This vector divided by a scalar
 */
-fPoint operator/(const fPoint &inputLeftHandSide, double &inputRightHandSide);
+template<int dimension, class valueType> constexpr basicPoint<dimension, valueType> operator/(const basicPoint<dimension, valueType> &inputLeftHandSide, typename basicPoint<dimension, valueType>::valueType inputRightHandSide)
+{
+basicPoint<dimension, valueType> result;
+for(int i=0; i<dimension; i++)
+{
+result.val[i] = inputLeftHandSide.val[i]/inputRightHandSide;
+}
+return result;
+}
 
 /**
 This function determines if all elements of the vectors are the same.
@@ -244,9 +370,35 @@ This function determines if all elements of the vectors are the same.
 @param inputRightHandSide: The second point
 @return: true if the vectors are the same
 */
-bool operator==(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide);
-
+template<int dimension, class valueType> constexpr bool operator==(const basicPoint<dimension, valueType> &inputLeftHandSide, const basicPoint<dimension, valueType> &inputRightHandSide)
+{
+for(int i=0; i<dimension; i++)
+{
+if(inputLeftHandSide.val[i]!=inputRightHandSide.val[i])
+{
+return false;
+}
+}
+return true; //Made it to the end without an inequality
+}
 
+/**
+This function compares the left point to the right one to get lexical order (x, then y, etc)
+@param inputLeftHandSide: The left point
+@param inputRightHandSide: The right point
+@return: true the right point is greater than the left, false otherwise
+*/
+template<int dimension, class valueType> constexpr bool operator<(const basicPoint<dimension, valueType> &inputLeftHandSide, const basicPoint<dimension, valueType> &inputRightHandSide)
+{
+for(int i=0; i<dimension; i++)
+{
+if(inputLeftHandSide.val[i] != inputRightHandSide.val[i])
+{
+return inputLeftHandSide.val[i] < inputRightHandSide.val[i];
+}
+}
+return false; //Equal
+}
 
 /**
 This function prints out the coordinates of the point in simple text format.
@@ -254,16 +406,15 @@ This function prints out the coordinates of the point in simple text format.
 @inputFPoint: The point to print out
 @return: The stream after this point has been added to it
 */
-std::ostream &operator<<(std::ostream &inputOutStream, const fPoint &inputFPoint);
-
-/**
-This function compares the left point to the right one to get lexical order (x, then y)
-@param inputLeftHandSide: The left point
-@param inputRightHandSide: The right point
-@return: true the right point is greater than the left, false otherwise
-*/
-bool operator<(const fPoint &inputLeftHandSide, const fPoint &inputRightHandSide); 
-
+template<int dimension, class valueType> std::ostream &operator<<(std::ostream &inputOutStream, const basicPoint<dimension, valueType> &inputFPoint)
+{
+inputOutStream << inputFPoint.val[0];
+for(int i=1; i<dimension; i++)
+{
+inputOutStream << " " << inputFPoint.val[i];
+}
+return inputOutStream;
+}
 
 /**
 This function returns the Z value of a cross product computed as if the given vectors were in 3D space with their current X and Y coordinates
@@ -271,7 +422,10 @@ This function returns the Z value of a cross product computed as if the given ve
 @param inputVector2: The second vector in the cross product
 @return: The Z value resulting
 */
-double crossZFactor(const fPoint &inputVector1, const fPoint &inputVector2); 
+constexpr double crossZFactor(const fPoint &inputVector1, const fPoint &inputVector2)
+{
+return inputVector1.val[0]*inputVector2.val[1] - inputVector1.val[1]*inputVector2.val[0];
+}
 
 /**
 Tests if 3 sequental points make a right turn
@@ -280,7 +434,23 @@ Tests if 3 sequental points make a right turn
 @param inputPoint3: The third point
 @return: True if the points make a right turn (1,2,3 order), false otherwise
 */
-bool makesRightTurn(const fPoint &inputPoint1, const fPoint &inputPoint2, const fPoint &inputPoint3);
+constexpr bool makesRightTurn(const fPoint &inputPoint1, const fPoint &inputPoint2, const fPoint &inputPoint3)
+{
+//Take relative vector 1->2 and cross with 2->3.  If resulting Z component is negative, then a right turn has been made
+return crossZFactor(inputPoint2-inputPoint1, inputPoint3-inputPoint2) < 0.0;
+
+//Could also use
+//http://en.wikipedia.org/wiki/Graham_scan
+//return (inputPoint2.val[0]-inputPoint1.val[0])*(inputPoint3.val[1]-inputPoint1.val[1])-(inputPoint2.val[1]-inputPoint1.val[1])*(inputPoint3.val[0]-inputPoint1.val[0]) < 0.0;
+}
+
+/**
+This function returns the angle between this vector and another, going counter clockwise (in radians)
+@param inputLeftHandSide:  The first point
+@param inputRightHandSide: The second point
+@return: The difference in angle (radians) between the two vectors
+*/
+double angleDifference(const fPoint &inputLeftHandSide,const fPoint &inputRightHandSide);
 
 /**
 This function returns if the points are colinear within.  This is determined by comparing the vector from point 1 to point 2 with the vector from point 2 to point 3
@@ -0,0 +1,393 @@
+#include "geofence.hpp"
+#include<fstream>
+#include<sstream>
+
+using namespace soaringPen;
+
+/**
+This function computes the convex hull of the given points to define the zone.
+@param inputPoints: The points to make the zone from (the zone is their convex hull)
+
+@throws: This function can throw exceptions (such as if the points are all colinear)
+*/
+convexZone::convexZone(const std::vector<fPoint> &inputPoints)
+{
+//Andrew's monotone chain: sort the points, then make the lower and upper hulls by dropping points that don't make a strict left turn
+std::vector<fPoint> sortedPoints = inputPoints;
+std::sort(sortedPoints.begin(), sortedPoints.end(), lexicographicXComparison);
+sortedPoints.erase(std::unique(sortedPoints.begin(), sortedPoints.end()), sortedPoints.end());
+
+if(sortedPoints.size() < 3)
+{
+throw SOMException("Zone needs at least 3 distinct points\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+hull.resize(2*sortedPoints.size());
+int hullSize = 0;
+for(int i=0; i<sortedPoints.size(); i++)
+{ //Lower hull
+while(hullSize >= 2 && !makesRightTurn(sortedPoints[i], hull[hullSize-1], hull[hullSize-2]))
+{
+hullSize--;
+}
+hull[hullSize++] = sortedPoints[i];
+}
+
+int lowerHullSize = hullSize;
+for(int i=((int) sortedPoints.size())-2; i>=0; i--)
+{ //Upper hull
+while(hullSize > lowerHullSize && !makesRightTurn(sortedPoints[i], hull[hullSize-1], hull[hullSize-2]))
+{
+hullSize--;
+}
+hull[hullSize++] = sortedPoints[i];
+}
+hull.resize(hullSize-1); //Last point is the same as the first
+
+if(hull.size() < 3)
+{
+throw SOMException("Zone points are colinear\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+//Edge angles increase going counterclockwise, so store them unwrapped for binary searches
+edgeAngles.resize(hull.size());
+for(int i=0; i<hull.size(); i++)
+{
+edgeAngles[i] = (hull[(i+1) % hull.size()] - hull[i]).angle();
+while(i > 0 && edgeAngles[i] < edgeAngles[i-1])
+{
+edgeAngles[i] += 2*PI;
+}
+}
+}
+
+/**
+This function returns if the given point is inside the zone (points on the boundary count as inside).
+@param inputPoint: The point to check
+@return: true if the point is inside or on the boundary of the zone
+*/
+bool convexZone::contains(const fPoint &inputPoint) const
+{
+//Check that the point is within the wedge formed by the first vertex and its neighbors
+fPoint offset = inputPoint - hull[0];
+if(crossZFactor(hull[1] - hull[0], offset) < 0.0 || crossZFactor(hull.back() - hull[0], offset) > 0.0)
+{
+return false;
+}
+
+//Binary search for the triangle (hull[0], hull[i], hull[i+1]) in the fan from the first vertex that the point falls in
+int low = 1;
+int high = hull.size() - 2;
+while(low < high)
+{
+int middle = (low + high + 1)/2;
+if(crossZFactor(hull[middle] - hull[0], offset) >= 0.0)
+{
+low = middle;
+}
+else
+{
+high = middle - 1;
+}
+}
+
+return crossZFactor(hull[low+1] - hull[low], inputPoint - hull[low]) >= 0.0;
+}
+
+/**
+This function returns if any part of the given line segment is inside or on the boundary of the zone.
+@param inputSegmentStart: The start of the segment
+@param inputSegmentEnd: The end of the segment
+@return: true if the segment touches the zone
+*/
+bool convexZone::intersects(const fPoint &inputSegmentStart, const fPoint &inputSegmentEnd) const
+{
+if(contains(inputSegmentStart) || contains(inputSegmentEnd))
+{
+return true;
+}
+
+fPoint segmentDirection = inputSegmentEnd - inputSegmentStart;
+if(segmentDirection == fPoint(0.0, 0.0))
+{
+return false;
+}
+
+//Signed distance (scaled) from the segment's line is crossZFactor(direction, vertex - start), which is largest at the vertex furthest in the direction of the left normal
+fPoint leftNormal(-segmentDirection.val[1], segmentDirection.val[0]);
+int leftMostIndex = findExtremeVertex(leftNormal);
+int rightMostIndex = findExtremeVertex(-1.0*leftNormal);
+
+if(crossZFactor(segmentDirection, hull[leftMostIndex] - inputSegmentStart) < 0.0 || crossZFactor(segmentDirection, hull[rightMostIndex] - inputSegmentStart) > 0.0)
+{ //The line misses the zone entirely
+return false;
+}
+
+//The line enters and exits the zone on the two chains between the extreme vertices.  With both end points outside, the segment touches the zone if the part of the line in the zone overlaps it.
+double firstCrossing = findChainCrossing(rightMostIndex, leftMostIndex, inputSegmentStart, segmentDirection);
+double secondCrossing = 1.0 - findChainCrossing(leftMostIndex, rightMostIndex, inputSegmentEnd, -1.0*segmentDirection); //Searched from the end with the reversed direction
+
+return std::max(firstCrossing, secondCrossing) >= 0.0 && std::min(firstCrossing, secondCrossing) <= 1.0;
+}
+
+/**
+This function finds the hull vertex that is furthest in the given direction.
+@param inputDirection: The direction to search in
+@return: The index of the vertex
+*/
+int convexZone::findExtremeVertex(const fPoint &inputDirection) const
+{
+//The furthest vertex is where the edges stop moving in the direction (edge angle passes the direction's angle + 90 degrees)
+double targetAngle = inputDirection.angle() + PI/2.0;
+while(targetAngle < edgeAngles[0])
+{
+targetAngle += 2*PI;
+}
+while(targetAngle >= edgeAngles[0] + 2*PI)
+{
+targetAngle -= 2*PI;
+}
+
+int index = std::lower_bound(edgeAngles.begin(), edgeAngles.end(), targetAngle) - edgeAngles.begin();
+return index % hull.size();
+}
+
+/**
+This function finds where the line through the segment crosses the hull boundary on a chain of vertices along which the signed distance from the line does not decrease, such as the chain from the vertex furthest on the line's right to the one furthest on its left.
+@param inputChainStartIndex: The index of the first vertex of the chain (signed distance <= 0)
+@param inputChainEndIndex: The index of the last vertex of the chain (signed distance >= 0)
+@param inputSegmentStart: The start of the segment defining the line
+@param inputSegmentDirection: The vector from the start to the end of the segment
+@return: The crossing as a fraction of the segment (0 is the start of the segment, 1 is the end)
+*/
+double convexZone::findChainCrossing(int inputChainStartIndex, int inputChainEndIndex, const fPoint &inputSegmentStart, const fPoint &inputSegmentDirection) const
+{
+int numberOfVertices = hull.size();
+int chainLength = (inputChainEndIndex - inputChainStartIndex + numberOfVertices) % numberOfVertices;
+
+auto chainVertex = [&](int inputChainIndex) -> const fPoint &
+{
+return hull[(inputChainStartIndex + inputChainIndex) % numberOfVertices];
+};
+auto signedDistance = [&](int inputChainIndex)
+{
+return crossZFactor(inputSegmentDirection, chainVertex(inputChainIndex) - inputSegmentStart);
+};
+
+//Binary search for the first vertex on the chain that is on or left of the line
+int low = 0;
+int high = chainLength;
+while(low < high)
+{
+int middle = (low + high)/2;
+if(signedDistance(middle) >= 0.0)
+{
+high = middle;
+}
+else
+{
+low = middle + 1;
+}
+}
+
+fPoint crossingPoint = chainVertex(low);
+if(low > 0)
+{ //Crossing is on the edge from the previous vertex
+double previousDistance = signedDistance(low-1);
+double currentDistance = signedDistance(low);
+double ratio = previousDistance/(previousDistance - currentDistance);
+crossingPoint = chainVertex(low-1) + ratio*(chainVertex(low) - chainVertex(low-1));
+}
+
+return dot(crossingPoint - inputSegmentStart, inputSegmentDirection)/dot(inputSegmentDirection, inputSegmentDirection);
+}
+
+/**
+This function adds a zone that the drone must stay inside.
+@param inputPoints: The points to make the zone from (the zone is their convex hull)
+
+@throws: This function can throw exceptions
+*/
+void geofence::addKeepInZone(const std::vector<fPoint> &inputPoints)
+{
+SOM_TRY
+keepInZones.emplace_back(inputPoints);
+SOM_CATCH("Error making keep-in zone\n")
+}
+
+/**
+This function adds a zone that the drone must stay out of.
+@param inputPoints: The points to make the zone from (the zone is their convex hull)
+
+@throws: This function can throw exceptions
+*/
+void geofence::addKeepOutZone(const std::vector<fPoint> &inputPoints)
+{
+SOM_TRY
+keepOutZones.emplace_back(inputPoints);
+SOM_CATCH("Error making keep-out zone\n")
+}
+
+/**
+This function reads zones from a stream and adds them to the geofence.  Each line is "keepIn" or "keepOut" followed by the x and y coordinates of the zone's points (at least 3), such as "keepOut 0 0 .1 0 .1 .1".  Blank lines and lines starting with # are ignored.
+@param inputStream: The stream to read the zones from
+
+@throws: This function can throw exceptions (such as if a line is malformed)
+*/
+void geofence::readZones(std::istream &inputStream)
+{
+std::string line;
+int lineNumber = 0;
+while(std::getline(inputStream, line))
+{
+lineNumber++;
+
+std::istringstream lineStream(line);
+std::string zoneType;
+if(!(lineStream >> zoneType) || zoneType[0] == '#')
+{ //Blank or comment
+continue;
+}
+
+std::vector<fPoint> zonePoints;
+double xCoordinate = 0.0;
+double yCoordinate = 0.0;
+while(lineStream >> xCoordinate)
+{
+if(!(lineStream >> yCoordinate))
+{
+throw SOMException("Geofence line " + std::to_string(lineNumber) + " has an x coordinate without a y coordinate\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+zonePoints.push_back(fPoint(xCoordinate, yCoordinate));
+}
+
+if(!lineStream.eof())
+{
+throw SOMException("Geofence line " + std::to_string(lineNumber) + " has an invalid coordinate\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+SOM_TRY
+if(zoneType == "keepIn")
+{
+addKeepInZone(zonePoints);
+}
+else if(zoneType == "keepOut")
+{
+addKeepOutZone(zonePoints);
+}
+else
+{
+throw SOMException("Unknown zone type\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+SOM_CATCH("Error adding zone from geofence line " + std::to_string(lineNumber) + "\n")
+}
+}
+
+/**
+This function reads zones from a file and adds them to the geofence (see readZones for the format).
+@param inputFileName: The path to the file
+
+@throws: This function can throw exceptions (such as if the file can't be opened)
+*/
+void geofence::readZonesFromFile(const std::string &inputFileName)
+{
+std::ifstream zoneFile(inputFileName);
+if(!zoneFile.is_open())
+{
+throw SOMException("Unable to open geofence file " + inputFileName + "\n", FILE_SYSTEM_ERROR, __FILE__, __LINE__);
+}
+
+SOM_TRY
+readZones(zoneFile);
+SOM_CATCH("Error reading geofence file " + inputFileName + "\n")
+}
+
+/**
+This function removes all of the zones.
+*/
+void geofence::clear()
+{
+keepInZones.clear();
+keepOutZones.clear();
+}
+
+/**
+This function returns if the given point is allowed by the geofence.
+@param inputPoint: The point to check
+@return: true if the point is in all keep-in zones and no keep-out zones
+*/
+bool geofence::isAllowed(const fPoint &inputPoint) const
+{
+for(const convexZone &zone : keepInZones)
+{
+if(!zone.contains(inputPoint))
+{
+return false;
+}
+}
+
+for(const convexZone &zone : keepOutZones)
+{
+if(zone.contains(inputPoint))
+{
+return false;
+}
+}
+
+return true;
+}
+
+/**
+This function returns if the given segment is allowed by the geofence.
+@param inputSegmentStart: The start of the segment
+@param inputSegmentEnd: The end of the segment
+@return: true if the whole segment is in all keep-in zones and doesn't touch any keep-out zones
+*/
+bool geofence::isAllowed(const fPoint &inputSegmentStart, const fPoint &inputSegmentEnd) const
+{
+for(const convexZone &zone : keepInZones)
+{ //Convex, so the segment is inside if both ends are
+if(!zone.contains(inputSegmentStart) || !zone.contains(inputSegmentEnd))
+{
+return false;
+}
+}
+
+for(const convexZone &zone : keepOutZones)
+{
+if(zone.intersects(inputSegmentStart, inputSegmentEnd))
+{
+return false;
+}
+}
+
+return true;
+}
+
+/**
+This function checks every point and segment of the path against the geofence.
+@param inputPath: The path to check
+@return: The index of the first point that isn't allowed or ends a segment that isn't allowed (-1 if the whole path is allowed)
+*/
+int geofence::findFirstViolation(const linearPath &inputPath) const
+{
+if(inputPath.points.size() == 0)
+{
+return -1;
+}
+
+if(!isAllowed(inputPath.points[0]))
+{
+return 0;
+}
+
+for(int i=1; i<inputPath.points.size(); i++)
+{
+if(!isAllowed(inputPath.points[i-1], inputPath.points[i]))
+{
+return i;
+}
+}
+
+return -1;
+}
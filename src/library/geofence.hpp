@@ -0,0 +1,135 @@
+#pragma once
+
+#include "fPoint.hpp"
+#include "linearPath.hpp"
+#include<vector>
+#include<algorithm>
+#include<string>
+#include<istream>
+#include "SOMException.hpp"
+
+namespace soaringPen
+{
+
+/**
+This class represents a convex region (the convex hull of the points it is constructed with).  The hull and the angles of its edges are computed once on construction, so that point containment and segment intersection queries can be answered with binary searches (O(log n) in the number of hull vertices).
+*/
+class convexZone
+{
+public:
+/**
+This function computes the convex hull of the given points to define the zone.
+@param inputPoints: The points to make the zone from (the zone is their convex hull)
+
+@throws: This function can throw exceptions (such as if the points are all colinear)
+*/
+convexZone(const std::vector<fPoint> &inputPoints);
+
+/**
+This function returns if the given point is inside the zone (points on the boundary count as inside).
+@param inputPoint: The point to check
+@return: true if the point is inside or on the boundary of the zone
+*/
+bool contains(const fPoint &inputPoint) const;
+
+/**
+This function returns if any part of the given line segment is inside or on the boundary of the zone.
+@param inputSegmentStart: The start of the segment
+@param inputSegmentEnd: The end of the segment
+@return: true if the segment touches the zone
+*/
+bool intersects(const fPoint &inputSegmentStart, const fPoint &inputSegmentEnd) const;
+
+std::vector<fPoint> hull; //The zone's vertices in counterclockwise order (no colinear vertices)
+
+private:
+/**
+This function finds the hull vertex that is furthest in the given direction.
+@param inputDirection: The direction to search in
+@return: The index of the vertex
+*/
+int findExtremeVertex(const fPoint &inputDirection) const;
+
+/**
+This function finds where the line through the segment crosses the hull boundary on a chain of vertices along which the signed distance from the line does not decrease, such as the chain from the vertex furthest on the line's right to the one furthest on its left.
+@param inputChainStartIndex: The index of the first vertex of the chain (signed distance <= 0)
+@param inputChainEndIndex: The index of the last vertex of the chain (signed distance >= 0)
+@param inputSegmentStart: The start of the segment defining the line
+@param inputSegmentDirection: The vector from the start to the end of the segment
+@return: The crossing as a fraction of the segment (0 is the start of the segment, 1 is the end)
+*/
+double findChainCrossing(int inputChainStartIndex, int inputChainEndIndex, const fPoint &inputSegmentStart, const fPoint &inputSegmentDirection) const;
+
+std::vector<double> edgeAngles; //Angle of the edge from hull[i] to hull[i+1], increasing from the first edge's angle (unwrapped rather than kept in 0 to 2 PI)
+};
+
+/**
+This class holds keep-in and keep-out zones that the drone's path must respect.  A point is allowed if it is in every keep-in zone and in no keep-out zone.  Since the zones are convex, a segment is allowed if both its end points are in every keep-in zone and it doesn't touch any keep-out zone.  If there are no zones, everything is allowed.
+*/
+class geofence
+{
+public:
+/**
+This function adds a zone that the drone must stay inside.
+@param inputPoints: The points to make the zone from (the zone is their convex hull)
+
+@throws: This function can throw exceptions
+*/
+void addKeepInZone(const std::vector<fPoint> &inputPoints);
+
+/**
+This function adds a zone that the drone must stay out of.
+@param inputPoints: The points to make the zone from (the zone is their convex hull)
+
+@throws: This function can throw exceptions
+*/
+void addKeepOutZone(const std::vector<fPoint> &inputPoints);
+
+/**
+This function reads zones from a stream and adds them to the geofence.  Each line is "keepIn" or "keepOut" followed by the x and y coordinates of the zone's points (at least 3), such as "keepOut 0 0 .1 0 .1 .1".  Blank lines and lines starting with # are ignored.
+@param inputStream: The stream to read the zones from
+
+@throws: This function can throw exceptions (such as if a line is malformed)
+*/
+void readZones(std::istream &inputStream);
+
+/**
+This function reads zones from a file and adds them to the geofence (see readZones for the format).
+@param inputFileName: The path to the file
+
+@throws: This function can throw exceptions (such as if the file can't be opened)
+*/
+void readZonesFromFile(const std::string &inputFileName);
+
+/**
+This function removes all of the zones.
+*/
+void clear();
+
+/**
+This function returns if the given point is allowed by the geofence.
+@param inputPoint: The point to check
+@return: true if the point is in all keep-in zones and no keep-out zones
+*/
+bool isAllowed(const fPoint &inputPoint) const;
+
+/**
+This function returns if the given segment is allowed by the geofence.
+@param inputSegmentStart: The start of the segment
+@param inputSegmentEnd: The end of the segment
+@return: true if the whole segment is in all keep-in zones and doesn't touch any keep-out zones
+*/
+bool isAllowed(const fPoint &inputSegmentStart, const fPoint &inputSegmentEnd) const;
+
+/**
+This function checks every point and segment of the path against the geofence.
+@param inputPath: The path to check
+@return: The index of the first point that isn't allowed or ends a segment that isn't allowed (-1 if the whole path is allowed)
+*/
+int findFirstViolation(const linearPath &inputPath) const;
+
+std::vector<convexZone> keepInZones;
+std::vector<convexZone> keepOutZones;
+};
+
+}
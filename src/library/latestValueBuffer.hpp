@@ -0,0 +1,53 @@
+#pragma once
+
+#include<atomic>
+#include<cstdint>
+
+namespace soaringPen
+{
+
+/**
+This class hands the most recent value of something (such as a status snapshot) from one thread to another without locks.  The producer publishes values as often as it likes and the consumer picks up whichever was published last whenever it gets around to it, so intermediate values are overwritten rather than queued.  It holds three copies of the value: one being written by the producer, one being read by the consumer and the most recently published one, which the two threads swap with theirs using a single atomic exchange.  Only one thread may publish and only one (other) thread may consume.
+*/
+template<class valueType>
+class latestValueBuffer
+{
+public:
+/**
+This function makes the given value the latest one.  It never blocks.
+@param inputValue: The value to publish
+*/
+void publish(const valueType &inputValue)
+{
+values[producerIndex] = inputValue;
+producerIndex = publishedState.exchange(producerIndex | NEW_VALUE_FLAG, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+/**
+This function retrieves the latest published value if one has been published since the last call.  It never blocks.
+@param outputValue: The value to store the latest value in (unchanged if there isn't a new value)
+@return: true if there was a new value
+*/
+bool consume(valueType &outputValue)
+{
+if((publishedState.load(std::memory_order_relaxed) & NEW_VALUE_FLAG) == 0)
+{
+return false;
+}
+
+consumerIndex = publishedState.exchange(consumerIndex, std::memory_order_acq_rel) & INDEX_MASK;
+outputValue = values[consumerIndex];
+return true;
+}
+
+protected:
+static const uint8_t INDEX_MASK = 3;
+static const uint8_t NEW_VALUE_FLAG = 4;
+
+valueType values[3];
+uint8_t producerIndex = 0; //Only used by the producer
+uint8_t consumerIndex = 1; //Only used by the consumer
+std::atomic<uint8_t> publishedState{2}; //Index of the most recently published value, or'd with NEW_VALUE_FLAG if the consumer hasn't taken it yet
+};
+
+}
@@ -1,24 +1,120 @@
 #include "linearPath.hpp"
+#include "batchGeometry.hpp"
 
 using namespace soaringPen;
 
 /**
-This function adds a point to the path and updates the associated path length.
+This function initializes the cursor at the start of the given path.
+@param inputPath: The path to move along
+*/
+template<class pointType> basicLinearPath<pointType>::cursor::cursor(const basicLinearPath &inputPath) : path(&inputPath)
+{
+}
+
+/**
+This function moves the cursor to the given location on the path (forward or backward) and returns everything needed to follow the path at that location.
+@param inputPathLengthLocation: The location along the path length to move to (ranging from 0.0 to path length)
+@return: <point at location, normalized derivative (x,y) at location, path length remaining after location>
+
+@throws: This function can throw exceptions
+*/
+template<class pointType> std::tuple<pointType, pointType, typename basicLinearPath<pointType>::valueType> basicLinearPath<pointType>::cursor::moveTo(valueType inputPathLengthLocation)
+{
+const std::vector<valueType> &locations = path->associatedPathLocations;
+int lastIndex = ((int) locations.size()) - 1;
+
+if(inputPathLengthLocation < 0.0)
+{
+throw SOMException("Negative path length\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+if(path->points.size() < 2 || locations.size() != path->points.size() || inputPathLengthLocation > locations.back())
+{
+throw SOMException("Path location could not be found\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+//The path may have been shortened since the last move
+segmentEndIndex = std::min(std::max(segmentEndIndex, 1), lastIndex);
+
+//Walk to the first segment that ends at or after the location (same segment choice as interpolate), searching if it is far away
+int numberOfSteps = 0;
+while(segmentEndIndex < lastIndex && locations[segmentEndIndex] < inputPathLengthLocation && numberOfSteps < MAXIMUM_NUMBER_OF_STEPS_BEFORE_SEARCH)
+{
+segmentEndIndex++;
+numberOfSteps++;
+}
+
+while(segmentEndIndex > 1 && locations[segmentEndIndex-1] >= inputPathLengthLocation && numberOfSteps < MAXIMUM_NUMBER_OF_STEPS_BEFORE_SEARCH)
+{
+segmentEndIndex--;
+numberOfSteps++;
+}
+
+if(numberOfSteps >= MAXIMUM_NUMBER_OF_STEPS_BEFORE_SEARCH)
+{
+segmentEndIndex = std::lower_bound(locations.begin() + 1, locations.end(), inputPathLengthLocation) - locations.begin();
+}
+
+const pointType &start = path->points[segmentEndIndex-1];
+const pointType &end = path->points[segmentEndIndex];
+valueType segmentLength = locations[segmentEndIndex] - locations[segmentEndIndex-1];
+valueType ratio = (inputPathLengthLocation - locations[segmentEndIndex-1])/segmentLength;
+
+pointType tangent = end - start;
+tangent.normalize();
+
+return std::tuple<pointType, pointType, valueType>(ratio*end + (1.0 - ratio)*start, tangent, locations.back() - inputPathLengthLocation);
+}
+
+/**
+This function adds a point to the path and updates the associated path length.  Only the length of the new segment is computed, so building a path point by point is linear time.
 @param inputPoint: The point to add
 */
-void linearPath::addPoint(const fPoint &inputPoint)
+template<class pointType> void basicLinearPath<pointType>::addPoint(const pointType &inputPoint)
 {
+if(points.size() == 0)
+{ //First point starts the path
 points.push_back(inputPoint);
-recalculatePathLengths();
+associatedPathLocations.push_back(0.0);
+pathLength = 0.0;
+return;
+}
+
+pathLength = associatedPathLocations.back() + (inputPoint - points.back()).mag();
+points.push_back(inputPoint);
+associatedPathLocations.push_back(pathLength);
+}
+
+/**
+This function removes the last point of the path (if there is one) and updates the associated path length without recalculating the rest of the path.
+*/
+template<class pointType> void basicLinearPath<pointType>::popBack()
+{
+if(points.size() == 0)
+{
+return;
+}
+
+points.pop_back();
+associatedPathLocations.pop_back();
+modificationCount++;
+pathLength = associatedPathLocations.size() > 0 ? associatedPathLocations.back() : 0.0;
 }
 
 /**
-This function removes the given point from the path and updates the associated path length.
+This function removes the given point from the path and updates the associated path length.  Removing the last point is constant time, while removing any other point requires the path lengths to be recalculated.
 @param inputPointIterator: The iterator pointing to the point to remove
 */
-void linearPath::removePoint(const std::list<fPoint>::iterator &inputPointIterator)
+template<class pointType> void basicLinearPath<pointType>::removePoint(const typename std::vector<pointType>::iterator &inputPointIterator)
 {
+if(inputPointIterator + 1 == points.end())
+{ //Removing the end of the path doesn't change the other lengths
+popBack();
+return;
+}
+
 points.erase(inputPointIterator);
+modificationCount++;
 recalculatePathLengths();
 }
 
@@ -29,134 +125,317 @@ This function takes a point along the path length (ranging from 0.0 to path leng
 
 @throws: This function can throw exceptions
 */
-fPoint linearPath::interpolate(double inputPathLengthLocation)
+template<class pointType> pointType basicLinearPath<pointType>::interpolate(valueType inputPathLengthLocation) const
 {
-if(inputPathLengthLocation < 0.0)
+int segmentEndIndex = 0;
+SOM_TRY
+segmentEndIndex = findSegmentEndIndex(inputPathLengthLocation);
+SOM_CATCH("Error finding path segment\n")
+
+const valueType &segmentStartLocation = associatedPathLocations[segmentEndIndex-1];
+const valueType &segmentEndLocation = associatedPathLocations[segmentEndIndex];
+
+valueType ratio = (inputPathLengthLocation - segmentStartLocation)/(segmentEndLocation - segmentStartLocation);
+
+return ratio*points[segmentEndIndex] + (1.0 - ratio)*points[segmentEndIndex-1];
+}
+
+/**
+This function takes a point along the path length (ranging from 0.0 to path length) and returns the X and Y derivative of the path at that location.
+@param inputPathLengthLocation: The location along the path length to find the derivative for
+@return: The associated derivatives (x,y)
+
+@throws: This function can throw exceptions
+*/
+template<class pointType> pointType basicLinearPath<pointType>::derivative(valueType inputPathLengthLocation) const
 {
-throw SOMException("Negative path length\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+int segmentEndIndex = 0;
+SOM_TRY
+segmentEndIndex = findSegmentEndIndex(inputPathLengthLocation);
+SOM_CATCH("Error finding path segment\n")
+
+pointType buffer = points[segmentEndIndex] - points[segmentEndIndex-1];
+buffer.normalize();
+
+return buffer;
+}
+
+/**
+This function samples the path at many locations in a single sweep, writing each coordinate into a seperate array (suitable for drawing or for filling the repeated fields of a follow_path_command).  The locations should be sorted in increasing order so that the segment search only moves forward (unsorted locations are still handled, but fall back to a binary search).  Locations outside of the path are clamped to its ends rather than causing an exception.
+@param inputPathLocations: The array of locations along the path length to sample
+@param inputNumberOfLocations: The number of locations in the array
+@param outputCoordinates: An array of pointType::numberOfElements pointers to arrays (of size inputNumberOfLocations) to place the x, y, etc coordinates in
+@return: false if the path has less than two points (output is left unchanged) or any location had to be clamped, true otherwise
+*/
+template<class pointType> bool basicLinearPath<pointType>::interpolateMany(const valueType *inputPathLocations, int inputNumberOfLocations, valueType *const *outputCoordinates) const
+{
+if(points.size() < 2 || associatedPathLocations.size() != points.size())
+{
+return false;
 }
 
-auto pointsIterator = points.begin();
-auto associatedPathLocationsIterator = associatedPathLocations.begin();
+//Find segments first (the ratios are temporarily stored in the last output array) so the interpolation loops have no branches
+valueType *ratios = outputCoordinates[pointType::numberOfElements-1];
+std::vector<int> segmentEndIndices;
+bool allLocationsOnPath = findSegmentsForLocations(inputPathLocations, inputNumberOfLocations, segmentEndIndices, ratios);
+
+const pointType *pathPoints = points.data();
+const int *endIndices = segmentEndIndices.data();
+for(int dimension = 0; dimension < pointType::numberOfElements; dimension++)
+{
+valueType *output = outputCoordinates[dimension];
+for(int i=0; i<inputNumberOfLocations; i++)
+{
+valueType start = pathPoints[endIndices[i]-1].val[dimension];
+valueType end = pathPoints[endIndices[i]].val[dimension];
+
+output[i] = start + ratios[i]*(end - start);
+}
+}
 
-auto lastPoint = points.begin();
-auto lastPointLocation = associatedPathLocations.begin();
+return allLocationsOnPath;
+}
 
-while(true)
+/**
+This function computes the normalized path derivative at many locations in a single sweep, writing each component into a seperate array.  The locations should be sorted in increasing order so that the segment search only moves forward.  Locations outside of the path are clamped to its ends rather than causing an exception.
+@param inputPathLocations: The array of locations along the path length to sample
+@param inputNumberOfLocations: The number of locations in the array
+@param outputDerivatives: An array of pointType::numberOfElements pointers to arrays (of size inputNumberOfLocations) to place the x, y, etc derivatives in
+@return: false if the path has less than two points (output is left unchanged) or any location had to be clamped, true otherwise
+*/
+template<class pointType> bool basicLinearPath<pointType>::derivativeMany(const valueType *inputPathLocations, int inputNumberOfLocations, valueType *const *outputDerivatives) const
+{
+if(points.size() < 2 || associatedPathLocations.size() != points.size())
 {
-lastPoint = pointsIterator;
-lastPointLocation = associatedPathLocationsIterator;
-pointsIterator++;
-associatedPathLocationsIterator++;
+return false;
+}
+
+std::vector<int> segmentEndIndices;
+bool allLocationsOnPath = findSegmentsForLocations(inputPathLocations, inputNumberOfLocations, segmentEndIndices, outputDerivatives[0]);
 
-if(pointsIterator == points.end() || associatedPathLocationsIterator == associatedPathLocations.end())
+//Segment lengths are already known from the cumulative lengths, so normalizing is just a divide
+const pointType *pathPoints = points.data();
+const valueType *pathLocations = associatedPathLocations.data();
+const int *endIndices = segmentEndIndices.data();
+for(int dimension = 0; dimension < pointType::numberOfElements; dimension++)
+{
+valueType *output = outputDerivatives[dimension];
+for(int i=0; i<inputNumberOfLocations; i++)
 {
-break;
+int endIndex = endIndices[i];
+valueType segmentLength = pathLocations[endIndex] - pathLocations[endIndex-1];
+
+output[i] = (pathPoints[endIndex].val[dimension] - pathPoints[endIndex-1].val[dimension])/segmentLength;
+}
+}
+
+return allLocationsOnPath;
 }
 
-if(inputPathLengthLocation > *associatedPathLocationsIterator)
-{ //The path point further along, so keep going
+/**
+This function makes a new path with the same shape as this one, but with points placed at even intervals along the path length (the last point of the path is always included).  Even intervals cut the corners of the path, so the points of this path can be kept instead, with each segment split evenly into pieces no longer than the spacing (the new path then has exactly this path's shape).
+@param inputPointSpacing: The path length distance between points in the new path (must be positive), or the maximum distance if the points are kept
+@param inputKeepPoints: True if this path's points should be kept
+@return: The resampled path (a copy of this path if it has less than two points)
+
+@throws: This function can throw exceptions
+*/
+template<class pointType> basicLinearPath<pointType> basicLinearPath<pointType>::resample(valueType inputPointSpacing, bool inputKeepPoints) const
+{
+if(!(inputPointSpacing > 0.0))
+{
+throw SOMException("Non-positive point spacing\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+if(points.size() < 2 || pathLength <= 0.0)
+{
+return *this;
+}
+
+if(inputKeepPoints)
+{
+basicLinearPath resampledPath;
+for(int i=1; i<points.size(); i++)
+{
+valueType segmentLength = associatedPathLocations[i] - associatedPathLocations[i-1];
+if(segmentLength <= 0.0)
+{ //Duplicate point
 continue;
 }
 
-double ratio = (inputPathLengthLocation - *lastPointLocation)/(*associatedPathLocationsIterator - *lastPointLocation);
+int numberOfPieces = ceil(segmentLength/inputPointSpacing);
+pointType segment = points[i] - points[i-1];
+for(int piece = 0; piece < numberOfPieces; piece++)
+{
+resampledPath.addPoint(points[i-1] + (((valueType) piece)/numberOfPieces)*segment);
+}
+}
+resampledPath.addPoint(points.back());
 
-return ratio*(*pointsIterator) + (1.0 - ratio)*(*lastPoint);
+return resampledPath;
 }
 
+//Make evenly spaced locations, ending exactly at the end of the path
+int numberOfIntervals = ceil(pathLength/inputPointSpacing);
+std::vector<valueType> locations(numberOfIntervals + 1);
+for(int i=0; i<numberOfIntervals; i++)
+{
+locations[i] = i*inputPointSpacing;
+}
+locations[numberOfIntervals] = pathLength;
 
-throw SOMException("Path location could not be found\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+std::vector<valueType> coordinates(pointType::numberOfElements*locations.size());
+valueType *coordinateArrays[pointType::numberOfElements];
+for(int dimension = 0; dimension < pointType::numberOfElements; dimension++)
+{
+coordinateArrays[dimension] = coordinates.data() + dimension*locations.size();
 }
+interpolateMany(locations.data(), locations.size(), coordinateArrays);
 
-/**
-This function takes a point along the path length (ranging from 0.0 to path length) and returns the X and Y derivative of the path at that location.
-@param inputPathLengthLocation: The location along the path length to find the derivative for
-@return: The associated derivatives (x,y)
+basicLinearPath resampledPath;
+resampledPath.points.reserve(locations.size());
+resampledPath.associatedPathLocations.reserve(locations.size());
+for(int i=0; i<locations.size(); i++)
+{
+pointType point;
+for(int dimension = 0; dimension < pointType::numberOfElements; dimension++)
+{
+point.val[dimension] = coordinateArrays[dimension][i];
+}
+resampledPath.addPoint(point);
+}
 
-@throws: This function can throw exceptions
+return resampledPath;
+}
+
+/**
+This function makes a new path with as few of this path's points as possible while keeping every removed point within the given distance of the new path (Ramer-Douglas-Peucker).  The first and last points are always kept.
+@param inputMaximumLateralError: The maximum distance permitted between a removed point and the simplified path
+@return: The simplified path
 */
-fPoint linearPath::derivative(double inputPathLengthLocation)
+template<class pointType> basicLinearPath<pointType> basicLinearPath<pointType>::simplify(valueType inputMaximumLateralError) const
 {
-if(inputPathLengthLocation < 0.0)
+if(points.size() < 3)
 {
-throw SOMException("Negative path length\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+return *this;
 }
 
-auto pointsIterator = points.begin();
-auto associatedPathLocationsIterator = associatedPathLocations.begin();
+std::vector<bool> pointIsKept(points.size(), false);
+pointIsKept.front() = true;
+pointIsKept.back() = true;
 
-auto lastPoint = points.begin();
-auto lastPointLocation = associatedPathLocations.begin();
+//Ranges (start index, end index) that still need to be checked, so deep recursion isn't needed for long paths
+std::vector<std::pair<int, int> > rangesToCheck;
+rangesToCheck.push_back(std::pair<int, int>(0, points.size() - 1));
 
-while(true)
+while(rangesToCheck.size() > 0)
+{
+int startIndex = rangesToCheck.back().first;
+int endIndex = rangesToCheck.back().second;
+rangesToCheck.pop_back();
+
+//Find the point furthest from the segment joining the ends of the range
+const pointType &start = points[startIndex];
+pointType segment = points[endIndex] - start;
+valueType segmentLengthSquared = dot(segment, segment);
+
+int furthestIndex = -1;
+valueType furthestDistanceSquared = inputMaximumLateralError*inputMaximumLateralError;
+for(int i=startIndex+1; i<endIndex; i++)
 {
-lastPoint = pointsIterator;
-lastPointLocation = associatedPathLocationsIterator;
-pointsIterator++;
-associatedPathLocationsIterator++;
+pointType offset = points[i] - start;
+valueType ratio = segmentLengthSquared > 0.0 ? dot(offset, segment)/segmentLengthSquared : 0.0;
+ratio = std::min<valueType>(std::max<valueType>(ratio, 0.0), 1.0);
 
-if(pointsIterator == points.end() || associatedPathLocationsIterator == associatedPathLocations.end())
+pointType error = offset - ratio*segment;
+valueType distanceSquared = dot(error, error);
+if(distanceSquared > furthestDistanceSquared)
 {
-break;
+furthestDistanceSquared = distanceSquared;
+furthestIndex = i;
+}
 }
 
-if(inputPathLengthLocation > *associatedPathLocationsIterator)
-{ //The path point further along, so keep going
+if(furthestIndex < 0)
+{ //Every point in range is close enough to the segment
 continue;
 }
 
-fPoint buffer = *pointsIterator - *lastPoint;
-buffer.normalize();
-
-return buffer;
+pointIsKept[furthestIndex] = true;
+rangesToCheck.push_back(std::pair<int, int>(startIndex, furthestIndex));
+rangesToCheck.push_back(std::pair<int, int>(furthestIndex, endIndex));
 }
 
+basicLinearPath simplifiedPath;
+for(int i=0; i<points.size(); i++)
+{
+if(pointIsKept[i])
+{
+simplifiedPath.addPoint(points[i]);
+}
+}
 
-throw SOMException("Path location could not be found\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+return simplifiedPath;
 }
 
 /**
 This function deletes points from segments that are below the given length (unless there are only two or fewer points left).  This can be used to smooth or linearize a path.
 @param inputMinimumSegmentLength: The minimim segment length permitted
 */
-void linearPath::regularize(double inputMinimumSegmentLength)
+template<class pointType> void basicLinearPath<pointType>::regularize(valueType inputMinimumSegmentLength)
 {
 if(points.size() <= 2)
 { //There are <= two points, so already done
 return;
 }
 
-/*
-printf("Path segment lengths: ");
-for(auto iter = associatedPathLocations.begin(); iter != associatedPathLocations.end(); iter++)
+if(associatedPathLocations.size() != points.size())
 {
-printf("%lf ",*iter);
+recalculatePathLengths();
 }
-printf("\n");
-*/
-
-//Ensure path lengths are recalculated
-SOMScopeGuard recalculationScopeGuard([&](){recalculatePathLengths();});
 
-for(auto iter = std::next(points.begin(),1); iter != points.end(); iter++)
+//Compact the kept points to the front of the arrays in one pass.  Until a point has been removed, segment lengths come straight from the cumulative lengths and nothing needs to be moved.
+int numberOfPoints = points.size();
+int numberOfRemainingPoints = numberOfPoints;
+int lastKeptIndex = 0; //Index (in the compacted arrays) of the last point kept
+for(int i=1; i < numberOfPoints; i++)
 {
-if((*std::prev(iter, 1)).distance(&(*iter)) <= inputMinimumSegmentLength && points.size() > 2)
+bool previousPointWasKept = (lastKeptIndex == i - 1);
+valueType segmentLength = previousPointWasKept ? associatedPathLocations[i] - associatedPathLocations[i-1] : points[lastKeptIndex].distance(points[i]);
+
+if(segmentLength <= inputMinimumSegmentLength && numberOfRemainingPoints > 2)
 { //Delete segment point unless the segment is longer than the limit or there are only two points
-auto pointToDelete = iter;
-iter = std::prev(iter, 1); //Move iter back to previous point
-points.erase(pointToDelete);
+numberOfRemainingPoints--;
+continue;
 }
+
+lastKeptIndex++;
+if(!previousPointWasKept)
+{ //Shift the point back over the removed ones and fix its length
+associatedPathLocations[lastKeptIndex] = associatedPathLocations[lastKeptIndex-1] + segmentLength;
+points[lastKeptIndex] = points[i];
+}
+}
+
+if(numberOfRemainingPoints == numberOfPoints)
+{ //Nothing removed
+return;
 }
 
+points.resize(numberOfRemainingPoints);
+associatedPathLocations.resize(numberOfRemainingPoints);
+pathLength = associatedPathLocations.back();
+modificationCount++;
 }
 
 /**
 This function deletes all of the points in the path.
 */
-void linearPath::clear()
+template<class pointType> void basicLinearPath<pointType>::clear()
 {
 pathLength = 0.0;
 points.clear();
+modificationCount++;
 associatedPathLocations.clear();
 }
 
@@ -164,61 +443,135 @@ associatedPathLocations.clear();
 This function removes points and interpolates to make the path <= to the given length.
 @param inputPathLength: The path length to truncate the path to
 */
-void linearPath::truncate(double inputPathLength)
+template<class pointType> void basicLinearPath<pointType>::truncate(valueType inputPathLength)
 {
 if(pathLength < inputPathLength || inputPathLength < 0.0)
 {//Already meets requirements
 return;
 }
 
-//Path is longer than required, so interpolate a point that meets the requirement, find the first point that is further along than the requirement then remove all points past the requirement and add the interpolated point to the path
-fPoint interpolationPoint = interpolate(inputPathLength);
+//Path is longer than required, so find the first point that is further along than the requirement with a binary search, then remove it and all points after it and add an interpolated point to make up the rest of the length
+int firstPointPastIndex = std::upper_bound(associatedPathLocations.begin(), associatedPathLocations.end(), inputPathLength) - associatedPathLocations.begin();
 
-auto locationIter = associatedPathLocations.begin();
-for(auto pointIter = points.begin(); pointIter != points.end() && locationIter != associatedPathLocations.end(); (pointIter++, locationIter++))
-{
-if(*locationIter <= inputPathLength)
-{ //Not there yet
-continue;
+if(firstPointPastIndex >= associatedPathLocations.size() || firstPointPastIndex == 0)
+{ //Path ends exactly at the given length
+return;
 }
 
-//Found first point past, so start deleting
-auto pointToDelete = pointIter;
-pointIter++; //Move past so the iterator is not affected
-points.erase(pointToDelete);
-pointIter--;
-}
+const valueType &segmentStartLocation = associatedPathLocations[firstPointPastIndex-1];
+valueType ratio = (inputPathLength - segmentStartLocation)/(associatedPathLocations[firstPointPastIndex] - segmentStartLocation);
+pointType interpolationPoint = ratio*points[firstPointPastIndex] + (1.0 - ratio)*points[firstPointPastIndex-1];
+
+//The lengths of the remaining points are unchanged, so just cut both arrays
+points.resize(firstPointPastIndex);
+associatedPathLocations.resize(firstPointPastIndex);
+pathLength = associatedPathLocations.back();
+modificationCount++;
 
-//Add the interpolated point to make the path meet the requirement exactly
+if(ratio > 0.0)
+{ //Add the interpolated point to make the path meet the requirement exactly (unless it ends on a point already)
 addPoint(interpolationPoint);
 }
+}
 
 /**
 This function recalculates the path lengths based on the current points.
 */
-void linearPath::recalculatePathLengths()
+template<class pointType> void basicLinearPath<pointType>::recalculatePathLengths()
 {
 pathLength = 0.0;
 associatedPathLocations.clear();
 
-auto pointsIterator = points.begin();
-auto lastPoint = points.begin();
+if(points.size() == 0)
+{
+return;
+}
+
+//First point has a length of zero, the rest are computed in a batch
+associatedPathLocations.resize(points.size());
+computeCumulativeLengths(points.data(), points.size(), associatedPathLocations.data());
 
-//Add first length of zero for first point
-associatedPathLocations.push_back(0.0);
+pathLength = associatedPathLocations.back();
+}
+
+/**
+This function finds the segment of the path that contains the given path location using a binary search of the cumulative path lengths.
+@param inputPathLengthLocation: The location along the path length to find the segment for
+@return: The index of the point at the end of the segment (the segment starts at index - 1)
 
-while(true)
+@throws: This function can throw exceptions
+*/
+template<class pointType> int basicLinearPath<pointType>::findSegmentEndIndex(valueType inputPathLengthLocation) const
+{
+if(inputPathLengthLocation < 0.0)
 {
-lastPoint = pointsIterator;
-pointsIterator++;
+throw SOMException("Negative path length\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
 
-if(pointsIterator == points.end())
+if(points.size() < 2 || associatedPathLocations.size() != points.size())
 {
-break;
+throw SOMException("Path location could not be found\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
 }
 
-associatedPathLocations.push_back((*lastPoint).distance(&(*pointsIterator)) + *std::prev(associatedPathLocations.end()));
+//First segment end whose location is >= the requested location
+auto segmentEndIterator = std::lower_bound(associatedPathLocations.begin() + 1, associatedPathLocations.end(), inputPathLengthLocation);
+
+if(segmentEndIterator == associatedPathLocations.end())
+{
+throw SOMException("Path location could not be found\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
 }
 
-pathLength = *std::prev(associatedPathLocations.end());
+return segmentEndIterator - associatedPathLocations.begin();
 }
+
+/**
+This function sweeps through the given locations and finds the end index of the segment each falls in, along with how far along that segment it is.
+@param inputPathLocations: The array of locations along the path length
+@param inputNumberOfLocations: The number of locations in the array
+@param outputSegmentEndIndices: The vector to store the segment end index for each location in
+@param outputSegmentRatios: The array (of size inputNumberOfLocations) to store the fraction of the way along the segment each location is
+@return: true if none of the locations had to be clamped to the path
+*/
+template<class pointType> bool basicLinearPath<pointType>::findSegmentsForLocations(const valueType *inputPathLocations, int inputNumberOfLocations, std::vector<int> &outputSegmentEndIndices, valueType *outputSegmentRatios) const
+{
+outputSegmentEndIndices.resize(inputNumberOfLocations > 0 ? inputNumberOfLocations : 0);
+
+bool allLocationsOnPath = true;
+int lastIndex = associatedPathLocations.size() - 1;
+int segmentEndIndex = 1;
+valueType previousLocation = 0.0;
+for(int i=0; i<inputNumberOfLocations; i++)
+{
+valueType location = inputPathLocations[i];
+
+if(location < 0.0 || location > pathLength)
+{
+allLocationsOnPath = false;
+location = std::min<valueType>(std::max<valueType>(location, 0.0), pathLength);
+}
+
+if(location < previousLocation)
+{ //Out of order, so restart the search for this location
+segmentEndIndex = std::lower_bound(associatedPathLocations.begin() + 1, associatedPathLocations.end(), location) - associatedPathLocations.begin();
+segmentEndIndex = std::min(segmentEndIndex, lastIndex);
+}
+
+//Merge with the cumulative lengths, only ever moving forward
+while(segmentEndIndex < lastIndex && associatedPathLocations[segmentEndIndex] < location)
+{
+segmentEndIndex++;
+}
+
+outputSegmentEndIndices[i] = segmentEndIndex;
+outputSegmentRatios[i] = (location - associatedPathLocations[segmentEndIndex-1])/(associatedPathLocations[segmentEndIndex] - associatedPathLocations[segmentEndIndex-1]);
+previousLocation = location;
+}
+
+return allLocationsOnPath;
+}
+
+//Instantiate the path types used in the rest of the library
+template class soaringPen::basicLinearPath<fPoint>;
+template class soaringPen::basicLinearPath<fPoint3D>;
+template class soaringPen::basicLinearPath<fPoint2DFloat>;
+template class soaringPen::basicLinearPath<fPoint3DFloat>;
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "fPoint.hpp"
-#include<list>
+#include<vector>
+#include<algorithm>
+#include<tuple>
+#include<type_traits>
 #include "SOMException.hpp"
 #include "SOMScopeGuard.hpp"
 
@@ -14,22 +17,60 @@ namespace soaringPen
 
 /**
 This class is intended to represent a linearly interpolated path, defined by a set of points.  It is capable of computing its length as well as its location and x,y derivate along the path.
+
+The class is a template over the point type (see fPoint.hpp), so paths can have any number of dimensions and use float or double precision.  The definitions are in linearPath.cpp, which instantiates the paths for the point typedefs in fPoint.hpp.
+
+The points and their cumulative path lengths are stored in contiguous arrays so that the segment associated with a path location can be found with a binary search.
 */
-class linearPath
+template<class pointType> class basicLinearPath
 {
 public:
+typedef typename pointType::valueType valueType;
+/**
+This class remembers where it is on a path, so that a sequence of nearby path locations (such as the steadily increasing location of a drone following the path) can be looked up in amortized constant time rather than searching the whole path each time.  The cursor holds a pointer to the path, so the path must outlive it.  Points may be added to or removed from the path while the cursor is in use.
+*/
+class cursor
+{
+public:
+/**
+This function initializes the cursor at the start of the given path.
+@param inputPath: The path to move along
+*/
+cursor(const basicLinearPath &inputPath);
+
+/**
+This function moves the cursor to the given location on the path (forward or backward) and returns everything needed to follow the path at that location.
+@param inputPathLengthLocation: The location along the path length to move to (ranging from 0.0 to path length)
+@return: <point at location, normalized derivative (x,y) at location, path length remaining after location>
+
+@throws: This function can throw exceptions
+*/
+std::tuple<pointType, pointType, valueType> moveTo(valueType inputPathLengthLocation);
+
+const basicLinearPath *path;
+int segmentEndIndex = 1; //The index of the point at the end of the current segment
+
+private:
+static const int MAXIMUM_NUMBER_OF_STEPS_BEFORE_SEARCH = 8; //How far to walk along the path before it is faster to binary search
+};
+
 
 /**
-This function adds a point to the path and updates the associated path length.
+This function adds a point to the path and updates the associated path length.  Only the length of the new segment is computed, so building a path point by point is linear time.
 @param inputPoint: The point to add
 */
-void addPoint(const fPoint &inputPoint);
+void addPoint(const pointType &inputPoint);
+
+/**
+This function removes the last point of the path (if there is one) and updates the associated path length without recalculating the rest of the path.
+*/
+void popBack();
 
 /**
-This function removes the given point from the path and updates the associated path length.
+This function removes the given point from the path and updates the associated path length.  Removing the last point is constant time, while removing any other point requires the path lengths to be recalculated.
 @param inputPointIterator: The iterator pointing to the point to remove
 */
-void removePoint(const std::list<fPoint>::iterator &inputPointIterator); 
+void removePoint(const typename std::vector<pointType>::iterator &inputPointIterator); 
 
 /**
 This function takes a point along the path length (ranging from 0.0 to path length) and returns a point between the two points that define the linear arc at that place on the path corresponding to the path length location.
@@ -38,22 +79,85 @@ This function takes a point along the path length (ranging from 0.0 to path leng
 
 @throws: This function can throw exceptions
 */
-fPoint interpolate(double inputPathLengthLocation);
+pointType interpolate(valueType inputPathLengthLocation) const;
 
 /**
 This function takes a point along the path length (ranging from 0.0 to path length) and returns the X and Y derivative of the path at that location.
 @param inputPathLengthLocation: The location along the path length to find the derivative for
-@return: The associated derivatives (x,y)
+@return: The associated derivatives (x,y,etc)
 
 @throws: This function can throw exceptions
 */
-fPoint derivative(double inputPathLengthLocation);
+pointType derivative(valueType inputPathLengthLocation) const;
+
+/**
+This function samples the path at many locations in a single sweep, writing each coordinate into a seperate array (suitable for drawing or for filling the repeated fields of a follow_path_command).  The locations should be sorted in increasing order so that the segment search only moves forward (unsorted locations are still handled, but fall back to a binary search).  Locations outside of the path are clamped to its ends rather than causing an exception.
+@param inputPathLocations: The array of locations along the path length to sample
+@param inputNumberOfLocations: The number of locations in the array
+@param outputCoordinates: An array of pointType::numberOfElements pointers to arrays (of size inputNumberOfLocations) to place the x, y, etc coordinates in
+@return: false if the path has less than two points (output is left unchanged) or any location had to be clamped, true otherwise
+*/
+bool interpolateMany(const valueType *inputPathLocations, int inputNumberOfLocations, valueType *const *outputCoordinates) const;
+
+/**
+This function samples a 2D path at many locations in a single sweep, writing the x and y coordinates into seperate arrays.  See the general version for details.
+@param inputPathLocations: The array of locations along the path length to sample
+@param inputNumberOfLocations: The number of locations in the array
+@param outputXCoordinates: The array (of size inputNumberOfLocations) to place the x coordinates in
+@param outputYCoordinates: The array (of size inputNumberOfLocations) to place the y coordinates in
+@return: false if the path has less than two points (output is left unchanged) or any location had to be clamped, true otherwise
+*/
+template<class pathPointType = pointType, typename std::enable_if<pathPointType::numberOfElements == 2, int>::type = 0> bool interpolateMany(const valueType *inputPathLocations, int inputNumberOfLocations, valueType *outputXCoordinates, valueType *outputYCoordinates) const
+{
+valueType *outputCoordinates[2] = {outputXCoordinates, outputYCoordinates};
+return interpolateMany(inputPathLocations, inputNumberOfLocations, outputCoordinates);
+}
+
+/**
+This function computes the normalized path derivative at many locations in a single sweep, writing each component into a seperate array.  The locations should be sorted in increasing order so that the segment search only moves forward.  Locations outside of the path are clamped to its ends rather than causing an exception.
+@param inputPathLocations: The array of locations along the path length to sample
+@param inputNumberOfLocations: The number of locations in the array
+@param outputDerivatives: An array of pointType::numberOfElements pointers to arrays (of size inputNumberOfLocations) to place the x, y, etc derivatives in
+@return: false if the path has less than two points (output is left unchanged) or any location had to be clamped, true otherwise
+*/
+bool derivativeMany(const valueType *inputPathLocations, int inputNumberOfLocations, valueType *const *outputDerivatives) const;
+
+/**
+This function computes the normalized derivative of a 2D path at many locations in a single sweep, writing the x and y components into seperate arrays.  See the general version for details.
+@param inputPathLocations: The array of locations along the path length to sample
+@param inputNumberOfLocations: The number of locations in the array
+@param outputXDerivatives: The array (of size inputNumberOfLocations) to place the x derivatives in
+@param outputYDerivatives: The array (of size inputNumberOfLocations) to place the y derivatives in
+@return: false if the path has less than two points (output is left unchanged) or any location had to be clamped, true otherwise
+*/
+template<class pathPointType = pointType, typename std::enable_if<pathPointType::numberOfElements == 2, int>::type = 0> bool derivativeMany(const valueType *inputPathLocations, int inputNumberOfLocations, valueType *outputXDerivatives, valueType *outputYDerivatives) const
+{
+valueType *outputDerivatives[2] = {outputXDerivatives, outputYDerivatives};
+return derivativeMany(inputPathLocations, inputNumberOfLocations, outputDerivatives);
+}
+
+/**
+This function makes a new path with the same shape as this one, but with points placed at even intervals along the path length (the last point of the path is always included).  Even intervals cut the corners of the path, so the points of this path can be kept instead, with each segment split evenly into pieces no longer than the spacing (the new path then has exactly this path's shape).
+@param inputPointSpacing: The path length distance between points in the new path (must be positive), or the maximum distance if the points are kept
+@param inputKeepPoints: True if this path's points should be kept
+@return: The resampled path (a copy of this path if it has less than two points)
+
+@throws: This function can throw exceptions
+*/
+basicLinearPath resample(valueType inputPointSpacing, bool inputKeepPoints = false) const;
+
+/**
+This function makes a new path with as few of this path's points as possible while keeping every removed point within the given distance of the new path (Ramer-Douglas-Peucker).  The first and last points are always kept.
+@param inputMaximumLateralError: The maximum distance permitted between a removed point and the simplified path
+@return: The simplified path
+*/
+basicLinearPath simplify(valueType inputMaximumLateralError) const;
 
 /**
 This function deletes points from segments that are below the given length (unless there are only two or fewer points left).  This can be used to smooth or linearize a path.
 @param inputMinimumSegmentLength: The minimim segment length permitted
 */
-void regularize(double inputMinimumSegmentLength);
+void regularize(valueType inputMinimumSegmentLength);
 
 /**
 This function deletes all of the points in the path.
@@ -64,19 +168,45 @@ void clear();
 This function removes points and interpolates to make the path <= to the given length.
 @param inputPathLength: The path length to truncate the path to
 */
-void truncate(double inputPathLength);
+void truncate(valueType inputPathLength);
 
-double pathLength = 0.0;
-std::list<fPoint> points;
-std::list<double> associatedPathLocations; //Where on the parametric path they fall
+valueType pathLength = 0.0;
+std::vector<pointType> points;
+std::vector<valueType> associatedPathLocations; //Where on the parametric path they fall (cumulative length, same size as points)
+unsigned long modificationCount = 0; //Incremented whenever points are removed from the path (appending points does not change it), so that derived structures know when to rebuild
 
 private:
+/**
+This function finds the segment of the path that contains the given path location using a binary search of the cumulative path lengths.
+@param inputPathLengthLocation: The location along the path length to find the segment for
+@return: The index of the point at the end of the segment (the segment starts at index - 1)
+
+@throws: This function can throw exceptions
+*/
+int findSegmentEndIndex(valueType inputPathLengthLocation) const;
+
+/**
+This function sweeps through the given locations and finds the end index of the segment each falls in, along with how far along that segment it is.
+@param inputPathLocations: The array of locations along the path length
+@param inputNumberOfLocations: The number of locations in the array
+@param outputSegmentEndIndices: The vector to store the segment end index for each location in
+@param outputSegmentRatios: The array (of size inputNumberOfLocations) to store the fraction of the way along the segment each location is
+@return: true if none of the locations had to be clamped to the path
+*/
+bool findSegmentsForLocations(const valueType *inputPathLocations, int inputNumberOfLocations, std::vector<int> &outputSegmentEndIndices, valueType *outputSegmentRatios) const;
+
 /**
 This function recalculates the path lengths based on the current points.
 */
 void recalculatePathLengths();
 };
 
+typedef basicLinearPath<fPoint> linearPath;
+typedef basicLinearPath<fPoint3D> linearPath3D; //For paths with target altitudes
+typedef basicLinearPath<fPoint2DFloat> linearPath2DFloat; //For long path histories where memory matters more than precision
+typedef basicLinearPath<fPoint3DFloat> linearPath3DFloat;
+
+
 
 
 
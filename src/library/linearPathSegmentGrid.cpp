@@ -0,0 +1,204 @@
+#include "linearPathSegmentGrid.hpp"
+
+using namespace soaringPen;
+
+/**
+This function initializes the grid for the given path.
+@param inputPath: The path to index
+@param inputCellSize: The width/height of the grid cells (should be a few times the typical segment length)
+
+@throws: This function can throw exceptions
+*/
+linearPathSegmentGrid::linearPathSegmentGrid(const linearPath &inputPath, double inputCellSize) : path(&inputPath), cellSize(inputCellSize)
+{
+if(!(inputCellSize > 0.0))
+{
+throw SOMException("Non-positive grid cell size\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+indexedModificationCount = path->modificationCount;
+}
+
+/**
+This function adds any segments that have been appended to the path since the last update (or rebuilds the grid if points have been removed).
+*/
+void linearPathSegmentGrid::update()
+{
+if(indexedModificationCount != path->modificationCount || numberOfIndexedPoints > path->points.size())
+{ //Points have been removed, so start over
+cells.clear();
+numberOfIndexedPoints = 0;
+minimumCellX = minimumCellY = 0;
+maximumCellX = maximumCellY = -1;
+indexedModificationCount = path->modificationCount;
+}
+
+for(int i=std::max(numberOfIndexedPoints, 1); i < path->points.size(); i++)
+{
+addSegment(i);
+}
+
+numberOfIndexedPoints = path->points.size();
+}
+
+/**
+This function finds the point on the path closest to the given point, updating the grid first if the path has changed.
+@param inputPoint: The point to find the closest path point to
+@return: <distance from the path (cross track error), path length location of the closest point, closest point>
+
+@throws: This function can throw exceptions
+*/
+std::tuple<double, double, fPoint> linearPathSegmentGrid::findNearestPoint(const fPoint &inputPoint)
+{
+update();
+
+const std::vector<fPoint> &points = path->points;
+const std::vector<double> &locations = path->associatedPathLocations;
+
+if(points.size() < 2 || locations.size() != points.size())
+{
+throw SOMException("Path has no segments\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+if(!std::isfinite(inputPoint.val[0]) || !std::isfinite(inputPoint.val[1]))
+{
+throw SOMException("Non-finite query point\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+int64_t queryCellX = clampedCellCoordinate(inputPoint.val[0], minimumCellX, maximumCellX);
+int64_t queryCellY = clampedCellCoordinate(inputPoint.val[1], minimumCellY, maximumCellY);
+
+double closestDistanceSquared = INFINITY;
+double closestLocation = 0.0;
+fPoint closestPoint;
+
+//Search rings of cells around the query cell until nothing closer can be in the next ring
+for(int64_t ring = 0; ; ring++)
+{
+//Only visit the part of the ring that overlaps the occupied cells
+for(int64_t cellX = std::max(queryCellX - ring, minimumCellX); cellX <= std::min(queryCellX + ring, maximumCellX); cellX++)
+{
+//Only the top/bottom of the ring need to be checked unless on the left/right side
+bool sideOfRing = cellX == queryCellX - ring || cellX == queryCellX + ring;
+int64_t cellYStep = sideOfRing ? 1 : std::max<int64_t>(2*ring, 1);
+int64_t firstCellY = sideOfRing ? std::max(queryCellY - ring, minimumCellY) : queryCellY - ring;
+for(int64_t cellY = firstCellY; cellY <= std::min(queryCellY + ring, maximumCellY); cellY += cellYStep)
+{
+if(cellY < minimumCellY || cellY > maximumCellY)
+{
+continue;
+}
+
+auto cellIterator = cells.find(cellKey(cellX, cellY));
+if(cellIterator == cells.end())
+{
+continue;
+}
+
+for(int segmentEndIndex : cellIterator->second)
+{
+const fPoint &start = points[segmentEndIndex-1];
+fPoint segment = points[segmentEndIndex] - start;
+double segmentLengthSquared = dot(segment, segment);
+double ratio = segmentLengthSquared > 0.0 ? dot(inputPoint - start, segment)/segmentLengthSquared : 0.0;
+ratio = std::min(std::max(ratio, 0.0), 1.0);
+
+fPoint candidatePoint = start + ratio*segment;
+fPoint offset = inputPoint - candidatePoint;
+double distanceSquared = dot(offset, offset);
+if(distanceSquared < closestDistanceSquared)
+{
+closestDistanceSquared = distanceSquared;
+closestLocation = locations[segmentEndIndex-1] + ratio*(locations[segmentEndIndex] - locations[segmentEndIndex-1]);
+closestPoint = candidatePoint;
+}
+}
+}
+}
+
+//Every cell in the next ring is at least ring*cellSize away
+double searchedDistance = ring*cellSize;
+if(closestDistanceSquared <= searchedDistance*searchedDistance)
+{
+break;
+}
+
+if(queryCellX - ring <= minimumCellX && queryCellX + ring >= maximumCellX && queryCellY - ring <= minimumCellY && queryCellY + ring >= maximumCellY)
+{ //Every occupied cell has been checked
+break;
+}
+}
+
+return std::tuple<double, double, fPoint>(sqrt(closestDistanceSquared), closestLocation, closestPoint);
+}
+
+/**
+This function returns the key of the grid cell at the given cell coordinates.
+@param inputCellX: The x index of the cell
+@param inputCellY: The y index of the cell
+@return: The key for the cells map
+*/
+int64_t linearPathSegmentGrid::cellKey(int64_t inputCellX, int64_t inputCellY)
+{
+return (int64_t) ((((uint64_t) inputCellX) << 32) ^ (((uint64_t) inputCellY) & 0xFFFFFFFF)); //Unsigned, since shifting negative numbers left is undefined
+}
+
+/**
+This function returns the grid cell coordinate that the given coordinate falls in.
+@param inputCoordinate: The coordinate to convert
+@return: The cell coordinate
+*/
+int64_t linearPathSegmentGrid::cellCoordinate(double inputCoordinate) const
+{
+return (int64_t) floor(inputCoordinate/cellSize);
+}
+
+/**
+This function returns the grid cell coordinate that the given coordinate falls in, limited to one cell beyond the given range.  Cells that far out are no closer to the occupied cells than the actual cell, so this keeps far off queries from searching (or overflowing to) cells that can't hold anything.
+@param inputCoordinate: The coordinate to convert (must be finite)
+@param inputMinimumCell: The smallest occupied cell coordinate
+@param inputMaximumCell: The largest occupied cell coordinate
+@return: The cell coordinate
+*/
+int64_t linearPathSegmentGrid::clampedCellCoordinate(double inputCoordinate, int64_t inputMinimumCell, int64_t inputMaximumCell) const
+{
+//Clamp before converting, since converting an out of range double to an integer is undefined
+double cellCoordinate = floor(inputCoordinate/cellSize);
+return (int64_t) std::min(std::max(cellCoordinate, (double) (inputMinimumCell - 1)), (double) (inputMaximumCell + 1));
+}
+
+/**
+This function adds the segment ending at the given point index to every cell its bounding box overlaps.
+@param inputSegmentEndIndex: The index of the point at the end of the segment
+*/
+void linearPathSegmentGrid::addSegment(int inputSegmentEndIndex)
+{
+const fPoint &start = path->points[inputSegmentEndIndex-1];
+const fPoint &end = path->points[inputSegmentEndIndex];
+
+int64_t startCellX = cellCoordinate(std::min(start.val[0], end.val[0]));
+int64_t endCellX = cellCoordinate(std::max(start.val[0], end.val[0]));
+int64_t startCellY = cellCoordinate(std::min(start.val[1], end.val[1]));
+int64_t endCellY = cellCoordinate(std::max(start.val[1], end.val[1]));
+
+if(maximumCellX < minimumCellX)
+{ //First segment
+minimumCellX = startCellX;
+maximumCellX = endCellX;
+minimumCellY = startCellY;
+maximumCellY = endCellY;
+}
+
+minimumCellX = std::min(minimumCellX, startCellX);
+maximumCellX = std::max(maximumCellX, endCellX);
+minimumCellY = std::min(minimumCellY, startCellY);
+maximumCellY = std::max(maximumCellY, endCellY);
+
+for(int64_t cellX = startCellX; cellX <= endCellX; cellX++)
+{
+for(int64_t cellY = startCellY; cellY <= endCellY; cellY++)
+{
+cells[cellKey(cellX, cellY)].push_back(inputSegmentEndIndex);
+}
+}
+}
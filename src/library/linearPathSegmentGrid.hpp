@@ -0,0 +1,89 @@
+#pragma once
+
+#include "linearPath.hpp"
+#include<unordered_map>
+#include<vector>
+#include<tuple>
+#include<cstdint>
+#include "SOMException.hpp"
+
+namespace soaringPen
+{
+
+/**
+This class is a spatial index over the segments of a linearPath, made by placing each segment in the cells of a uniform grid that its bounding box overlaps.  It allows the point on the path nearest to a given point (such as the drone's reported position) to be found by only checking the segments in nearby cells rather than every segment of the path.
+
+Segments appended to the path are added to the grid incrementally the next time it is used.  If points are removed from the path (detected via linearPath::modificationCount), the grid is rebuilt.  The grid holds a pointer to the path, so the path must outlive it.
+*/
+class linearPathSegmentGrid
+{
+public:
+/**
+This function initializes the grid for the given path.
+@param inputPath: The path to index
+@param inputCellSize: The width/height of the grid cells (should be a few times the typical segment length)
+
+@throws: This function can throw exceptions
+*/
+linearPathSegmentGrid(const linearPath &inputPath, double inputCellSize);
+
+/**
+This function adds any segments that have been appended to the path since the last update (or rebuilds the grid if points have been removed).
+*/
+void update();
+
+/**
+This function finds the point on the path closest to the given point, updating the grid first if the path has changed.
+@param inputPoint: The point to find the closest path point to
+@return: <distance from the path (cross track error), path length location of the closest point, closest point>
+
+@throws: This function can throw exceptions
+*/
+std::tuple<double, double, fPoint> findNearestPoint(const fPoint &inputPoint);
+
+const linearPath *path;
+double cellSize;
+
+private:
+/**
+This function returns the key of the grid cell at the given cell coordinates.
+@param inputCellX: The x index of the cell
+@param inputCellY: The y index of the cell
+@return: The key for the cells map
+*/
+static int64_t cellKey(int64_t inputCellX, int64_t inputCellY);
+
+/**
+This function returns the grid cell coordinate that the given coordinate falls in.
+@param inputCoordinate: The coordinate to convert
+@return: The cell coordinate
+*/
+int64_t cellCoordinate(double inputCoordinate) const;
+
+/**
+This function returns the grid cell coordinate that the given coordinate falls in, limited to one cell beyond the given range.  Cells that far out are no closer to the occupied cells than the actual cell, so this keeps far off queries from searching (or overflowing to) cells that can't hold anything.
+@param inputCoordinate: The coordinate to convert (must be finite)
+@param inputMinimumCell: The smallest occupied cell coordinate
+@param inputMaximumCell: The largest occupied cell coordinate
+@return: The cell coordinate
+*/
+int64_t clampedCellCoordinate(double inputCoordinate, int64_t inputMinimumCell, int64_t inputMaximumCell) const;
+
+/**
+This function adds the segment ending at the given point index to every cell its bounding box overlaps.
+@param inputSegmentEndIndex: The index of the point at the end of the segment
+*/
+void addSegment(int inputSegmentEndIndex);
+
+std::unordered_map<int64_t, std::vector<int> > cells; //Cell key -> indices of the points at the end of the segments in the cell
+int numberOfIndexedPoints = 0;
+unsigned long indexedModificationCount = 0;
+
+//Range of cells that have segments in them
+int64_t minimumCellX = 0;
+int64_t maximumCellX = -1;
+int64_t minimumCellY = 0;
+int64_t maximumCellY = -1;
+};
+
+}
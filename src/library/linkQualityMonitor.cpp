@@ -0,0 +1,163 @@
+#include "linkQualityMonitor.hpp"
+
+using namespace soaringPen;
+
+/**
+This function returns the current time of the monotonic (steady) clock, which is what link_probe times are measured with.
+@return: Microseconds since an arbitrary (per machine) epoch
+*/
+int64_t soaringPen::monotonicMicroseconds()
+{
+return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+This function initializes the monitor.
+@param inputProbeTimeout: How long (seconds) to wait for the response to a probe before counting it as lost
+@param inputClockFilterSize: The number of recent responses that the clock offset estimate is chosen from
+
+@throws: This function can throw exceptions
+*/
+linkQualityMonitor::linkQualityMonitor(double inputProbeTimeout, int inputClockFilterSize) : probeTimeout(inputProbeTimeout*1e6), clockFilterSize(inputClockFilterSize)
+{
+if(!(inputProbeTimeout > 0.0) || inputClockFilterSize <= 0)
+{
+throw SOMException("Non-positive probe timeout or clock filter size\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+}
+
+/**
+This function makes a new probe (ping) to send and starts waiting for its response.
+@param inputCurrentTime: The current time (monotonicMicroseconds)
+@return: The probe to send
+*/
+link_probe linkQualityMonitor::createProbe(int64_t inputCurrentTime)
+{
+link_probe probe;
+probe.set_sequence_number(nextSequenceNumber);
+probe.set_origin_time(inputCurrentTime);
+
+outstandingProbes[nextSequenceNumber] = inputCurrentTime;
+nextSequenceNumber++;
+statistics.numberOfProbesSent++;
+
+return probe;
+}
+
+/**
+This function updates the statistics with a response (pong) to one of the probes.
+@param inputResponse: The probe sent back, with the receive and transmit times filled in
+@param inputReceiveTime: The time (monotonicMicroseconds) the response was received
+@return: true if the response was used, false if it was for an unknown or already expired probe
+
+@throws: This function can throw exceptions (such as if the response is missing times)
+*/
+bool linkQualityMonitor::processResponse(const link_probe &inputResponse, int64_t inputReceiveTime)
+{
+if(!inputResponse.has_sequence_number() || !inputResponse.has_origin_time() || !inputResponse.has_receive_time() || !inputResponse.has_transmit_time())
+{
+throw SOMException("Link probe response is missing fields\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+auto outstandingProbe = outstandingProbes.find(inputResponse.sequence_number());
+if(outstandingProbe == outstandingProbes.end() || outstandingProbe->second != inputResponse.origin_time())
+{ //Late (already counted as lost), duplicated or not one of ours
+return false;
+}
+outstandingProbes.erase(outstandingProbe);
+
+//t0-t3 as in NTP
+int64_t t0 = inputResponse.origin_time();
+int64_t t1 = inputResponse.receive_time();
+int64_t t2 = inputResponse.transmit_time();
+int64_t t3 = inputReceiveTime;
+
+int64_t roundTripTime = std::max<int64_t>((t3 - t0) - (t2 - t1), 0);
+int64_t offset = ((t1 - t0) + (t2 - t3))/2;
+
+clockFilterSamples.emplace_back(roundTripTime, offset);
+if(clockFilterSamples.size() > clockFilterSize)
+{
+clockFilterSamples.pop_front();
+}
+
+//Least delayed sample has the least uncertain offset
+auto bestSample = clockFilterSamples.begin();
+for(auto iter = clockFilterSamples.begin(); iter != clockFilterSamples.end(); iter++)
+{
+if(iter->first < bestSample->first)
+{
+bestSample = iter;
+}
+}
+clockOffset = bestSample->second;
+
+double roundTripTimeSeconds = roundTripTime/1e6;
+if(statistics.numberOfResponses == 0)
+{
+statistics.smoothedRoundTripTime = roundTripTimeSeconds;
+statistics.minimumRoundTripTime = roundTripTimeSeconds;
+}
+else
+{ //Same gain as TCP's smoothed RTT
+statistics.smoothedRoundTripTime = .875*statistics.smoothedRoundTripTime + .125*roundTripTimeSeconds;
+statistics.minimumRoundTripTime = std::min(statistics.minimumRoundTripTime, roundTripTimeSeconds);
+}
+
+statistics.roundTripTime = roundTripTimeSeconds;
+statistics.clockOffset = clockOffset/1e6;
+statistics.clockOffsetValid = true;
+statistics.numberOfResponses++;
+updateLossFraction();
+
+return true;
+}
+
+/**
+This function counts any probes which have been waiting longer than the timeout as lost.
+@param inputCurrentTime: The current time (monotonicMicroseconds)
+*/
+void linkQualityMonitor::expireProbes(int64_t inputCurrentTime)
+{
+for(auto iter = outstandingProbes.begin(); iter != outstandingProbes.end();)
+{
+if((inputCurrentTime - iter->second) <= probeTimeout)
+{
+iter++;
+continue;
+}
+
+iter = outstandingProbes.erase(iter);
+statistics.numberOfLostProbes++;
+}
+
+updateLossFraction();
+}
+
+/**
+This function returns the current link measurements.
+@return: The statistics
+*/
+const linkQualityStatistics &linkQualityMonitor::getStatistics() const
+{
+return statistics;
+}
+
+/**
+This function converts a time measured with the controller's monotonic clock to the equivalent time on this machine's clock, using the estimated clock offset.  This allows timestamps from the controller (such as when a frame was captured) to be split into network delay and processing delay.
+@param inputControllerTime: The controller clock time (microseconds)
+@return: The local clock time (microseconds)
+*/
+int64_t linkQualityMonitor::controllerTimeToLocalTime(int64_t inputControllerTime) const
+{
+return inputControllerTime - clockOffset;
+}
+
+/**
+This function recalculates the loss fraction from the response/lost counts.
+*/
+void linkQualityMonitor::updateLossFraction()
+{
+int64_t numberOfFinishedProbes = statistics.numberOfResponses + statistics.numberOfLostProbes;
+statistics.lossFraction = numberOfFinishedProbes == 0 ? 0.0 : ((double) statistics.numberOfLostProbes)/numberOfFinishedProbes;
+}
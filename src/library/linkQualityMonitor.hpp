@@ -0,0 +1,108 @@
+#pragma once
+
+#include<map>
+#include<deque>
+#include<chrono>
+#include<algorithm>
+#include<cstdint>
+#include "SOMException.hpp"
+#include "link_probe.pb.h"
+
+namespace soaringPen
+{
+
+const double LINK_PROBE_INTERVAL = .25; //Seconds between pings sent to the controller
+const double DEFAULT_LINK_PROBE_TIMEOUT = 2.0; //Seconds to wait for a pong before the ping is counted as lost
+const int DEFAULT_CLOCK_FILTER_SIZE = 8; //The number of recent pongs that the clock offset estimate is chosen from
+
+/**
+This function returns the current time of the monotonic (steady) clock, which is what link_probe times are measured with.
+@return: Microseconds since an arbitrary (per machine) epoch
+*/
+int64_t monotonicMicroseconds();
+
+const int VIDEO_FRAME_CAPTURE_TIME_SIZE = sizeof(int64_t); //Published JPEG frames start with the time (monotonicMicroseconds on the publisher) they were captured, so subscribers can measure their delay
+
+/**
+This struct holds the measurements of the GUI/controller link made by a linkQualityMonitor.  Times are in seconds.
+*/
+struct linkQualityStatistics
+{
+int64_t numberOfProbesSent = 0;
+int64_t numberOfResponses = 0;
+int64_t numberOfLostProbes = 0; //Probes that timed out without a response
+double lossFraction = 0.0; //Lost probes/(responses + lost probes)
+double roundTripTime = 0.0; //Network round trip time of the most recent probe (time spent in the controller is excluded)
+double smoothedRoundTripTime = 0.0; //Exponential moving average of the round trip time
+double minimumRoundTripTime = 0.0;
+double clockOffset = 0.0; //Controller clock minus GUI clock
+bool clockOffsetValid = false; //True once at least one response has been received
+};
+
+/**
+This class measures the round trip time, clock offset and loss of a link using link_probe ping/pong messages.  The offset between the two clocks is estimated the way NTP does it: each pong gives an offset ((t1 - t0) + (t2 - t3))/2 which is accurate to within half of its round trip time, so the estimate used is the one from the pong with the lowest round trip time out of the last few.
+*/
+class linkQualityMonitor
+{
+public:
+/**
+This function initializes the monitor.
+@param inputProbeTimeout: How long (seconds) to wait for the response to a probe before counting it as lost
+@param inputClockFilterSize: The number of recent responses that the clock offset estimate is chosen from
+
+@throws: This function can throw exceptions
+*/
+linkQualityMonitor(double inputProbeTimeout = DEFAULT_LINK_PROBE_TIMEOUT, int inputClockFilterSize = DEFAULT_CLOCK_FILTER_SIZE);
+
+/**
+This function makes a new probe (ping) to send and starts waiting for its response.
+@param inputCurrentTime: The current time (monotonicMicroseconds)
+@return: The probe to send
+*/
+link_probe createProbe(int64_t inputCurrentTime);
+
+/**
+This function updates the statistics with a response (pong) to one of the probes.
+@param inputResponse: The probe sent back, with the receive and transmit times filled in
+@param inputReceiveTime: The time (monotonicMicroseconds) the response was received
+@return: true if the response was used, false if it was for an unknown or already expired probe
+
+@throws: This function can throw exceptions (such as if the response is missing times)
+*/
+bool processResponse(const link_probe &inputResponse, int64_t inputReceiveTime);
+
+/**
+This function counts any probes which have been waiting longer than the timeout as lost.
+@param inputCurrentTime: The current time (monotonicMicroseconds)
+*/
+void expireProbes(int64_t inputCurrentTime);
+
+/**
+This function returns the current link measurements.
+@return: The statistics
+*/
+const linkQualityStatistics &getStatistics() const;
+
+/**
+This function converts a time measured with the controller's monotonic clock to the equivalent time on this machine's clock, using the estimated clock offset.  This allows timestamps from the controller (such as when a frame was captured) to be split into network delay and processing delay.
+@param inputControllerTime: The controller clock time (microseconds)
+@return: The local clock time (microseconds)
+*/
+int64_t controllerTimeToLocalTime(int64_t inputControllerTime) const;
+
+protected:
+int64_t probeTimeout; //Microseconds
+int clockFilterSize;
+uint64_t nextSequenceNumber = 0;
+std::map<uint64_t, int64_t> outstandingProbes; //Sequence number -> origin time
+std::deque<std::pair<int64_t, int64_t> > clockFilterSamples; //<round trip time, clock offset> (microseconds) of the most recent responses
+int64_t clockOffset = 0; //Microseconds
+linkQualityStatistics statistics;
+
+/**
+This function recalculates the loss fraction from the response/lost counts.
+*/
+void updateLossFraction();
+};
+
+}
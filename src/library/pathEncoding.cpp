@@ -0,0 +1,106 @@
+#include "pathEncoding.hpp"
+
+using namespace soaringPen;
+
+/**
+This function stores the path in the given follow path command using the plain double fields (path_x_coordinates/path_y_coordinates), which every controller understands.
+@param inputPath: The path to encode
+@param outputCommand: The command to store the path in (any existing path data is replaced)
+*/
+void soaringPen::encodePath(const linearPath &inputPath, follow_path_command &outputCommand)
+{
+outputCommand.Clear();
+outputCommand.mutable_path_x_coordinates()->Reserve(inputPath.points.size());
+outputCommand.mutable_path_y_coordinates()->Reserve(inputPath.points.size());
+
+for(auto iter = inputPath.points.begin(); iter != inputPath.points.end(); iter++)
+{
+outputCommand.add_path_x_coordinates(iter->val[0]);
+outputCommand.add_path_y_coordinates(iter->val[1]);
+}
+}
+
+/**
+This function stores the path in the given follow path command using the compact quantized fields.  Each coordinate is rounded to the nearest multiple of the resolution and each point is stored as the (zigzag varint encoded) difference in steps from the previous point.
+@param inputPath: The path to encode
+@param inputResolution: The size of one quantization step (the maximum rounding error is half of this)
+@param outputCommand: The command to store the path in (any existing path data is replaced)
+
+@throws: This function can throw exceptions (non-positive resolution or coordinates too large to quantize)
+*/
+void soaringPen::encodeQuantizedPath(const linearPath &inputPath, double inputResolution, follow_path_command &outputCommand)
+{
+if(!(inputResolution > 0.0))
+{
+throw SOMException("Non-positive quantization resolution\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+outputCommand.Clear();
+outputCommand.set_quantized_path_resolution(inputResolution);
+outputCommand.mutable_quantized_path_x_deltas()->Reserve(inputPath.points.size());
+outputCommand.mutable_quantized_path_y_deltas()->Reserve(inputPath.points.size());
+
+//Differences are taken between the quantized values so that rounding errors don't accumulate along the path
+int32_t previousSteps[2] = {0, 0};
+for(const fPoint &point : inputPath.points)
+{
+int32_t steps[2];
+for(int dimension=0; dimension<2; dimension++)
+{
+double roundedSteps = round(point.val[dimension]/inputResolution);
+if(!(fabs(roundedSteps) <= std::numeric_limits<int32_t>::max()/2))
+{ //Keep differences within int32 range as well
+throw SOMException("Path coordinate too large to quantize\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+steps[dimension] = (int32_t) roundedSteps;
+}
+
+outputCommand.add_quantized_path_x_deltas(steps[0] - previousSteps[0]);
+outputCommand.add_quantized_path_y_deltas(steps[1] - previousSteps[1]);
+previousSteps[0] = steps[0];
+previousSteps[1] = steps[1];
+}
+}
+
+/**
+This function retrieves the path from a follow path command, using the quantized fields if the command has them and the double fields otherwise.
+@param inputCommand: The command to get the path from
+@return: The path (consecutive duplicate points are not removed)
+
+@throws: This function can throw exceptions (such as if the x and y fields have different sizes)
+*/
+linearPath soaringPen::decodePath(const follow_path_command &inputCommand)
+{
+linearPath path;
+
+if(inputCommand.has_quantized_path_resolution())
+{
+if(inputCommand.quantized_path_x_deltas_size() != inputCommand.quantized_path_y_deltas_size())
+{
+throw SOMException("Quantized path has different numbers of x and y coordinates\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+double resolution = inputCommand.quantized_path_resolution();
+int64_t steps[2] = {0, 0};
+for(int i=0; i<inputCommand.quantized_path_x_deltas_size(); i++)
+{
+steps[0] += inputCommand.quantized_path_x_deltas(i);
+steps[1] += inputCommand.quantized_path_y_deltas(i);
+path.addPoint(fPoint(steps[0]*resolution, steps[1]*resolution));
+}
+
+return path;
+}
+
+if(inputCommand.path_x_coordinates_size() != inputCommand.path_y_coordinates_size())
+{
+throw SOMException("Path has different numbers of x and y coordinates\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+for(int i=0; i<inputCommand.path_x_coordinates_size(); i++)
+{
+path.addPoint(fPoint(inputCommand.path_x_coordinates(i), inputCommand.path_y_coordinates(i)));
+}
+
+return path;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "linearPath.hpp"
+#include "SOMException.hpp"
+#include "follow_path_command.pb.h"
+#include<cmath>
+#include<limits>
+
+namespace soaringPen
+{
+
+const double DEFAULT_PATH_QUANTIZATION_RESOLUTION = .0001; //Normalized image coordinates per step (~1/10 of a pixel for typical camera images)
+
+/**
+This function stores the path in the given follow path command using the plain double fields (path_x_coordinates/path_y_coordinates), which every controller understands.
+@param inputPath: The path to encode
+@param outputCommand: The command to store the path in (any existing path data is replaced)
+*/
+void encodePath(const linearPath &inputPath, follow_path_command &outputCommand);
+
+/**
+This function stores the path in the given follow path command using the compact quantized fields.  Each coordinate is rounded to the nearest multiple of the resolution and each point is stored as the (zigzag varint encoded) difference in steps from the previous point.
+@param inputPath: The path to encode
+@param inputResolution: The size of one quantization step (the maximum rounding error is half of this)
+@param outputCommand: The command to store the path in (any existing path data is replaced)
+
+@throws: This function can throw exceptions (non-positive resolution or coordinates too large to quantize)
+*/
+void encodeQuantizedPath(const linearPath &inputPath, double inputResolution, follow_path_command &outputCommand);
+
+/**
+This function retrieves the path from a follow path command, using the quantized fields if the command has them and the double fields otherwise.
+@param inputCommand: The command to get the path from
+@return: The path (consecutive duplicate points are not removed)
+
+@throws: This function can throw exceptions (such as if the x and y fields have different sizes)
+*/
+linearPath decodePath(const follow_path_command &inputCommand);
+
+}
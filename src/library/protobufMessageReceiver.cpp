@@ -0,0 +1,75 @@
+#include "protobufMessageReceiver.hpp"
+
+using namespace pylongps;
+
+/**
+This function initializes the receiver to receive from the given socket.
+@param inputSocketToReceiveFrom: This is the socket to receive objects from (must outlive the receiver)
+*/
+protobufMessageReceiver::protobufMessageReceiver(zmq::socket_t &inputSocketToReceiveFrom) : socket(&inputSocketToReceiveFrom)
+{
+}
+
+/**
+This function is used to receive and deserialize a protobuf object from the socket.
+@param inputMessageBuffer: This is the buffer to place the received object in
+@param inputFlags: The flags to pass to the ZMQ socket
+@param inputPreappendedDataBuffer: The buffer to place x bytes before the message in
+@param inputPreappendedDataSize: How much data to expect to be preappended
+@param inputPostappendedDataBuffer: The buffer to place x bytes after the message in
+@param inputPostappendedDataSize: How much data to expect to be postappended
+@return: <true if message received, true if message deserialized correctly>
+
+@throws: This function can throw exceptions
+*/
+std::tuple<bool, bool> protobufMessageReceiver::receive(google::protobuf::Message &inputMessageBuffer, int inputFlags, char *inputPreappendedDataBuffer, int inputPreappendedDataSize, char *inputPostappendedDataBuffer, int inputPostappendedDataSize)
+{
+if(inputPreappendedDataSize < 0 || inputPostappendedDataSize < 0)
+{
+throw SOMException("Negative data size\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+if((inputPreappendedDataSize > 0 && inputPreappendedDataBuffer == nullptr) || (inputPostappendedDataSize > 0 && inputPostappendedDataBuffer == nullptr))
+{
+throw SOMException("Data size > 0 but buffer is nullptr\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+bool messageReceived = false;
+bool messageDeserialized = false;
+
+SOM_TRY
+messageReceived = socket->recv(&messageBuffer, inputFlags);
+SOM_CATCH("Error, unable to receive message\n")
+
+if(messageReceived == false)
+{ //Didn't get a message
+return std::tuple<bool, bool>(messageReceived, messageDeserialized);
+}
+
+if(messageBuffer.size() < ((size_t) inputPreappendedDataSize) + inputPostappendedDataSize)
+{ //Message isn't valid (smaller than expected preappended/postappended data)
+return std::tuple<bool, bool>(messageReceived, messageDeserialized);
+}
+
+const char *messageData = (const char *) messageBuffer.data();
+int protobufMessageSize = messageBuffer.size() - inputPreappendedDataSize - inputPostappendedDataSize;
+
+//Deserialize message (ParseFromArray clears the buffer first, but keeps its allocated fields to reuse)
+if(!inputMessageBuffer.ParseFromArray(messageData + inputPreappendedDataSize, protobufMessageSize))
+{ //Corrupt message or missing required fields
+return std::tuple<bool, bool>(messageReceived, messageDeserialized);
+}
+
+if(inputPreappendedDataSize > 0)
+{
+memcpy((void *) inputPreappendedDataBuffer, (const void *) messageData, inputPreappendedDataSize);
+}
+
+if(inputPostappendedDataSize > 0)
+{
+memcpy((void *) inputPostappendedDataBuffer, (const void *) (messageData + inputPreappendedDataSize + protobufMessageSize), inputPostappendedDataSize);
+}
+
+messageDeserialized = true;
+return std::tuple<bool, bool>(messageReceived, messageDeserialized);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "zmq.hpp"
+#include "SOMException.hpp"
+#include<tuple>
+#include<cstring>
+#include<google/protobuf/message.h>
+
+namespace pylongps
+{
+
+/**
+This class receives and deserializes protobuf objects from a ZMQ socket, like receiveProtobufMessage, but keeps one ZMQ message to receive into across calls.  Together with a protobuf message buffer that is reused between calls (which keeps its allocated fields), this lets a steady stream of messages be processed without allocating for each one.  The protobuf object is parsed from the bytes between the preappended and postappended data, so the object doesn't need to be reserialized to find where the postappended data starts.
+*/
+class protobufMessageReceiver
+{
+public:
+/**
+This function initializes the receiver to receive from the given socket.
+@param inputSocketToReceiveFrom: This is the socket to receive objects from (must outlive the receiver)
+*/
+protobufMessageReceiver(zmq::socket_t &inputSocketToReceiveFrom);
+
+/**
+This function is used to receive and deserialize a protobuf object from the socket.
+@param inputMessageBuffer: This is the buffer to place the received object in
+@param inputFlags: The flags to pass to the ZMQ socket
+@param inputPreappendedDataBuffer: The buffer to place x bytes before the message in
+@param inputPreappendedDataSize: How much data to expect to be preappended
+@param inputPostappendedDataBuffer: The buffer to place x bytes after the message in
+@param inputPostappendedDataSize: How much data to expect to be postappended
+@return: <true if message received, true if message deserialized correctly>
+
+@throws: This function can throw exceptions
+*/
+std::tuple<bool, bool> receive(google::protobuf::Message &inputMessageBuffer, int inputFlags = 0, char *inputPreappendedDataBuffer = nullptr, int inputPreappendedDataSize = 0, char *inputPostappendedDataBuffer = nullptr, int inputPostappendedDataSize = 0);
+
+zmq::socket_t *socket;
+
+private:
+zmq::message_t messageBuffer; //Reused for each received message
+};
+
+}
@@ -0,0 +1,278 @@
+#include "sharedMemoryFrameRing.hpp"
+
+using namespace soaringPen;
+
+/**
+This function returns true if the endpoint is a shared memory video endpoint ("shm://name").
+@param inputEndpoint: The endpoint to check
+@return: true if it starts with shm://
+*/
+bool soaringPen::isSharedMemoryEndpoint(const std::string &inputEndpoint)
+{
+return inputEndpoint.compare(0, SHARED_MEMORY_ENDPOINT_PREFIX.size(), SHARED_MEMORY_ENDPOINT_PREFIX) == 0;
+}
+
+/**
+This function returns the POSIX shared memory object name used for a shared memory video endpoint ("shm://name" -> "/name").
+@param inputEndpoint: The shared memory endpoint
+@return: The shared memory object name
+
+@throws: This function can throw exceptions (such as if the endpoint isn't a valid shared memory endpoint)
+*/
+std::string soaringPen::sharedMemoryFrameRingName(const std::string &inputEndpoint)
+{
+std::string name = inputEndpoint.substr(std::min(SHARED_MEMORY_ENDPOINT_PREFIX.size(), inputEndpoint.size()));
+if(!isSharedMemoryEndpoint(inputEndpoint) || name.size() == 0 || name.find('/') != std::string::npos)
+{
+throw SOMException("Invalid shared memory endpoint: " + inputEndpoint + "\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+return "/" + name;
+}
+
+/**
+This function returns the ZMQ endpoint that new frame notifications are published on for a shared memory video endpoint.  Only the frame numbers go through ZMQ; the frames themselves stay in shared memory.
+@param inputEndpoint: The shared memory endpoint
+@return: The ZMQ (ipc) endpoint for the notifications
+
+@throws: This function can throw exceptions (such as if the endpoint isn't a valid shared memory endpoint)
+*/
+std::string soaringPen::sharedMemoryFrameNotificationEndpoint(const std::string &inputEndpoint)
+{
+std::string ringName;
+SOM_TRY
+ringName = sharedMemoryFrameRingName(inputEndpoint);
+SOM_CATCH("Error getting ring name\n")
+
+return "ipc:///tmp" + ringName + ".notifications";
+}
+
+/**
+This function creates the ring (replacing any existing one with the same name) for publishing frames.
+@param inputName: The POSIX shared memory object name (such as "/soaringPenVideo")
+@param inputNumberOfSlots: The number of frames the ring holds
+@param inputSlotSize: The maximum size of a frame in bytes
+
+@throws: This function can throw exceptions
+*/
+sharedMemoryFrameRing::sharedMemoryFrameRing(const std::string &inputName, uint32_t inputNumberOfSlots, uint64_t inputSlotSize) : name(inputName), ownsName(true)
+{
+if(inputNumberOfSlots == 0 || inputSlotSize == 0)
+{
+throw SOMException("Frame ring needs at least one slot of non-zero size\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+uint64_t slotStride = ((sizeof(slotHeader) + inputSlotSize + 63)/64)*64; //Keep each slot header on its own cache line
+mappingSize = sizeof(ringHeader) + slotStride*inputNumberOfSlots;
+
+shm_unlink(name.c_str()); //Start from scratch, rather than inheriting a previous publisher's frames
+fileDescriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+if(fileDescriptor < 0)
+{
+throw SOMException("Unable to create shared memory object " + name + ": " + strerror(errno) + "\n", SYSTEM_ERROR, __FILE__, __LINE__);
+}
+
+if(ftruncate(fileDescriptor, mappingSize) != 0 || (mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0)) == MAP_FAILED)
+{
+mapping = nullptr;
+std::string errorString = strerror(errno);
+close(fileDescriptor);
+shm_unlink(name.c_str());
+throw SOMException("Unable to size/map shared memory object " + name + ": " + errorString + "\n", SYSTEM_ERROR, __FILE__, __LINE__);
+}
+
+//New shared memory is zeroed, which is a valid (even) sequence number/empty frame number for every slot
+header = new(mapping) ringHeader;
+header->numberOfSlots = inputNumberOfSlots;
+header->slotSize = inputSlotSize;
+header->slotStride = slotStride;
+header->latestFrameNumber.store(0, std::memory_order_relaxed);
+for(uint32_t i=0; i<inputNumberOfSlots; i++)
+{
+slotHeader *slotToInitialize = new(((char *) mapping) + sizeof(ringHeader) + slotStride*i) slotHeader;
+slotToInitialize->sequence.store(0, std::memory_order_relaxed);
+slotToInitialize->frameNumber.store(0, std::memory_order_relaxed);
+}
+
+//Readers check this last
+std::atomic_thread_fence(std::memory_order_release);
+header->magicNumber = RING_MAGIC_NUMBER;
+}
+
+/**
+This function opens an existing ring for reading frames.
+@param inputName: The POSIX shared memory object name (such as "/soaringPenVideo")
+
+@throws: This function can throw exceptions (such as if the ring doesn't exist yet)
+*/
+sharedMemoryFrameRing::sharedMemoryFrameRing(const std::string &inputName) : name(inputName), ownsName(false)
+{
+fileDescriptor = shm_open(name.c_str(), O_RDONLY, 0);
+if(fileDescriptor < 0)
+{
+throw SOMException("Unable to open shared memory object " + name + ": " + strerror(errno) + "\n", SYSTEM_ERROR, __FILE__, __LINE__);
+}
+
+struct stat fileStatus;
+if(fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size < (off_t) sizeof(ringHeader))
+{
+close(fileDescriptor);
+throw SOMException("Shared memory object " + name + " is too small to be a frame ring\n", SYSTEM_ERROR, __FILE__, __LINE__);
+}
+
+mappingSize = fileStatus.st_size;
+mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+if(mapping == MAP_FAILED)
+{
+mapping = nullptr;
+close(fileDescriptor);
+throw SOMException("Unable to map shared memory object " + name + "\n", SYSTEM_ERROR, __FILE__, __LINE__);
+}
+
+header = (ringHeader *) mapping;
+if(header->magicNumber != RING_MAGIC_NUMBER || sizeof(ringHeader) + header->slotStride*header->numberOfSlots > mappingSize)
+{
+munmap(mapping, mappingSize);
+close(fileDescriptor);
+throw SOMException("Shared memory object " + name + " isn't a (finished) frame ring\n", SYSTEM_ERROR, __FILE__, __LINE__);
+}
+std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+/**
+This function unmaps the ring (and removes its name if this object created it).
+*/
+sharedMemoryFrameRing::~sharedMemoryFrameRing()
+{
+if(mapping != nullptr)
+{
+munmap(mapping, mappingSize);
+}
+
+if(fileDescriptor >= 0)
+{
+close(fileDescriptor);
+}
+
+if(ownsName)
+{ //Readers that already have it mapped keep their mapping
+shm_unlink(name.c_str());
+}
+}
+
+/**
+This function copies a frame into the next slot of the ring.
+@param inputData: The frame's pixel data
+@param inputSize: The number of bytes of pixel data
+@param inputInformation: The frame's dimensions/type/capture time
+@return: The frame's number (frames are numbered from 1)
+
+@throws: This function can throw exceptions (such as if the frame is larger than the slots)
+*/
+uint64_t sharedMemoryFrameRing::publish(const void *inputData, uint64_t inputSize, const sharedMemoryFrameInformation &inputInformation)
+{
+if(!ownsName)
+{
+throw SOMException("Frame ring was opened for reading\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+if(inputData == nullptr || inputSize > header->slotSize)
+{
+throw SOMException("Frame is missing or larger than the ring's slots\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+uint64_t frameNumber = nextFrameNumber;
+nextFrameNumber++;
+
+slotHeader *slotToWrite = slot(frameNumber % header->numberOfSlots);
+uint64_t sequence = slotToWrite->sequence.load(std::memory_order_relaxed);
+
+//Mark as being written before touching the contents
+slotToWrite->sequence.store(sequence + 1, std::memory_order_relaxed);
+std::atomic_thread_fence(std::memory_order_release);
+
+slotToWrite->frameNumber.store(frameNumber, std::memory_order_relaxed);
+slotToWrite->size = inputSize;
+slotToWrite->information = inputInformation;
+memcpy(((char *) slotToWrite) + sizeof(slotHeader), inputData, inputSize);
+
+slotToWrite->sequence.store(sequence + 2, std::memory_order_release);
+header->latestFrameNumber.store(frameNumber, std::memory_order_release);
+
+return frameNumber;
+}
+
+/**
+This function starts reading a frame in place.
+@param inputFrameNumber: The number of the frame to read
+@param outputView: The view to store the frame's location and information in
+@return: true if the frame is still in the ring and isn't currently being written
+
+@throws: This function can throw exceptions
+*/
+bool sharedMemoryFrameRing::beginRead(uint64_t inputFrameNumber, sharedMemoryFrameView &outputView) const
+{
+if(inputFrameNumber == 0)
+{
+return false;
+}
+
+slotHeader *slotToRead = slot(inputFrameNumber % header->numberOfSlots);
+uint64_t sequence = slotToRead->sequence.load(std::memory_order_acquire);
+if((sequence & 1) != 0 || slotToRead->frameNumber.load(std::memory_order_relaxed) != inputFrameNumber)
+{ //Being written or already replaced
+return false;
+}
+
+outputView.data = ((const unsigned char *) slotToRead) + sizeof(slotHeader);
+outputView.size = std::min(slotToRead->size, header->slotSize);
+outputView.information = slotToRead->information;
+outputView.frameNumber = inputFrameNumber;
+outputView.slotSequence = sequence;
+
+return true;
+}
+
+/**
+This function checks whether a frame that was read in place was overwritten while it was being read.
+@param inputView: The view returned by beginRead
+@return: true if the data read through the view is valid
+*/
+bool sharedMemoryFrameRing::endRead(const sharedMemoryFrameView &inputView) const
+{
+if(inputView.frameNumber == 0)
+{
+return false;
+}
+
+std::atomic_thread_fence(std::memory_order_acquire);
+return slot(inputView.frameNumber % header->numberOfSlots)->sequence.load(std::memory_order_relaxed) == inputView.slotSequence;
+}
+
+/**
+This function returns the number of the most recently published frame.
+@return: The frame number (0 if no frames have been published)
+*/
+uint64_t sharedMemoryFrameRing::latestFrameNumber() const
+{
+return header->latestFrameNumber.load(std::memory_order_acquire);
+}
+
+/**
+This function returns the maximum size of a frame in the ring.
+@return: The slot size in bytes
+*/
+uint64_t sharedMemoryFrameRing::slotSize() const
+{
+return header->slotSize;
+}
+
+/**
+This function returns the header of the given slot.
+@param inputSlotIndex: The index of the slot
+@return: The slot's header (its data immediately follows it)
+*/
+sharedMemoryFrameRing::slotHeader *sharedMemoryFrameRing::slot(uint64_t inputSlotIndex) const
+{
+return (slotHeader *) (((char *) mapping) + sizeof(ringHeader) + header->slotStride*inputSlotIndex);
+}
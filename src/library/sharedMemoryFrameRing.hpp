@@ -0,0 +1,181 @@
+#pragma once
+
+#include<string>
+#include<atomic>
+#include<cstdint>
+#include<cstring>
+#include<cerrno>
+#include<new>
+#include<algorithm>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include "SOMException.hpp"
+
+namespace soaringPen
+{
+
+const std::string SHARED_MEMORY_ENDPOINT_PREFIX = "shm://";
+const uint32_t DEFAULT_SHARED_MEMORY_FRAME_RING_SIZE = 4; //Slots in the ring (readers have this many frame periods to finish with a frame before it is overwritten)
+
+/**
+This function returns true if the endpoint is a shared memory video endpoint ("shm://name").
+@param inputEndpoint: The endpoint to check
+@return: true if it starts with shm://
+*/
+bool isSharedMemoryEndpoint(const std::string &inputEndpoint);
+
+/**
+This function returns the POSIX shared memory object name used for a shared memory video endpoint ("shm://name" -> "/name").
+@param inputEndpoint: The shared memory endpoint
+@return: The shared memory object name
+
+@throws: This function can throw exceptions (such as if the endpoint isn't a valid shared memory endpoint)
+*/
+std::string sharedMemoryFrameRingName(const std::string &inputEndpoint);
+
+/**
+This function returns the ZMQ endpoint that new frame notifications are published on for a shared memory video endpoint.  Only the frame numbers go through ZMQ; the frames themselves stay in shared memory.
+@param inputEndpoint: The shared memory endpoint
+@return: The ZMQ (ipc) endpoint for the notifications
+
+@throws: This function can throw exceptions (such as if the endpoint isn't a valid shared memory endpoint)
+*/
+std::string sharedMemoryFrameNotificationEndpoint(const std::string &inputEndpoint);
+
+/**
+This struct describes a raw frame stored in a sharedMemoryFrameRing.
+*/
+struct sharedMemoryFrameInformation
+{
+int32_t width = 0; //Pixels
+int32_t height = 0; //Pixels
+int32_t type = 0; //OpenCV type of the pixels (such as CV_8UC3)
+int32_t step = 0; //Bytes per row
+int64_t captureTime = 0; //When the frame was captured (monotonicMicroseconds on the publishing host)
+};
+
+/**
+This struct refers to a frame in a sharedMemoryFrameRing that is being read in place.  The data is only valid if endRead returns true once the reader has finished with it.
+*/
+struct sharedMemoryFrameView
+{
+const unsigned char *data = nullptr;
+uint64_t size = 0; //Bytes
+sharedMemoryFrameInformation information;
+uint64_t frameNumber = 0;
+uint64_t slotSequence = 0; //The slot's sequence number when the read began
+};
+
+/**
+This class is a ring of fixed size frame slots in POSIX shared memory, which lets raw (unencoded) frames be handed to other processes on the same host without copying them through a socket.  One process creates the ring and publishes frames to it; any number of others open it by name and read frames in place.
+
+Each slot is guarded by a sequence lock: the publisher makes the slot's sequence number odd while it writes and even again when it is done, so a reader that sees the same even sequence number before and after it used the frame knows that it wasn't overwritten in the meantime.  The publisher never waits for readers.  Readers which fall more than a ring's worth of frames behind get false from endRead and should skip to the latest frame.
+*/
+class sharedMemoryFrameRing
+{
+public:
+/**
+This function creates the ring (replacing any existing one with the same name) for publishing frames.
+@param inputName: The POSIX shared memory object name (such as "/soaringPenVideo")
+@param inputNumberOfSlots: The number of frames the ring holds
+@param inputSlotSize: The maximum size of a frame in bytes
+
+@throws: This function can throw exceptions
+*/
+sharedMemoryFrameRing(const std::string &inputName, uint32_t inputNumberOfSlots, uint64_t inputSlotSize);
+
+/**
+This function opens an existing ring for reading frames.
+@param inputName: The POSIX shared memory object name (such as "/soaringPenVideo")
+
+@throws: This function can throw exceptions (such as if the ring doesn't exist yet)
+*/
+sharedMemoryFrameRing(const std::string &inputName);
+
+/**
+This function unmaps the ring (and removes its name if this object created it).
+*/
+~sharedMemoryFrameRing();
+
+sharedMemoryFrameRing(const sharedMemoryFrameRing &) = delete;
+sharedMemoryFrameRing &operator=(const sharedMemoryFrameRing &) = delete;
+
+/**
+This function copies a frame into the next slot of the ring.
+@param inputData: The frame's pixel data
+@param inputSize: The number of bytes of pixel data
+@param inputInformation: The frame's dimensions/type/capture time
+@return: The frame's number (frames are numbered from 1)
+
+@throws: This function can throw exceptions (such as if the frame is larger than the slots)
+*/
+uint64_t publish(const void *inputData, uint64_t inputSize, const sharedMemoryFrameInformation &inputInformation);
+
+/**
+This function starts reading a frame in place.
+@param inputFrameNumber: The number of the frame to read
+@param outputView: The view to store the frame's location and information in
+@return: true if the frame is still in the ring and isn't currently being written
+
+@throws: This function can throw exceptions
+*/
+bool beginRead(uint64_t inputFrameNumber, sharedMemoryFrameView &outputView) const;
+
+/**
+This function checks whether a frame that was read in place was overwritten while it was being read.
+@param inputView: The view returned by beginRead
+@return: true if the data read through the view is valid
+*/
+bool endRead(const sharedMemoryFrameView &inputView) const;
+
+/**
+This function returns the number of the most recently published frame.
+@return: The frame number (0 if no frames have been published)
+*/
+uint64_t latestFrameNumber() const;
+
+/**
+This function returns the maximum size of a frame in the ring.
+@return: The slot size in bytes
+*/
+uint64_t slotSize() const;
+
+protected:
+static const uint64_t RING_MAGIC_NUMBER = 0x736f6172696e6731; //Identifies the memory as a frame ring (and its layout version)
+
+struct alignas(64) ringHeader
+{
+uint64_t magicNumber;
+uint32_t numberOfSlots;
+uint64_t slotSize;
+uint64_t slotStride; //Bytes from the start of one slot to the next
+std::atomic<uint64_t> latestFrameNumber;
+};
+
+struct alignas(64) slotHeader
+{
+std::atomic<uint64_t> sequence; //Odd while the slot is being written
+std::atomic<uint64_t> frameNumber;
+uint64_t size;
+sharedMemoryFrameInformation information;
+};
+
+std::string name;
+bool ownsName = false;
+int fileDescriptor = -1;
+void *mapping = nullptr;
+uint64_t mappingSize = 0;
+ringHeader *header = nullptr;
+uint64_t nextFrameNumber = 1; //Only used by the publisher
+
+/**
+This function returns the header of the given slot.
+@param inputSlotIndex: The index of the slot
+@return: The slot's header (its data immediately follows it)
+*/
+slotHeader *slot(uint64_t inputSlotIndex) const;
+};
+
+}
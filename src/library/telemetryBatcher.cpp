@@ -0,0 +1,164 @@
+#include "telemetryBatcher.hpp"
+
+using namespace soaringPen;
+
+/**
+This function initializes the batcher.
+@param inputMaximumNumberOfSamples: The number of samples at which the batch is considered full
+
+@throws: This function can throw exceptions
+*/
+telemetryBatcher::telemetryBatcher(int inputMaximumNumberOfSamples) : maximumNumberOfSamples(inputMaximumNumberOfSamples)
+{
+if(inputMaximumNumberOfSamples <= 0)
+{
+throw SOMException("Non-positive telemetry batch size\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+batch.mutable_sample_time_offsets()->Reserve(maximumNumberOfSamples);
+batch.mutable_x_positions()->Reserve(maximumNumberOfSamples);
+batch.mutable_y_positions()->Reserve(maximumNumberOfSamples);
+batch.mutable_x_velocities()->Reserve(maximumNumberOfSamples);
+batch.mutable_y_velocities()->Reserve(maximumNumberOfSamples);
+}
+
+/**
+This function adds a sample to the batch.
+@param inputSampleTime: The time the sample was taken in microseconds since epoch (must not be before the first sample in the batch)
+@param inputPosition: The drone's normalized position in the camera image
+@param inputVelocity: The drone's velocity
+
+@throws: This function can throw exceptions
+*/
+void telemetryBatcher::addSample(int64_t inputSampleTime, const fPoint &inputPosition, const fPoint &inputVelocity)
+{
+if(size() == 0)
+{
+batch.set_first_sample_time(inputSampleTime);
+}
+
+int64_t timeOffset = inputSampleTime - batch.first_sample_time();
+if(timeOffset < 0 || timeOffset > std::numeric_limits<uint32_t>::max())
+{
+throw SOMException("Telemetry sample time out of order or too far from the start of the batch\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+batch.add_sample_time_offsets((uint32_t) timeOffset);
+batch.add_x_positions(inputPosition.val[0]);
+batch.add_y_positions(inputPosition.val[1]);
+batch.add_x_velocities(inputVelocity.val[0]);
+batch.add_y_velocities(inputVelocity.val[1]);
+}
+
+/**
+This function returns the number of samples waiting in the batch.
+@return: The number of samples
+*/
+int telemetryBatcher::size() const
+{
+return batch.sample_time_offsets_size();
+}
+
+/**
+This function returns true if the batch has reached its maximum number of samples and should be flushed.
+@return: true if full
+*/
+bool telemetryBatcher::isFull() const
+{
+return size() >= maximumNumberOfSamples;
+}
+
+/**
+This function moves the batched samples into the given status update's telemetry_batch field and empties the batch.  The single sample position/velocity fields are set to the most recent sample so that GUIs which don't know about batches still see the drone.
+@param outputStatusUpdate: The status update to store the samples in
+@return: true if there were any samples to store (the status update isn't changed otherwise)
+*/
+bool telemetryBatcher::flush(controller_status_update &outputStatusUpdate)
+{
+if(size() == 0)
+{
+return false;
+}
+
+int lastSampleIndex = size() - 1;
+outputStatusUpdate.set_x_position(batch.x_positions(lastSampleIndex));
+outputStatusUpdate.set_y_position(batch.y_positions(lastSampleIndex));
+outputStatusUpdate.set_x_velocity(batch.x_velocities(lastSampleIndex));
+outputStatusUpdate.set_y_velocity(batch.y_velocities(lastSampleIndex));
+
+//Swap rather than copy, then clear (which keeps the allocated capacity for the next batch)
+outputStatusUpdate.mutable_telemetry_batch_field()->Swap(&batch);
+batch.Clear();
+
+return true;
+}
+
+/**
+This function retrieves all of the drone positions in a status update, oldest first.  The positions from the telemetry_batch field are used if it is present and the single x_position/y_position otherwise.
+@param inputStatusUpdate: The status update to get the positions from
+@return: The positions (empty if the update has none)
+
+@throws: This function can throw exceptions (such as if the batch's fields have different numbers of entries)
+*/
+std::vector<fPoint> soaringPen::getTelemetryPositions(const controller_status_update &inputStatusUpdate)
+{
+std::vector<fPoint> positions;
+
+if(!inputStatusUpdate.has_telemetry_batch_field())
+{
+if(inputStatusUpdate.has_x_position() && inputStatusUpdate.has_y_position())
+{
+positions.emplace_back(inputStatusUpdate.x_position(), inputStatusUpdate.y_position());
+}
+return positions;
+}
+
+const telemetry_batch &batch = inputStatusUpdate.telemetry_batch_field();
+if(batch.x_positions_size() != batch.y_positions_size())
+{
+throw SOMException("Telemetry batch has different numbers of x and y positions\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+positions.reserve(batch.x_positions_size());
+for(int i=0; i<batch.x_positions_size(); i++)
+{
+positions.emplace_back(batch.x_positions(i), batch.y_positions(i));
+}
+
+return positions;
+}
+
+/**
+This function retrieves all of the drone velocities in a status update, oldest first.  The velocities from the telemetry_batch field are used if it is present and the single x_velocity/y_velocity otherwise.
+@param inputStatusUpdate: The status update to get the velocities from
+@return: The velocities (empty if the update has none)
+
+@throws: This function can throw exceptions (such as if the batch's fields have different numbers of entries)
+*/
+std::vector<fPoint> soaringPen::getTelemetryVelocities(const controller_status_update &inputStatusUpdate)
+{
+std::vector<fPoint> velocities;
+
+if(!inputStatusUpdate.has_telemetry_batch_field())
+{
+if(inputStatusUpdate.has_x_velocity() || inputStatusUpdate.has_y_velocity())
+{ //Missing components default to 0
+velocities.emplace_back(inputStatusUpdate.x_velocity(), inputStatusUpdate.y_velocity());
+}
+return velocities;
+}
+
+const telemetry_batch &batch = inputStatusUpdate.telemetry_batch_field();
+if(batch.x_velocities_size() != batch.y_velocities_size())
+{
+throw SOMException("Telemetry batch has different numbers of x and y velocities\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+velocities.reserve(batch.x_velocities_size());
+for(int i=0; i<batch.x_velocities_size(); i++)
+{
+velocities.emplace_back(batch.x_velocities(i), batch.y_velocities(i));
+}
+
+return velocities;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include<vector>
+#include<cstdint>
+#include<limits>
+#include "fPoint.hpp"
+#include "SOMException.hpp"
+#include "controller_status_update.pb.h"
+#include "telemetry_batch.pb.h"
+
+namespace soaringPen
+{
+
+const int DEFAULT_TELEMETRY_BATCH_SIZE = 32; //Samples per status update (~3 updates a second at 100 Hz)
+
+/**
+This class accumulates drone state samples so that they can be sent together in the telemetry_batch field of a controller_status_update, rather than as one message per sample.
+*/
+class telemetryBatcher
+{
+public:
+/**
+This function initializes the batcher.
+@param inputMaximumNumberOfSamples: The number of samples at which the batch is considered full
+
+@throws: This function can throw exceptions
+*/
+telemetryBatcher(int inputMaximumNumberOfSamples = DEFAULT_TELEMETRY_BATCH_SIZE);
+
+/**
+This function adds a sample to the batch.
+@param inputSampleTime: The time the sample was taken in microseconds since epoch (must not be before the first sample in the batch)
+@param inputPosition: The drone's normalized position in the camera image
+@param inputVelocity: The drone's velocity
+
+@throws: This function can throw exceptions
+*/
+void addSample(int64_t inputSampleTime, const fPoint &inputPosition, const fPoint &inputVelocity);
+
+/**
+This function returns the number of samples waiting in the batch.
+@return: The number of samples
+*/
+int size() const;
+
+/**
+This function returns true if the batch has reached its maximum number of samples and should be flushed.
+@return: true if full
+*/
+bool isFull() const;
+
+/**
+This function moves the batched samples into the given status update's telemetry_batch field and empties the batch.  The single sample position/velocity fields are set to the most recent sample so that GUIs which don't know about batches still see the drone.
+@param outputStatusUpdate: The status update to store the samples in
+@return: true if there were any samples to store (the status update isn't changed otherwise)
+*/
+bool flush(controller_status_update &outputStatusUpdate);
+
+protected:
+int maximumNumberOfSamples;
+telemetry_batch batch;
+};
+
+/**
+This function retrieves all of the drone positions in a status update, oldest first.  The positions from the telemetry_batch field are used if it is present and the single x_position/y_position otherwise.
+@param inputStatusUpdate: The status update to get the positions from
+@return: The positions (empty if the update has none)
+
+@throws: This function can throw exceptions (such as if the batch's fields have different numbers of entries)
+*/
+std::vector<fPoint> getTelemetryPositions(const controller_status_update &inputStatusUpdate);
+
+/**
+This function retrieves all of the drone velocities in a status update, oldest first.  The velocities from the telemetry_batch field are used if it is present and the single x_velocity/y_velocity otherwise.
+@param inputStatusUpdate: The status update to get the velocities from
+@return: The velocities (empty if the update has none)
+
+@throws: This function can throw exceptions (such as if the batch's fields have different numbers of entries)
+*/
+std::vector<fPoint> getTelemetryVelocities(const controller_status_update &inputStatusUpdate);
+
+}
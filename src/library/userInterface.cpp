@@ -6,12 +6,14 @@ using namespace soaringPen;
 /**
 This function initializes the user interface and starts the communication thread.
 @param inputContext: The ZMQ context to use
-@param inputControllerPairInterfaceURI: The URI "ip:port" of the controller's pair interface to pair with the GUI
-@param inputControllerVideoPublishingURI: The interface that the controller publishes video on
+@param inputControllerPairInterfaceURI: The URI "ip:port" (or full ZMQ endpoint, such as "ipc:///tmp/soaringPenCommands") of the controller's pair interface to pair with the GUI
+@param inputControllerVideoPublishingURI: The interface that the controller publishes video on ("ip:port", full ZMQ endpoint or "shm://name" for a same host controller's shared memory frame ring)
+@param inputControllerEmergencyStopURI: The controller's dedicated emergency stop interface ("ip:port" or full ZMQ endpoint), or empty if emergency stops should only go through the pair interface
+@param inputGeofenceFileName: The file to read the geofence zones from (see geofence::readZones), or empty for no geofence
 
 @throws: This function can throw exceptions
 */
-userInterface::userInterface(zmq::context_t &inputContext, const std::string &inputControllerPairInterfaceURI, const std::string &inputControllerVideoPublishingURI)
+userInterface::userInterface(zmq::context_t &inputContext, const std::string &inputControllerPairInterfaceURI, const std::string &inputControllerVideoPublishingURI, const std::string &inputControllerEmergencyStopURI, const std::string &inputGeofenceFileName)
 {
 qRegisterMetaType<follow_path_command>("follow_path_command");
 qRegisterMetaType<controller_status_update>("controller_status_update");
@@ -23,13 +25,21 @@ new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_Q), this, SLOT(close()));
 
 context = &inputContext;
 
+if(inputGeofenceFileName.size() > 0)
+{
+SOM_TRY
+flightGeofence.readZonesFromFile(inputGeofenceFileName);
+SOM_CATCH("Error loading geofence\n")
+}
+geofenceStatusLabel->setText((flightGeofence.keepInZones.size() + flightGeofence.keepOutZones.size()) > 0 ? "OK" : "No zones");
+
 //Initialize/connect the sockets before passing them to the communication thread 
 SOM_TRY //Init
 commandInterface.reset(new zmq::socket_t(*(context), ZMQ_PAIR));
 SOM_CATCH("Error intializing commandInterface\n")
 
 SOM_TRY //Connect
-std::string connectionString = "tcp://" + inputControllerPairInterfaceURI;
+std::string connectionString = pylongps::normalizeZMQConnectionEndpoint(inputControllerPairInterfaceURI);
 commandInterface->connect(connectionString.c_str());
 SOM_CATCH("Error connecting commandInterface socket")
 
@@ -41,14 +51,32 @@ SOM_TRY //Set filter to allow any published messages to be received
 videoSubscriber->setsockopt(ZMQ_SUBSCRIBE, nullptr, 0);
 SOM_CATCH("Error setting subscription for videoSubscriber\n")
 
+//Same host controllers can share raw frames through shared memory, in which case only frame numbers are published
+std::string sharedMemoryFrameRingNameToUse;
 SOM_TRY //Connect
-std::string connectionString = "tcp://" + inputControllerVideoPublishingURI;
+std::string connectionString;
+if(isSharedMemoryEndpoint(inputControllerVideoPublishingURI))
+{
+sharedMemoryFrameRingNameToUse = sharedMemoryFrameRingName(inputControllerVideoPublishingURI);
+connectionString = sharedMemoryFrameNotificationEndpoint(inputControllerVideoPublishingURI);
+}
+else
+{
+connectionString = pylongps::normalizeZMQConnectionEndpoint(inputControllerVideoPublishingURI);
+}
 videoSubscriber->connect(connectionString.c_str());
 SOM_CATCH("Error connecting videoSubscriber socket")
 
+if(inputControllerEmergencyStopURI.size() > 0)
+{
+SOM_TRY
+emergencyStopChannel.reset(new emergencyStopSender(*context, inputControllerEmergencyStopURI));
+SOM_CATCH("Error starting emergency stop sender\n")
+}
+
 //Setup communication thread
 SOM_TRY
-communicationThread.reset(new userInterfaceCommunicationThread(*commandInterface, *videoSubscriber));
+communicationThread.reset(new userInterfaceCommunicationThread(*commandInterface, *videoSubscriber, sharedMemoryFrameRingNameToUse));
 SOM_CATCH("Error starting communication thread\n")
 
 connect(communicationThread.get(), SIGNAL(cameraImage(QPixmap)), this, SLOT(overlayVideoFrame(const QPixmap &)));
@@ -57,20 +85,30 @@ connect(communicationThread.get(), SIGNAL(controllerStatusUpdate(controller_stat
 
 connect(this, SIGNAL(videoFrameWithOverlay(QPixmap)), videoDisplayLabel, SLOT(setPixmap(const QPixmap &)));
 
+connect(this, SIGNAL(droneCrossTrackError(double)), this, SLOT(displayCrossTrackError(double)));
+
+connect(this, SIGNAL(droneGeofenceViolation(bool)), this, SLOT(displayGeofenceViolation(bool)));
+
 connect(startFlightPushButton, SIGNAL(clicked(bool)), this, SLOT(emitFollowPathCommandSignal()));
 
 connect(this, SIGNAL(followPathCommandSignal(follow_path_command)), communicationThread.get(), SLOT(sendFollowPathCommand(follow_path_command)));
 
 connect(cancelFlightPushButton, SIGNAL(clicked(bool)), communicationThread.get(), SLOT(sendReturnToHomeCommand()));
 
+if(emergencyStopChannel)
+{ //Stops go on the dedicated channel, so they don't wait behind other commands
+connect(emergencyStopPushButton, SIGNAL(clicked(bool)), this, SLOT(sendEmergencyStop()));
+}
+else
+{ //Controller doesn't have the channel, so queue the stop on the pair interface
 connect(emergencyStopPushButton, SIGNAL(clicked(bool)), communicationThread.get(), SLOT(sendEmergencyStopCommand()));
+}
 
 
 
-//Connect status labels for updates
-connect(communicationThread.get(), SIGNAL(droneBatteryStatus(double)), chargePercentLabel, SLOT(setNum(double)));
-connect(communicationThread.get(), SIGNAL(droneXVelocity(double)), xVelocityLabel, SLOT(setNum(double)));
-connect(communicationThread.get(), SIGNAL(droneYVelocity(double)), yVelocityLabel, SLOT(setNum(double)));
+//Update status labels at display rate
+connect(&statusDisplayTimer, SIGNAL(timeout()), this, SLOT(displayLatestStatus()));
+statusDisplayTimer.start(STATUS_DISPLAY_UPDATE_INTERVAL);
 
 //Register to receive events that occur in the video display label
 videoDisplayLabel->installEventFilter(this);
@@ -110,11 +148,7 @@ QPainter painter(&buffer);
 
 
 //Convert path to scaled picture coordinates
-std::vector<std::pair<int, int> > convertedPath;
-for(auto iter = path.points.begin(); iter != path.points.end(); iter++)
-{
-convertedPath.push_back(normalizedImageCoordinateToImageCoordinate((*iter).val[0], (*iter).val[1]));
-}
+std::vector<std::pair<int, int> > convertedPath = normalizedImageCoordinatesToImageCoordinates(path.points);
 
 { //Draw travelled field
 QPen penSettings = painter.pen();
@@ -123,11 +157,7 @@ penSettings.setColor(QColor(0,255,0,20));
 
 painter.setPen(penSettings);
 
-std::vector<std::pair<int, int> > convertedTravelledPath;
-for(auto iter = droneTravelledPath.points.begin(); iter != droneTravelledPath.points.end(); iter++)
-{
-convertedTravelledPath.push_back(normalizedImageCoordinateToImageCoordinate((*iter).val[0], (*iter).val[1]));
-}
+std::vector<std::pair<int, int> > convertedTravelledPath = normalizedImageCoordinatesToImageCoordinates(droneTravelledPath.points);
 
 //Draw path with linear interpolation
 for(int i=1; i<convertedTravelledPath.size(); i++)
@@ -137,6 +167,28 @@ painter.drawLine(convertedTravelledPath[i-1].first+.5, convertedTravelledPath[i-
 
 }
 
+{ //Draw geofence zones (keep-in in blue, keep-out in red)
+QPen penSettings = painter.pen();
+penSettings.setWidth(2*cameraImageSize.mag()/1000);
+
+std::vector<std::pair<const std::vector<convexZone> *, QColor> > zoneSets = {{&flightGeofence.keepInZones, QColor(0,0,255,150)}, {&flightGeofence.keepOutZones, QColor(255,0,0,150)}};
+for(const auto &zoneSet : zoneSets)
+{
+penSettings.setColor(zoneSet.second);
+painter.setPen(penSettings);
+
+for(const convexZone &zone : *zoneSet.first)
+{
+std::vector<std::pair<int, int> > convertedHull = normalizedImageCoordinatesToImageCoordinates(zone.hull);
+for(int i=0; i<convertedHull.size(); i++)
+{
+const std::pair<int, int> &nextPoint = convertedHull[(i+1) % convertedHull.size()];
+painter.drawLine(convertedHull[i].first, convertedHull[i].second, nextPoint.first, nextPoint.second);
+}
+}
+}
+}
+
 {
 QPen penSettings = painter.pen();
 penSettings.setWidth(3*cameraImageSize.mag()/1000);
@@ -152,6 +204,20 @@ painter.drawLine(convertedPath[i-1].first+.5, convertedPath[i-1].second+.5, conv
 
 }
 
+if(droneProjectedPathLocationValid && path.points.size() >= 2)
+{ //Mark how far along the drawn path the drone has got
+fPoint progressPoint = path.interpolate(std::min(droneProjectedPathLocation, path.pathLength));
+std::pair<int, int> convertedProgressPoint = normalizedImageCoordinateToImageCoordinate(progressPoint.val[0], progressPoint.val[1]);
+int markerRadius = std::max<int>(5*cameraImageSize.mag()/1000, 2);
+
+QPen penSettings = painter.pen();
+penSettings.setWidth(2*cameraImageSize.mag()/1000);
+penSettings.setColor(QColor(255,255,0,255));
+painter.setPen(penSettings);
+
+painter.drawEllipse(convertedProgressPoint.first-markerRadius, convertedProgressPoint.second-markerRadius, 2*markerRadius, 2*markerRadius);
+}
+
 /*
 //TODO: Remove
 static double pathLocation = 0.01;
@@ -175,7 +241,7 @@ emit videoFrameWithOverlay(buffer);
 }
 
 /**
-When activated, this slot emits the followPathCommandSignal to send the current path to the drone.  If the current path has a length of 1 or less, no signal is emitted.
+When activated, this slot emits the followPathCommandSignal to send the current path to the drone.  The path is simplified and its long segments are split before it is sent.  If the current path has a length of 1 or less or the path to send violates the geofence, no signal is emitted.
 */
 void userInterface::emitFollowPathCommandSignal()
 {
@@ -184,37 +250,196 @@ if(path.points.size() < 2)
 return;
 }
 
-//Compose a follow path command
-follow_path_command command;
+//Remove mouse jitter, then split long segments so the controller never has to interpolate far (keeping the simplified corners, so the path stays within FOLLOW_PATH_MAXIMUM_LATERAL_ERROR of the drawn one)
+linearPath pathToSend;
+SOM_TRY
+pathToSend = path.simplify(FOLLOW_PATH_MAXIMUM_LATERAL_ERROR).resample(FOLLOW_PATH_POINT_SPACING, true);
+SOM_CATCH("Error simplifying path\n")
+
+int violationIndex = flightGeofence.findFirstViolation(pathToSend);
+if(violationIndex >= 0)
+{ //Don't send the drone somewhere it isn't allowed
+fprintf(stderr, "Path rejected: point %d violates the geofence\n", violationIndex);
+geofenceStatusLabel->setText("Path rejected");
+return;
+}
 
-for(auto iter = path.points.begin(); iter != path.points.end(); iter++)
+//Compose a follow path command, using the compact encoding if the controller has said it understands it
+follow_path_command command;
+SOM_TRY
+if(controllerSupportsQuantizedPaths)
+{
+encodeQuantizedPath(pathToSend, DEFAULT_PATH_QUANTIZATION_RESOLUTION, command);
+}
+else
 {
-command.add_path_x_coordinates(iter->val[0]);
-command.add_path_y_coordinates(iter->val[1]);
+encodePath(pathToSend, command);
 }
+SOM_CATCH("Error encoding path\n")
 
 //Emit it
 emit followPathCommandSignal(command);
 }
 
 /**
-Process the status update to get the drone position so that the green field path can be updated.
+Process the status update to get the drone position(s) so that the green field path can be updated.  All of the samples in a telemetry batch are added in one pass.  The drone's distance from the drawn path (cross track error) is also computed and emitted, along with whether the drone's movement since the last update was allowed by the geofence.
 @param inputStatusUpdate: The status update to process
 
 @throws: This function can throw exceptions
 */
 void userInterface::processStatusUpdateForFieldPath(const controller_status_update &inputStatusUpdate)
 {
-//Add drone location
-droneTravelledPath.addPoint(fPoint(inputStatusUpdate.x_position(), inputStatusUpdate.y_position()));
+if(inputStatusUpdate.has_supports_quantized_paths())
+{
+controllerSupportsQuantizedPaths = inputStatusUpdate.supports_quantized_paths();
+}
+
+//Get every position in the update (a whole telemetry batch or the single sample)
+std::vector<fPoint> dronePositions;
+SOM_TRY
+dronePositions = getTelemetryPositions(inputStatusUpdate);
+SOM_CATCH("Error unpacking status update positions\n")
+
+if(dronePositions.size() == 0)
+{ //No position in this update
+return;
+}
+
+//Check the drone's movement since the last update against the geofence and add the drone locations
+bool geofenceViolated = false;
+for(const fPoint &dronePosition : dronePositions)
+{
+geofenceViolated = geofenceViolated || (droneTravelledPath.points.size() == 0 ? !flightGeofence.isAllowed(dronePosition) : !flightGeofence.isAllowed(droneTravelledPath.points.back(), dronePosition));
+droneTravelledPath.addPoint(dronePosition);
+}
+emit droneGeofenceViolation(geofenceViolated);
 
 //Remove points that are too close together
 droneTravelledPath.regularize(.03);
 
+if(path.points.size() >= 2)
+{ //Find how far the drone is from the drawn path (using the most recent position)
+double crossTrackError = 0.0;
+fPoint closestPathPoint;
+SOM_TRY
+std::tie(crossTrackError, droneProjectedPathLocation, closestPathPoint) = pathSegmentGrid.findNearestPoint(dronePositions.back());
+SOM_CATCH("Error finding closest path point\n")
+droneProjectedPathLocationValid = true;
+
+emit droneCrossTrackError(crossTrackError);
+}
+
 printf("Hello world\n");
 }
 
 
+/**
+This function updates the status labels (battery, velocities, link quality and command queue) with the latest status snapshot from the communication thread, along with the emergency stop latency shown in the stop button's tooltip.  It is called by statusDisplayTimer and only touches labels whose values have changed.
+*/
+void userInterface::displayLatestStatus()
+{
+if(emergencyStopChannel)
+{ //Show how long the last stop took to be acknowledged
+emergencyStopLatencyStatistics stopStatistics = emergencyStopChannel->getLatencyStatistics();
+if(stopStatistics.numberOfAcknowledgedStops != displayedNumberOfAcknowledgedStops)
+{
+emergencyStopPushButton->setToolTip(QString("Last stop acknowledged in %1 ms (maximum %2 ms)").arg(stopStatistics.lastLatency*1000.0, 0, 'f', 1).arg(stopStatistics.maximumLatency*1000.0, 0, 'f', 1));
+displayedNumberOfAcknowledgedStops = stopStatistics.numberOfAcknowledgedStops;
+}
+}
+
+controllerStatusSnapshot latestStatus;
+if(!communicationThread->getLatestStatusSnapshot(latestStatus))
+{ //Nothing new
+return;
+}
+
+//setNum causes relayout, so skip it if nothing changed (the labels hold placeholder text until the first update)
+bool firstUpdate = displayedStatus.numberOfStatusUpdates == 0;
+if(latestStatus.linkRoundTripTime != displayedStatus.linkRoundTripTime || latestStatus.linkLossFraction != displayedStatus.linkLossFraction)
+{
+linkQualityLabel->setText(QString("%1 ms, %2% loss").arg(latestStatus.linkRoundTripTime*1000.0, 0, 'f', 1).arg(latestStatus.linkLossFraction*100.0, 0, 'f', 0));
+}
+
+if(firstUpdate || latestStatus.commandQueueDepth != displayedStatus.commandQueueDepth || latestStatus.commandSendLatency != displayedStatus.commandSendLatency)
+{
+commandQueueLabel->setText(QString("%1 queued, %2 ms").arg(latestStatus.commandQueueDepth).arg(latestStatus.commandSendLatency*1000.0, 0, 'f', 1));
+}
+
+if(latestStatus.numberOfTimedFrames != displayedStatus.numberOfTimedFrames)
+{
+QString frameDelayText = latestStatus.frameCrossedNetwork ? QString("%1 ms network, %2 ms processing").arg(latestStatus.frameNetworkDelay*1000.0, 0, 'f', 1).arg(latestStatus.frameProcessingDelay*1000.0, 0, 'f', 1) : QString("%1 ms processing (shared memory)").arg(latestStatus.frameProcessingDelay*1000.0, 0, 'f', 1);
+if(frameDelayLabel->text() != frameDelayText)
+{
+frameDelayLabel->setText(frameDelayText);
+}
+}
+
+if(latestStatus.numberOfStatusUpdates == 0)
+{ //Only the link has been measured so far
+displayedStatus = latestStatus;
+return;
+}
+
+if(firstUpdate || latestStatus.batteryStatus != displayedStatus.batteryStatus)
+{
+chargePercentLabel->setNum(latestStatus.batteryStatus);
+}
+
+if(firstUpdate || latestStatus.xVelocity != displayedStatus.xVelocity)
+{
+xVelocityLabel->setNum(latestStatus.xVelocity);
+}
+
+if(firstUpdate || latestStatus.yVelocity != displayedStatus.yVelocity)
+{
+yVelocityLabel->setNum(latestStatus.yVelocity);
+}
+
+displayedStatus = latestStatus;
+}
+
+/**
+This function shows whether the drone's latest movement was allowed by the geofence in the geofence status label (in red if it wasn't).
+@param inputViolation: True if the drone entered a keep-out zone or left a keep-in zone
+*/
+void userInterface::displayGeofenceViolation(bool inputViolation)
+{
+QString geofenceStatusText = inputViolation ? "VIOLATED" : ((flightGeofence.keepInZones.size() + flightGeofence.keepOutZones.size()) > 0 ? "OK" : "No zones");
+if(geofenceStatusLabel->text() == geofenceStatusText)
+{ //setText causes relayout, so skip it if nothing changed
+return;
+}
+
+geofenceStatusLabel->setText(geofenceStatusText);
+geofenceStatusLabel->setStyleSheet(inputViolation ? "QLabel { color : red; font-weight : bold; }" : "");
+}
+
+/**
+This function shows the drone's distance from the drawn path in the cross track error label.
+@param inputCrossTrackError: The distance between the drone and the closest point on the drawn path (normalized image coordinates)
+*/
+void userInterface::displayCrossTrackError(double inputCrossTrackError)
+{
+QString crossTrackErrorText = QString::number(inputCrossTrackError, 'f', 3);
+if(crossTrackErrorLabel->text() != crossTrackErrorText)
+{ //setText causes relayout, so skip it if nothing changed
+crossTrackErrorLabel->setText(crossTrackErrorText);
+}
+}
+
+/**
+This function sends an emergency stop straight to the controller on the dedicated emergency stop channel.  It is only connected if the channel was set up (otherwise the emergency stop button queues the stop on the pair interface instead).
+
+@throws: This function can throw exceptions
+*/
+void userInterface::sendEmergencyStop()
+{
+SOM_TRY
+emergencyStopChannel->sendStop(true);
+SOM_CATCH("Error sending emergency stop\n")
+}
+
 /**
 This function makes it possible for the main window to handle events that happen in it's widgets.  It is called when an event registered via installEventFilter happens in the registered object.
 @param inputTriggeringObject: A pointer to the object the event happened in
@@ -230,6 +455,7 @@ if(inputEvent->type() == QEvent::MouseButtonPress)
 currentlyDrawingPath = true;
 path.clear(); //Erase old path, start new one
 droneTravelledPath.clear();
+droneProjectedPathLocationValid = false;
 }
 
 if(inputEvent->type() == QEvent::MouseButtonRelease)
@@ -239,6 +465,11 @@ currentlyDrawingPath = false; //Path completed
 
 if(inputEvent->type() == QEvent::MouseMove)
 {
+if(cameraImageSize.mag() == 0.0)
+{ //No frame yet, so there is no image to draw on (and the bounds below would be NaN)
+return false;
+}
+
 QMouseEvent *mouseMoveEvent = static_cast<QMouseEvent*>(inputEvent);
 
 
@@ -340,6 +571,34 @@ pointBuffer = pointBuffer + .5*cameraImageSize;
 return std::pair<int, int>(pointBuffer.val[0]+.5, pointBuffer.val[1]+.5);
 }
 
+/**
+This function converts an array of points from the relative coordinate system used with the camera image to the coordinate system associated with the scaled image used with the label (see normalizedImageCoordinateToImageCoordinate), doing the transform as a single batch.
+@param inputPoints: The points in the relative coordinate system
+@return: The converted points <imageXCoordinate, imageYCoordinate>
+*/
+std::vector<std::pair<int, int> > userInterface::normalizedImageCoordinatesToImageCoordinates(const std::vector<fPoint> &inputPoints)
+{
+if(cameraImageSize.val[0] == 0.0 || cameraImageSize.val[1] == 0.0)
+{ //Can't divide by zero
+return std::vector<std::pair<int, int> >(inputPoints.size(), std::pair<int, int>(0,0));
+}
+
+//Scale by the image diagonal and move the origin to the image center
+double scale = cameraImageSize.mag();
+double transformMatrix[4] = {scale, 0.0, 0.0, scale};
+std::vector<fPoint> transformedPoints(inputPoints.size());
+affineTransformPoints(inputPoints.data(), inputPoints.size(), transformMatrix, .5*cameraImageSize, transformedPoints.data());
+
+std::vector<std::pair<int, int> > results;
+results.reserve(transformedPoints.size());
+for(const fPoint &transformedPoint : transformedPoints)
+{
+results.push_back(std::pair<int, int>(transformedPoint.val[0]+.5, transformedPoint.val[1]+.5));
+}
+
+return results;
+}
+
 /**
 This function converts between the coordinate system associated with the video display label and the coordinate system associated with the scaled image used with the label.
 @param inputXCoordinate: The relative X Coordinate
@@ -2,6 +2,7 @@
 
 #include<QMainWindow>
 #include<QShortcut>
+#include<QTimer>
 #include "ui_userInterfaceWindow.h"
 #include<memory>
 #include<zmq.hpp>
@@ -13,6 +14,12 @@
 #include<QMouseEvent>
 #include "fPoint.hpp"
 #include "linearPath.hpp"
+#include "linearPathSegmentGrid.hpp"
+#include "batchGeometry.hpp"
+#include "geofence.hpp"
+#include "pathEncoding.hpp"
+#include "telemetryBatcher.hpp"
+#include "emergencyStopChannel.hpp"
 #include<cmath>
 #include "controller_status_update.pb.h"
 
@@ -26,6 +33,11 @@ const double IMAGE_PATH_Y_OFFSET = .02;
 
 const int TRAVELLED_PATH_WIDTH = 1000;
 
+const double FOLLOW_PATH_MAXIMUM_LATERAL_ERROR = .003; //How far (normalized coordinates) the path sent to the controller is allowed to deviate from the drawn one
+const double FOLLOW_PATH_POINT_SPACING = .02; //The maximum path length distance between the points sent to the controller
+const double PATH_SEGMENT_GRID_CELL_SIZE = .05; //The cell size of the index used to find the closest point on the path to the drone
+const int STATUS_DISPLAY_UPDATE_INTERVAL = 33; //Milliseconds between updates of the status labels (~30 Hz, no matter how often the controller sends status updates)
+
 class userInterface : public QMainWindow, public Ui::userInterfaceWindow
 {
 Q_OBJECT
@@ -34,12 +46,14 @@ public:
 /**
 This function initializes the user interface and starts the communication thread.
 @param inputContext: The ZMQ context to use
-@param inputControllerPairInterfaceURI: The URI "ip:port" of the controller's pair interface to pair with the GUI
-@param inputControllerVideoPublishingURI: The interface that the controller publishes video on
+@param inputControllerPairInterfaceURI: The URI "ip:port" (or full ZMQ endpoint, such as "ipc:///tmp/soaringPenCommands") of the controller's pair interface to pair with the GUI
+@param inputControllerVideoPublishingURI: The interface that the controller publishes video on ("ip:port", full ZMQ endpoint or "shm://name" for a same host controller's shared memory frame ring)
+@param inputControllerEmergencyStopURI: The controller's dedicated emergency stop interface ("ip:port" or full ZMQ endpoint), or empty if emergency stops should only go through the pair interface
+@param inputGeofenceFileName: The file to read the geofence zones from (see geofence::readZones), or empty for no geofence
 
 @throws: This function can throw exceptions
 */
-userInterface(zmq::context_t &inputContext, const std::string &inputControllerPairInterfaceURI, const std::string &inputControllerVideoPublishingURI);
+userInterface(zmq::context_t &inputContext, const std::string &inputControllerPairInterfaceURI, const std::string &inputControllerVideoPublishingURI, const std::string &inputControllerEmergencyStopURI = "", const std::string &inputGeofenceFileName = "");
 
 /**
 This function tells the communication thread to shutdown
@@ -54,6 +68,10 @@ std::unique_ptr<zmq::socket_t> videoSubscriber; //A ZMQ SUB socket which subscri
 
 std::unique_ptr<userInterfaceCommunicationThread> communicationThread;
 
+std::unique_ptr<emergencyStopSender> emergencyStopChannel; //Sends emergency stops on their own socket and thread, so they don't wait behind other commands.  Only made if the controller's emergency stop interface was given.
+
+geofence flightGeofence; //Zones that paths sent to the drone (and the drone itself) must respect.  Empty (no restrictions) unless a geofence file is given.
+
 public slots:
 
 /**
@@ -65,18 +83,42 @@ This function receives a video frame and overlays the current path (and any othe
 void overlayVideoFrame(const QPixmap &inputVideoFrame);
 
 /**
-When activated, this slot emits the followPathCommandSignal to send the current path to the drone.  If the current path has a length of 1 or less, no signal is emitted.
+When activated, this slot emits the followPathCommandSignal to send the current path to the drone.  The path is simplified and its long segments are split before it is sent.  If the current path has a length of 1 or less or the path to send violates the geofence, no signal is emitted.
 */
 void emitFollowPathCommandSignal();
 
 /**
-Process the status update to get the drone position so that the green field path can be updated.
+Process the status update to get the drone position(s) so that the green field path can be updated.  All of the samples in a telemetry batch are added in one pass.  The drone's distance from the drawn path (cross track error) is also computed and emitted, along with whether the drone's movement since the last update was allowed by the geofence.
 @param inputStatusUpdate: The status update to process
 
 @throws: This function can throw exceptions
 */
 void processStatusUpdateForFieldPath(const controller_status_update &inputStatusUpdate);
 
+/**
+This function updates the status labels (battery, velocities, link quality and command queue) with the latest status snapshot from the communication thread, along with the emergency stop latency shown in the stop button's tooltip.  It is called by statusDisplayTimer and only touches labels whose values have changed.
+*/
+void displayLatestStatus();
+
+/**
+This function shows whether the drone's latest movement was allowed by the geofence in the geofence status label (in red if it wasn't).
+@param inputViolation: True if the drone entered a keep-out zone or left a keep-in zone
+*/
+void displayGeofenceViolation(bool inputViolation);
+
+/**
+This function shows the drone's distance from the drawn path in the cross track error label.
+@param inputCrossTrackError: The distance between the drone and the closest point on the drawn path (normalized image coordinates)
+*/
+void displayCrossTrackError(double inputCrossTrackError);
+
+/**
+This function sends an emergency stop straight to the controller on the dedicated emergency stop channel.  It is only connected if the channel was set up (otherwise the emergency stop button queues the stop on the pair interface instead).
+
+@throws: This function can throw exceptions
+*/
+void sendEmergencyStop();
+
 signals:
 /**
 This signal is any received video frame with the current path overlayed on it.
@@ -88,12 +130,29 @@ This signal is a follow path command for the drone to perform.
 */
 void followPathCommandSignal(follow_path_command);
 
+/**
+This signal is the distance between the drone's reported position and the closest point on the drawn path (normalized image coordinates).
+*/
+void droneCrossTrackError(double);
+
+/**
+This signal is true if the drone's movement since the last status update entered a keep-out zone or left a keep-in zone.
+*/
+void droneGeofenceViolation(bool);
+
 
 private:
 fPoint cameraImageSize;
 bool currentlyDrawingPath = false;
 linearPath path; //The path to travel/draw
 linearPath droneTravelledPath; //The path where the drone has actually gone
+linearPathSegmentGrid pathSegmentGrid{path, PATH_SEGMENT_GRID_CELL_SIZE}; //Index used to find the point on the path closest to the drone
+double droneProjectedPathLocation = 0.0; //The path length location on the drawn path closest to the drone (shown as the progress marker)
+bool droneProjectedPathLocationValid = false; //False until the drone has been located on the current path
+bool controllerSupportsQuantizedPaths = false; //Set from the controller's status updates
+QTimer statusDisplayTimer; //Triggers displayLatestStatus
+controllerStatusSnapshot displayedStatus; //The status currently shown in the labels
+int64_t displayedNumberOfAcknowledgedStops = 0; //How many emergency stop acknowledgements the stop button's tooltip reflects
 
 
 /**
@@ -128,6 +187,13 @@ This function converts between the relative coordinate system used with the came
 */
 std::pair<int, int> normalizedImageCoordinateToImageCoordinate(double inputXCoordinate, double inputYCoordinate);
 
+/**
+This function converts an array of points from the relative coordinate system used with the camera image to the coordinate system associated with the scaled image used with the label (see normalizedImageCoordinateToImageCoordinate), doing the transform as a single batch.
+@param inputPoints: The points in the relative coordinate system
+@return: The converted points <imageXCoordinate, imageYCoordinate>
+*/
+std::vector<std::pair<int, int> > normalizedImageCoordinatesToImageCoordinates(const std::vector<fPoint> &inputPoints);
+
 /**
 This function converts between the coordinate system associated with the video display label and the coordinate system associated with the scaled image used with the label.
 @param inputXCoordinate: The relative X Coordinate
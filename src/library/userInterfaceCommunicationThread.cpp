@@ -6,11 +6,12 @@ using namespace soaringPen;
 This function initializes the processManagerThread.
 @param inputCommandSocket: A reference to the ZMQ PAIR socket to use for communications with the controller
 @param inputVideoSubscriberSocket: A reference to the ZMQ SUB socket to use for getting the video steam
+@param inputSharedMemoryFrameRingName: The name of the shared memory frame ring to read frames from (in which case the video subscriber socket only receives frame numbers), or empty if the video subscriber socket receives JPEG frames
 @param inputParent: This is a pointer to the parent QT object (for cascade delete purposes).
 
 @throws: This function can throw exceptions
 */
-userInterfaceCommunicationThread::userInterfaceCommunicationThread(zmq::socket_t &inputCommandSocket, zmq::socket_t &inputVideoSubscriberSocket, QObject *inputParent) : commandSocket(inputCommandSocket), videoSubscriberSocket(inputVideoSubscriberSocket), QThread(inputParent)
+userInterfaceCommunicationThread::userInterfaceCommunicationThread(zmq::socket_t &inputCommandSocket, zmq::socket_t &inputVideoSubscriberSocket, const std::string &inputSharedMemoryFrameRingName, QObject *inputParent) : commandSocket(inputCommandSocket), videoSubscriberSocket(inputVideoSubscriberSocket), QThread(inputParent), statusUpdateReceiver(inputCommandSocket), sharedMemoryFrameRingName(inputSharedMemoryFrameRingName)
 {
 qRegisterMetaType<controller_status_update>("controller_status_update");
 
@@ -29,14 +30,14 @@ wait(); //Wait for thread to exit
 }
 
 /**
-This function sends a follow path command to the ardrone controller.
+This function queues a follow path command to be sent to the ardrone controller.
 @param inputFollowPathCommand: The path to follow (0 length paths are ignored)
 
 @throw: This function can throw exceptions
 */
 void userInterfaceCommunicationThread::sendFollowPathCommand(follow_path_command inputFollowPathCommand)
 {
-if(inputFollowPathCommand.path_x_coordinates_size() == 0 || inputFollowPathCommand.path_y_coordinates_size() == 0)
+if((inputFollowPathCommand.path_x_coordinates_size() == 0 || inputFollowPathCommand.path_y_coordinates_size() == 0) && (inputFollowPathCommand.quantized_path_x_deltas_size() == 0 || inputFollowPathCommand.quantized_path_y_deltas_size() == 0))
 {
 return;
 }
@@ -46,12 +47,12 @@ gui_command command;
 (*command.mutable_follow_path_command_field()) = inputFollowPathCommand;
 
 SOM_TRY
-pylongps::sendProtobufMessage(commandSocket, command);
-SOM_CATCH("Error sending follow path command\n");
+queueCommand(command);
+SOM_CATCH("Error queuing follow path command\n");
 }
 
 /**
-This function sends a return to home command message to the AR drone controller.
+This function queues a return to home command message to be sent to the AR drone controller.
 @throw: This function can throw exceptions 
 */
 void userInterfaceCommunicationThread::sendReturnToHomeCommand()
@@ -61,12 +62,12 @@ gui_command command;
 command.set_return_to_home(true);
 
 SOM_TRY
-pylongps::sendProtobufMessage(commandSocket, command);
-SOM_CATCH("Error sending follow path command\n");
+queueCommand(command);
+SOM_CATCH("Error queuing return to home command\n");
 }
 
 /**
-This function sends a signal to activate the emergency stop message to the AR drone controller.
+This function queues a signal to activate the emergency stop message to be sent to the AR drone controller ahead of any other queued commands.
 @throw: This function can throw exceptions 
 */
 void userInterfaceCommunicationThread::sendEmergencyStopCommand()
@@ -79,11 +80,96 @@ gui_command command;
 (*command.mutable_emergency_stop_command_field()) = stopCommand;
 
 SOM_TRY
-pylongps::sendProtobufMessage(commandSocket, command);
-SOM_CATCH("Error sending follow path command\n");
+queueCommand(command, true);
+SOM_CATCH("Error queuing emergency stop command\n");
+}
+
+/**
+This function adds a command to the queue of commands to send to the controller.
+@param inputCommand: The command to send
+@param inputSendBeforeQueuedCommands: True if the command should be sent before any commands already in the queue (such as emergency stops)
+
+@throws: This function can throw exceptions (such as if the command is missing required fields)
+*/
+void userInterfaceCommunicationThread::queueCommand(const gui_command &inputCommand, bool inputSendBeforeQueuedCommands)
+{
+if(!inputCommand.IsInitialized())
+{ //Would never send, so don't let it block the queue
+throw SOMException("Command is missing required fields\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+if(inputSendBeforeQueuedCommands)
+{
+outboundCommandQueue.emplace_front(inputCommand, std::chrono::steady_clock::now());
+}
+else
+{
+outboundCommandQueue.emplace_back(inputCommand, std::chrono::steady_clock::now());
+}
+
+statusSnapshot.commandQueueDepth = outboundCommandQueue.size();
+statusSnapshotBuffer.publish(statusSnapshot);
+
+//Try to send right away rather than waiting for the next pass of the event loop
+sendQueuedCommands();
+}
+
+/**
+This function sends as many of the queued commands as the command socket will take without blocking.
+*/
+void userInterfaceCommunicationThread::sendQueuedCommands()
+{
+if(outboundCommandQueue.size() == 0)
+{
+return;
+}
+
+int initialQueueDepth = outboundCommandQueue.size();
+while(outboundCommandQueue.size() > 0)
+{
+if(!pylongps::trySendProtobufMessage(commandSocket, outboundCommandQueue.front().first, ZMQ_DONTWAIT))
+{ //Controller isn't taking messages right now, try again later
+break;
+}
+
+statusSnapshot.commandSendLatency = std::chrono::duration<double>(std::chrono::steady_clock::now() - outboundCommandQueue.front().second).count();
+outboundCommandQueue.pop_front();
+}
+
+if(outboundCommandQueue.size() != initialQueueDepth)
+{ //Make the queue metrics visible in the GUI
+statusSnapshot.commandQueueDepth = outboundCommandQueue.size();
+statusSnapshotBuffer.publish(statusSnapshot);
+}
 }
 
 
+/**
+This function sends a ping to the controller if it is time for the next one, counting any pings that have gone unanswered for too long as lost.
+*/
+void userInterfaceCommunicationThread::sendLinkProbe()
+{
+int64_t currentTime = monotonicMicroseconds();
+if(currentTime < nextLinkProbeTime)
+{
+return;
+}
+nextLinkProbeTime = currentTime + LINK_PROBE_INTERVAL*1e6;
+
+int64_t previousNumberOfLostProbes = linkMonitor.getStatistics().numberOfLostProbes;
+linkMonitor.expireProbes(currentTime);
+if(linkMonitor.getStatistics().numberOfLostProbes != previousNumberOfLostProbes)
+{ //Make sure loss is displayed even if the controller has stopped responding entirely
+statusSnapshot.linkLossFraction = linkMonitor.getStatistics().lossFraction;
+statusSnapshotBuffer.publish(statusSnapshot);
+}
+
+//Sent directly rather than queued so that the time in it is the time it was sent (counted as lost if the socket won't take it)
+gui_command ping;
+(*ping.mutable_link_probe_field()) = linkMonitor.createProbe(monotonicMicroseconds());
+pylongps::trySendProtobufMessage(commandSocket, ping, ZMQ_DONTWAIT);
+}
+
 /*
 This function is the code that is run in the seperate thread.  It is responsible for managing the processes and emitting signals via an event loop.
 */
@@ -106,6 +192,12 @@ SOM_TRY
 QCoreApplication::processEvents(); //Process Qt events/slots, etc
 SOM_CATCH("Error processing events");
 
+//Send any commands that couldn't be sent before
+sendQueuedCommands();
+
+//Measure the link to the controller
+sendLinkProbe();
+
 //See if any messages have been received, polling for 10 milliseconds
 SOM_TRY
 if(zmq::poll(pollItems, 2, 1) == 0)
@@ -144,69 +236,157 @@ return;
 }
 
 /**
-This function receives any messages waiting on videoSubscriberSocket and attempts to emit them as a cameraImage Qt signal for display.
+This function receives any messages waiting on videoSubscriberSocket and attempts to emit them as a cameraImage Qt signal for display.  JPEG frames are prefixed with their capture time, which is used to measure their delay.  If frames are being shared through shared memory, the messages are frame numbers and only the latest frame is displayed.
 
 @throws: This function can throw exceptions
 */
 void userInterfaceCommunicationThread::convertVideoFrameMessageToSignal()
 {
+uint64_t latestFrameNumber = 0; //Only used with shared memory frames
 while(true)
 { //Process all queued messages
-//Receive message
-std::unique_ptr<zmq::message_t> messageBuffer;
+bool messageReceived = false;
+SOM_TRY //Receive message
+messageReceived = videoSubscriberSocket.recv(&videoFrameMessageBuffer, ZMQ_DONTWAIT);
+SOM_CATCH("Error receiving video stream message")
 
-SOM_TRY
-messageBuffer.reset(new zmq::message_t);
-SOM_CATCH("Error initializing ZMQ message")
+if(!messageReceived)
+{ //No message to be had
+break;
+}
 
-SOM_TRY //Receive message
-if(videoSubscriberSocket.recv(messageBuffer.get(), ZMQ_DONTWAIT) != true)
+if(sharedMemoryFrameRingName.size() > 0)
+{ //Just a frame number, so only the latest one needs to be converted
+if(videoFrameMessageBuffer.size() == sizeof(uint64_t))
 {
-return; //No message to be had
+memcpy(&latestFrameNumber, videoFrameMessageBuffer.data(), sizeof(uint64_t));
+}
+continue;
 }
-SOM_CATCH("Error receiving video stream message")
 
+if(videoFrameMessageBuffer.size() <= VIDEO_FRAME_CAPTURE_TIME_SIZE)
+{ //Too short to have an image after the capture time
+continue;
+}
+
+int64_t captureTime = 0;
+memcpy(&captureTime, videoFrameMessageBuffer.data(), VIDEO_FRAME_CAPTURE_TIME_SIZE);
+
+QPixmap frame;
 SOM_TRY
-emit cameraImage(convertJPegToQPixMap((char *) messageBuffer->data(), messageBuffer->size()));
-SOM_CATCH("Error converting/emitting video frame\n")
+frame = convertJPegToQPixMap(((char *) videoFrameMessageBuffer.data()) + VIDEO_FRAME_CAPTURE_TIME_SIZE, videoFrameMessageBuffer.size() - VIDEO_FRAME_CAPTURE_TIME_SIZE);
+SOM_CATCH("Error converting video frame\n")
+
+recordFrameDelay(captureTime, true);
+
+SOM_TRY
+emit cameraImage(frame);
+SOM_CATCH("Error emitting video frame\n")
 }
 
+if(latestFrameNumber != 0)
+{
+SOM_TRY
+convertSharedMemoryFrameToSignal(latestFrameNumber);
+SOM_CATCH("Error converting shared memory frame\n")
+}
 }
 
 /**
-This function receives any messages waiting on commandSocket and emits the associated signals for display.
+This function reads a raw frame from the shared memory frame ring and emits it as a cameraImage Qt signal for display.  The frame was captured on this machine, so all of its delay is reported as processing delay.
+@param inputFrameNumber: The number of the frame to read
 
-@throw: This function can throw exceptions
+@throws: This function can throw exceptions
 */
-void userInterfaceCommunicationThread::convertStatusUpdateMessageToSignals()
+void userInterfaceCommunicationThread::convertSharedMemoryFrameToSignal(uint64_t inputFrameNumber)
 {
-while(true)
-{ //Process all queued messages
-//Receive message
-std::unique_ptr<zmq::message_t> messageBuffer;
+if(inputFrameNumber < lastSharedMemoryFrameNumber)
+{ //Frame numbers restarted, so the controller has made a new ring
+frameRing.reset();
+}
+lastSharedMemoryFrameNumber = inputFrameNumber;
 
+if(!frameRing)
+{
+try
+{
+frameRing.reset(new sharedMemoryFrameRing(sharedMemoryFrameRingName));
+}
+catch(const std::exception &)
+{ //Not there (yet), so try again with the next frame
+return;
+}
+}
 
-SOM_TRY
-messageBuffer.reset(new zmq::message_t);
-SOM_CATCH("Error initializing ZMQ message")
+sharedMemoryFrameView frameView;
+if(!frameRing->beginRead(inputFrameNumber, frameView))
+{ //Already overwritten
+return;
+}
 
-/* THIS CAUSED AN ERROR and was not suppose to be here
-SOM_TRY //Receive message
-if(commandSocket.recv(messageBuffer.get(), ZMQ_DONTWAIT) != true)
+const sharedMemoryFrameInformation &frameInformation = frameView.information;
+if(frameInformation.type != CV_8UC3 || frameInformation.width <= 0 || frameInformation.height <= 0 || ((uint64_t) frameInformation.step)*frameInformation.height > frameView.size)
 {
-return; //No message to be had
+throw SOMException("Unsupported shared memory frame format\n", INCORRECT_SERVER_RESPONSE, __FILE__, __LINE__);
 }
-SOM_CATCH("Error receiving status update message")
+
+//Convert straight out of shared memory (BGR -> RGB makes the copy that Qt keeps)
+QImage image = QImage(frameView.data, frameInformation.width, frameInformation.height, frameInformation.step, QImage::Format_RGB888).rgbSwapped();
+
+if(!frameRing->endRead(frameView))
+{ //Overwritten while converting, so the image may be torn
+return;
+}
+
+if(frameInformation.captureTime != 0)
+{
+recordFrameDelay(frameInformation.captureTime, false);
+}
+
+SOM_TRY
+emit cameraImage(QPixmap::fromImage(image));
+SOM_CATCH("Error emitting video frame\n")
+}
+
+/**
+This function records the delay from a frame being captured to it being ready for display in the status snapshot.  For frames that came over the network, the capture time (controller clock) is converted to this machine's clock and half the round trip time is reported as network delay (nothing is recorded until the clock offset has been measured).
+@param inputCaptureTime: When the frame was captured (monotonicMicroseconds on the publisher)
+@param inputFrameCrossedNetwork: True if the frame came over the video socket, false if it came through shared memory (so the capture time is on this machine's clock)
 */
+void userInterfaceCommunicationThread::recordFrameDelay(int64_t inputCaptureTime, bool inputFrameCrossedNetwork)
+{
+if(inputFrameCrossedNetwork && linkMonitor.getStatistics().numberOfResponses == 0)
+{ //Clock offset isn't known yet
+return;
+}
 
+int64_t localCaptureTime = inputFrameCrossedNetwork ? linkMonitor.controllerTimeToLocalTime(inputCaptureTime) : inputCaptureTime;
+double frameDelay = std::max((monotonicMicroseconds() - localCaptureTime)/1000000.0, 0.0);
 
+statusSnapshot.frameCrossedNetwork = inputFrameCrossedNetwork;
+statusSnapshot.frameNetworkDelay = inputFrameCrossedNetwork ? std::min(linkMonitor.getStatistics().smoothedRoundTripTime/2.0, frameDelay) : 0.0;
+statusSnapshot.frameProcessingDelay = frameDelay - statusSnapshot.frameNetworkDelay;
+statusSnapshot.numberOfTimedFrames++;
+statusSnapshotBuffer.publish(statusSnapshot);
+}
+
+/**
+This function receives any messages waiting on commandSocket and emits the associated signals for display.  The fields shown in the status labels are folded into the status snapshot, which is published once after all of the waiting messages have been processed.  Only messages carrying drone status (not bare ping responses) count toward numberOfStatusUpdates.
+
+@throw: This function can throw exceptions
+*/
+void userInterfaceCommunicationThread::convertStatusUpdateMessageToSignals()
+{
+bool snapshotChanged = false;
+
+while(true)
+{ //Process all queued messages
 bool messageReceived = false;
 bool messageDeserialized = false;
-controller_status_update statusUpdate;
 try
 {
 SOM_TRY //Receive/deserialize message
-std::tie(messageReceived, messageDeserialized) = pylongps::receiveProtobufMessage(commandSocket, statusUpdate, ZMQ_DONTWAIT);
+std::tie(messageReceived, messageDeserialized) = statusUpdateReceiver.receive(statusUpdate, ZMQ_DONTWAIT);
 SOM_CATCH("Error receiving status update message")
 }
 catch(const std::exception &inputException)
@@ -214,24 +394,94 @@ catch(const std::exception &inputException)
 fprintf(stderr, "Error: %s\n", inputException.what());
 }
 
+int64_t receiveTime = monotonicMicroseconds();
+
 if(!messageReceived || !messageDeserialized)
-{ //Something when wrong with getting the message, so return
-return; 
+{ //Something when wrong with getting the message, so stop
+break; 
+}
+
+if(statusUpdate.has_link_probe_field())
+{ //Response to one of our pings
+try
+{
+SOM_TRY
+linkMonitor.processResponse(statusUpdate.link_probe_field(), receiveTime);
+SOM_CATCH("Error processing link probe response\n")
+}
+catch(const std::exception &inputException)
+{
+fprintf(stderr, "Error: %s\n", inputException.what());
+}
+
+const linkQualityStatistics &linkStatistics = linkMonitor.getStatistics();
+statusSnapshot.linkRoundTripTime = linkStatistics.smoothedRoundTripTime;
+statusSnapshot.linkLossFraction = linkStatistics.lossFraction;
+snapshotChanged = true;
+}
+
+if(!statusUpdate.has_battery_status() && !statusUpdate.has_x_velocity() && !statusUpdate.has_y_velocity() && !statusUpdate.has_x_position() && !statusUpdate.has_y_position() && !statusUpdate.has_telemetry_batch_field())
+{ //Ping responses don't carry drone status, so they shouldn't count as status updates
+SOM_TRY
+emit controllerStatusUpdate(statusUpdate);
+SOM_CATCH("Error converting/emitting signals\n")
+continue;
 }
 
 //Update moving average
+if(statusUpdate.has_telemetry_batch_field())
+{ //Fold every sample of the batch into the average, so the signals below are only emitted once per batch
+std::vector<fPoint> velocities;
+try
+{
+SOM_TRY
+velocities = getTelemetryVelocities(statusUpdate);
+SOM_CATCH("Error unpacking telemetry batch\n")
+}
+catch(const std::exception &inputException)
+{
+fprintf(stderr, "Error: %s\n", inputException.what());
+continue; //Skip the malformed update
+}
+
+for(const fPoint &velocity : velocities)
+{
+velocityMovingAverage = .8*velocity+.2*velocityMovingAverage;
+}
+}
+else if(statusUpdate.has_x_velocity() || statusUpdate.has_y_velocity())
+{ //Updates without velocities (such as ping responses) leave the average alone
 velocityMovingAverage = .8*fPoint(statusUpdate.x_velocity(), statusUpdate.y_velocity())+.2*velocityMovingAverage;
+}
 
+if(statusUpdate.has_battery_status())
+{
+statusSnapshot.batteryStatus = statusUpdate.battery_status();
+}
+statusSnapshot.xVelocity = ((int) velocityMovingAverage.val[0])/100.0;
+statusSnapshot.yVelocity = ((int) velocityMovingAverage.val[1])/100.0;
+statusSnapshot.numberOfStatusUpdates++;
+snapshotChanged = true;
 
-SOM_TRY //Emit defaults if the optional fields are not present
+SOM_TRY
 emit controllerStatusUpdate(statusUpdate);
-emit droneBatteryStatus(statusUpdate.battery_status());
-emit droneXVelocity(((int) velocityMovingAverage.val[0])/100.0);
-emit droneYVelocity(((int) velocityMovingAverage.val[1])/100.0);
 SOM_CATCH("Error converting/emitting signals\n")
-printf("Emitted data\n");
 }
 
+if(snapshotChanged)
+{ //Only the latest values are needed for display
+statusSnapshotBuffer.publish(statusSnapshot);
+}
+}
+
+/**
+This function retrieves the latest status snapshot if the controller has sent any status updates since the last call.  It doesn't block, so it can be called from the GUI thread at display rate rather than having a signal delivered per status update.
+@param outputSnapshot: The snapshot to store the latest status in (unchanged if there isn't a newer one)
+@return: true if there was a newer snapshot
+*/
+bool userInterfaceCommunicationThread::getLatestStatusSnapshot(controllerStatusSnapshot &outputSnapshot)
+{
+return statusSnapshotBuffer.consume(outputSnapshot);
 }
 
 
@@ -8,11 +8,19 @@
 #include<opencv2/imgproc/imgproc.hpp>
 #include<opencv2/highgui/highgui.hpp>
 #include<memory>
+#include<deque>
+#include<chrono>
+#include<algorithm>
 #include<QPixmap>
 #include<QImage>
 #include<cstdio>
 #include "utilityFunctions.hpp"
+#include "protobufMessageReceiver.hpp"
 #include "fPoint.hpp"
+#include "telemetryBatcher.hpp"
+#include "latestValueBuffer.hpp"
+#include "linkQualityMonitor.hpp"
+#include "sharedMemoryFrameRing.hpp"
 
 #include "gui_command.pb.h"
 #include "follow_path_command.pb.h"
@@ -22,6 +30,25 @@
 namespace soaringPen
 {
 
+/**
+This struct holds the latest value of each of the controller status fields that are displayed in the GUI's labels.
+*/
+struct controllerStatusSnapshot
+{
+double batteryStatus = 0.0; //The amount of charge left in the drone
+double xVelocity = 0.0; //Moving average of the drone's X velocity (rounded for display)
+double yVelocity = 0.0; //Moving average of the drone's Y velocity (rounded for display)
+double linkRoundTripTime = 0.0; //Smoothed network round trip time (seconds) to the controller
+double linkLossFraction = 0.0; //Fraction of pings to the controller that were never answered
+int commandQueueDepth = 0; //The number of commands waiting to be sent to the controller
+double commandSendLatency = 0.0; //The time (seconds) the last command sent spent waiting in the queue
+bool frameCrossedNetwork = false; //True if the latest frame came over the video socket rather than through shared memory
+double frameNetworkDelay = 0.0; //Estimated one way network delay (seconds) of the latest frame (half the round trip time, 0 for shared memory frames)
+double frameProcessingDelay = 0.0; //Time (seconds) from the latest frame's capture to display that wasn't spent on the network
+int64_t numberOfTimedFrames = 0; //The number of frames whose capture time could be compared to the GUI's clock
+int64_t numberOfStatusUpdates = 0; //The number of status updates that have been folded into the snapshot
+};
+
 /**
 This class manages communications between the GUI and the demo manager node.  This mostly consists of translating between QT signals/slots and ZMQ/Protobuf messages.
 */
@@ -34,11 +61,12 @@ public:
 This function initializes the processManagerThread.
 @param inputCommandSocket: A reference to the ZMQ PAIR socket to use for communications with the controller
 @param inputVideoSubscriberSocket: A reference to the ZMQ SUB socket to use for getting the video steam
+@param inputSharedMemoryFrameRingName: The name of the shared memory frame ring to read frames from (in which case the video subscriber socket only receives frame numbers), or empty if the video subscriber socket receives JPEG frames
 @param inputParent: This is a pointer to the parent QT object (for cascade delete purposes).
 
 @throws: This function can throw exceptions
 */
-userInterfaceCommunicationThread(zmq::socket_t &inputCommandSocket, zmq::socket_t &inputVideoSubscriberSocket, QObject *inputParent = nullptr);
+userInterfaceCommunicationThread(zmq::socket_t &inputCommandSocket, zmq::socket_t &inputVideoSubscriberSocket, const std::string &inputSharedMemoryFrameRingName = "", QObject *inputParent = nullptr);
 
 /*
 This function cleans up the object and waits for the thread to stop running before returning.
@@ -50,9 +78,16 @@ zmq::socket_t &videoSubscriberSocket;
 
 bool shutdown = false; //Flag to indicate thread should shutdown
 
+/**
+This function retrieves the latest status snapshot if the controller has sent any status updates since the last call.  It doesn't block, so it can be called from the GUI thread at display rate rather than having a signal delivered per status update.
+@param outputSnapshot: The snapshot to store the latest status in (unchanged if there isn't a newer one)
+@return: true if there was a newer snapshot
+*/
+bool getLatestStatusSnapshot(controllerStatusSnapshot &outputSnapshot);
+
 public slots:
 /**
-This function sends a follow path command to the ardrone controller.
+This function queues a follow path command to be sent to the ardrone controller.
 @param inputFollowPathCommand: The path to follow (0 length paths are ignored)
 
 @throw: This function can throw exceptions
@@ -60,13 +95,13 @@ This function sends a follow path command to the ardrone controller.
 void sendFollowPathCommand(follow_path_command inputFollowPathCommand);
 
 /**
-This function sends a return to home command message to the AR drone controller.
+This function queues a return to home command message to be sent to the AR drone controller.
 @throw: This function can throw exceptions 
 */
 void sendReturnToHomeCommand();
 
 /**
-This function sends a signal to activate the emergency stop message to the AR drone controller.
+This function queues a signal to activate the emergency stop message to be sent to the AR drone controller ahead of any other queued commands.
 @throw: This function can throw exceptions 
 */
 void sendEmergencyStopCommand();
@@ -78,27 +113,43 @@ This signal emits an image to display as part of the video stream from the contr
 void cameraImage(QPixmap);
 
 /**
-This signal emits the current battery percentage of the drone's battery.
+Emits the status updates associated with the controller's updates (including their telemetry batches, so every sample is passed on).  The fields shown in the status labels are retrieved with getLatestStatusSnapshot instead.
 */
-void droneBatteryStatus(double);
+void controllerStatusUpdate(controller_status_update);
+
+protected:
+fPoint velocityMovingAverage;
+controllerStatusSnapshot statusSnapshot; //Accumulates the latest status fields (only used from this thread)
+latestValueBuffer<controllerStatusSnapshot> statusSnapshotBuffer; //Hands statusSnapshot to the GUI thread
+linkQualityMonitor linkMonitor; //Measures the link to the controller (its clock offset can be used to convert controller timestamps to local time)
+int64_t nextLinkProbeTime = 0; //When the next ping should be sent (monotonicMicroseconds)
+pylongps::protobufMessageReceiver statusUpdateReceiver; //Receives status updates from commandSocket, reusing its ZMQ message
+controller_status_update statusUpdate; //Reused so that parsing status updates doesn't allocate once its fields have been allocated
+zmq::message_t videoFrameMessageBuffer; //Reused for each received video frame
+std::string sharedMemoryFrameRingName; //Empty if frames are received as JPEGs
+std::unique_ptr<sharedMemoryFrameRing> frameRing; //Opened when the first frame number arrives (the controller may not have created it yet)
+uint64_t lastSharedMemoryFrameNumber = 0;
+
+std::deque<std::pair<gui_command, std::chrono::steady_clock::time_point> > outboundCommandQueue; //Commands waiting to be sent to the controller and when they were queued (only used from this thread)
 
 /**
-This signal emits the drone's current X velocity when it receives an update.
+This function adds a command to the queue of commands to send to the controller.
+@param inputCommand: The command to send
+@param inputSendBeforeQueuedCommands: True if the command should be sent before any commands already in the queue (such as emergency stops)
+
+@throws: This function can throw exceptions (such as if the command is missing required fields)
 */
-void droneXVelocity(double);
+void queueCommand(const gui_command &inputCommand, bool inputSendBeforeQueuedCommands = false);
 
 /**
-This signal emits the drone's current Y velocity when it receives an update.
+This function sends as many of the queued commands as the command socket will take without blocking.
 */
-void droneYVelocity(double);
+void sendQueuedCommands();
 
 /**
-Emits the status updates associated with the controller's updates.
+This function sends a ping to the controller if it is time for the next one, counting any pings that have gone unanswered for too long as lost.
 */
-void controllerStatusUpdate(controller_status_update);
-
-protected:
-fPoint velocityMovingAverage;
+void sendLinkProbe();
 
 /*
 This function is the code that is run in the seperate thread.  It is responsible for managing the processes and emitting signals via an event loop.
@@ -106,12 +157,27 @@ This function is the code that is run in the seperate thread.  It is responsible
 void run() Q_DECL_OVERRIDE;
 
 /**
-This function receives any messages waiting on videoSubscriberSocket and attempts to emit them as a cameraImage Qt signal for display.
+This function receives any messages waiting on videoSubscriberSocket and attempts to emit them as a cameraImage Qt signal for display.  JPEG frames are prefixed with their capture time, which is used to measure their delay.  If frames are being shared through shared memory, the messages are frame numbers and only the latest frame is displayed.
 
 @throws: This function can throw exceptions
 */
 void convertVideoFrameMessageToSignal();
 
+/**
+This function reads a raw frame from the shared memory frame ring and emits it as a cameraImage Qt signal for display.  The frame was captured on this machine, so all of its delay is reported as processing delay.
+@param inputFrameNumber: The number of the frame to read
+
+@throws: This function can throw exceptions
+*/
+void convertSharedMemoryFrameToSignal(uint64_t inputFrameNumber);
+
+/**
+This function records the delay from a frame being captured to it being ready for display in the status snapshot.  For frames that came over the network, the capture time (controller clock) is converted to this machine's clock and half the round trip time is reported as network delay (nothing is recorded until the clock offset has been measured).
+@param inputCaptureTime: When the frame was captured (monotonicMicroseconds on the publisher)
+@param inputFrameCrossedNetwork: True if the frame came over the video socket, false if it came through shared memory (so the capture time is on this machine's clock)
+*/
+void recordFrameDelay(int64_t inputCaptureTime, bool inputFrameCrossedNetwork);
+
 /**
 This function receives any messages waiting on commandSocket and emits the associated signals for display.
 
@@ -1,17 +1,24 @@
 #include "utilityFunctions.hpp"
+#include "protobufMessageReceiver.hpp"
 
  /**
-This function compactly allows binding a ZMQ socket to inproc address without needing to specify an exact address.  The function will try binding to addresses in the format: inproc://inputBaseString.inputExtensionNumberAsString and will try repeatedly while incrementing inputExtensionNumber until it succeeds or the maximum number of tries has been exceeded.
+This function compactly allows binding a ZMQ socket to inproc (or ipc) address without needing to specify an exact address.  The function will try binding to addresses in the format: inputTransport://inputBaseString.inputExtensionNumberAsString and will try repeatedly while incrementing inputExtensionNumber until it succeeds or the maximum number of tries has been exceeded.  For ipc the base string is a file system path (such as "/tmp/soaringPenVideo").  Note that ZMQ replaces stale (or live) ipc socket files rather than reporting that the address is in use, so ipc base strings should be unique to the application.
 @param inputSocket: The ZMQ socket to bind
 @param inputBaseString: The base string to use
 @param inputExtensionNumber: The extension number to start with
 @param inputMaximumNumberOfTries: How many times to try binding before giving up
+@param inputTransport: The transport to bind with ("inproc" or "ipc")
 @return: A tuple of form <connectionString ("inproc://etc"), extensionNumberThatWorked>
 
-@throws: This function can throw exceptions if the bind call throws something besides "address taken" or the number of tries are exceeded
+@throws: This function can throw exceptions if the bind call throws something besides "address taken", the transport isn't supported or the number of tries are exceeded
 */
-std::tuple<std::string, int> pylongps::bindZMQSocketWithAutomaticAddressGeneration(zmq::socket_t &inputSocket, const std::string &inputBaseString, int inputExtensionNumber, unsigned int inputMaximumNumberOfTries)
+std::tuple<std::string, int> pylongps::bindZMQSocketWithAutomaticAddressGeneration(zmq::socket_t &inputSocket, const std::string &inputBaseString, int inputExtensionNumber, unsigned int inputMaximumNumberOfTries, const std::string &inputTransport)
 {
+if(inputTransport != "inproc" && inputTransport != "ipc")
+{
+throw SOMException("Unsupported transport for automatic address generation: " + inputTransport + "\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
 bool socketBindSuccessful = false;
 std::string connectionString;
 int extensionNumber = inputExtensionNumber;
@@ -20,7 +27,7 @@ for(int i=0; i<inputMaximumNumberOfTries; i++)
 {
 try //Attempt to bind the socket
 {
-connectionString = std::string("inproc://") + inputBaseString + std::string(".") + std::to_string(extensionNumber);
+connectionString = inputTransport + std::string("://") + inputBaseString + std::string(".") + std::to_string(extensionNumber);
 inputSocket.bind(connectionString.c_str());
 socketBindSuccessful = true; //Got this far without throwing
 break;
@@ -48,115 +55,158 @@ return make_tuple(connectionString, extensionNumber);
 }
 
 /**
-This function is used to send a protobuf object as a ZMQ message, with optional preappended or postappended data.  It manages serialization and will throw an exception if required fields of the message are missing.
-@param inputSocketToSendFrom: The socket to send from
-@param inputMessage: The message to send
-@param inputDataToPreappend: The data to place in the ZMQ message before the serialized protobuf object
-@param inputDataToPostAppend: The data to place in the ZMQ message after the serialized protobuf object
+This function converts an endpoint to connect to into a full ZMQ endpoint.  Endpoints with a transport (such as "tcp://192.168.1.5:9001", "ipc:///tmp/soaringPenVideo" or "inproc://soaringPenVideo") are returned unchanged and endpoints without one ("ip:port") are assumed to be TCP.
+@param inputEndpoint: The endpoint to convert
+@return: The ZMQ endpoint
 
-@throws: This function can throw exceptions
+@throws: This function can throw exceptions (such as if the endpoint is empty or the transport is unknown)
 */
-void pylongps::sendProtobufMessage(zmq::socket_t &inputSocketToSendFrom, const google::protobuf::Message &inputMessage, const std::string &inputDataToPreappend, const std::string &inputDataToPostAppend)
+std::string pylongps::normalizeZMQConnectionEndpoint(const std::string &inputEndpoint)
 {
-std::string serializedMessage;
+if(inputEndpoint.size() == 0)
+{
+throw SOMException("Empty endpoint\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
 
-SOM_TRY
-inputMessage.SerializeToString(&serializedMessage);
-SOM_CATCH("Error serializing message to string\n")
+if(inputEndpoint.find("://") == std::string::npos)
+{
+return "tcp://" + inputEndpoint;
+}
 
-std::string dataToSend = inputDataToPreappend + serializedMessage + inputDataToPostAppend;
+std::string transport = inputEndpoint.substr(0, inputEndpoint.find("://"));
+if(transport != "tcp" && transport != "ipc" && transport != "inproc" && transport != "pgm" && transport != "epgm")
+{
+throw SOMException("Unknown ZMQ transport in endpoint: " + inputEndpoint + "\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
 
-SOM_TRY
-inputSocketToSendFrom.send(dataToSend.c_str(), dataToSend.size());
-SOM_CATCH("Error, unable to send message\n")
+return inputEndpoint;
 }
 
 /**
-This function is used to receive and deserialize a protobuf object from a ZMQ socket.
-@param inputSocketToReceiveFrom: This is the socket to receive the object from
-@param inputMessageBuffer: This is the buffer to place the received object in
-@param inputFlags: The flags to pass to the ZMQ socket
-@param inputPreappendedDataBuffer: The buffer to place x bytes before the message in
-@param inputPreappendedDataSize: How much data to expect to be preappended
-@param inputPostappendedDataBuffer: The buffer to place x bytes before the message in
-@param inputPostappendedDataSize: How much data to expect to be postappended
-@return: <true if message received, true if message deserialized correctly>
+This function converts an endpoint to bind to into a full ZMQ endpoint.  Endpoints with a transport are returned unchanged, a plain port number (such as "9001") binds TCP on that port of every interface and anything else ("interface:port") is assumed to be TCP.
+@param inputEndpoint: The endpoint to convert
+@return: The ZMQ endpoint
 
-@throws: This function can throw exceptions
+@throws: This function can throw exceptions (such as if the endpoint is empty or the transport is unknown)
 */
-std::tuple<bool, bool> pylongps::receiveProtobufMessage(zmq::socket_t &inputSocketToReceiveFrom, google::protobuf::Message &inputMessageBuffer, int inputFlags, char *inputPreappendedDataBuffer, int inputPreappendedDataSize, char *inputPostappendedDataBuffer, int inputPostappendedDataSize)
+std::string pylongps::normalizeZMQBindEndpoint(const std::string &inputEndpoint)
 {
-if(inputPreappendedDataSize < 0 || inputPostappendedDataSize < 0)
+if(inputEndpoint.size() == 0)
 {
-throw SOMException("Negative data size\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+throw SOMException("Empty endpoint\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
 }
 
-if((inputPreappendedDataSize > 0 && inputPreappendedDataBuffer == nullptr) || (inputPostappendedDataSize < 0 && inputPostappendedDataBuffer == nullptr))
-{
-throw SOMException("Data size > 0 but buffer is nullptr\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+if(inputEndpoint.find_first_not_of("0123456789") == std::string::npos)
+{ //Just a port
+return "tcp://*:" + inputEndpoint;
 }
 
-bool messageReceived = false;
-bool messageDeserialized = false;
-
-std::unique_ptr<zmq::message_t> messageBuffer;
-
+std::string endpoint;
 SOM_TRY
-messageBuffer.reset(new zmq::message_t);
-SOM_CATCH("Error initializing ZMQ message")
+endpoint = normalizeZMQConnectionEndpoint(inputEndpoint);
+SOM_CATCH("Invalid endpoint\n")
 
-SOM_TRY
-messageReceived = inputSocketToReceiveFrom.recv(messageBuffer.get(), inputFlags);
-SOM_CATCH("Error, unable to receive message\n")
+return endpoint;
+}
 
-if(messageReceived == false)
-{ //Didn't get a message
-return std::tuple<bool, bool>(messageReceived, messageDeserialized);
+/**
+This function is used to send a protobuf object as a ZMQ message, with optional preappended or postappended data.  It manages serialization and will throw an exception if required fields of the message are missing.
+@param inputSocketToSendFrom: The socket to send from
+@param inputMessage: The message to send
+@param inputDataToPreappend: The data to place in the ZMQ message before the serialized protobuf object
+@param inputDataToPostAppend: The data to place in the ZMQ message after the serialized protobuf object
+
+@throws: This function can throw exceptions
+*/
+void pylongps::sendProtobufMessage(zmq::socket_t &inputSocketToSendFrom, const google::protobuf::Message &inputMessage, const std::string &inputDataToPreappend, const std::string &inputDataToPostAppend)
+{
+if(!inputMessage.IsInitialized())
+{
+throw SOMException("Message is missing required fields\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
 }
 
-//Attempt to retrieve any preappended data
-if(messageBuffer->size() < inputPreappendedDataSize)
-{ //Message isn't valid (smaller than expected preappended data)
-return std::tuple<bool, bool>(messageReceived, messageDeserialized);
+if(!trySendProtobufMessage(inputSocketToSendFrom, inputMessage, 0, inputDataToPreappend.c_str(), inputDataToPreappend.size(), inputDataToPostAppend.c_str(), inputDataToPostAppend.size()))
+{
+throw SOMException("Error, unable to send message\n", ZMQ_ERROR, __FILE__, __LINE__);
 }
-else if(inputPreappendedDataSize > 0)
-{ //Preappended data is expected and the message is large enough to get it
-memcpy((void *) inputPreappendedDataBuffer, messageBuffer->data(), inputPreappendedDataSize);
 }
 
-//Deserialize message
-inputMessageBuffer.ParseFromArray(((char *) messageBuffer->data())+inputPreappendedDataSize, messageBuffer->size()-inputPreappendedDataSize);
+/**
+This function is used to send a protobuf object as a ZMQ message, with optional preappended or postappended data.  The message is sized once and the object is serialized directly into the ZMQ message's buffer (along with the extra data), so no intermediate strings are made.  Failures are reported through the return value rather than exceptions, so it is suitable for high rate senders.
+@param inputSocketToSendFrom: The socket to send from
+@param inputMessage: The message to send
+@param inputFlags: The flags to pass to the ZMQ socket (such as ZMQ_DONTWAIT)
+@param inputDataToPreappend: The data to place in the ZMQ message before the serialized protobuf object
+@param inputDataToPreappendSize: How many bytes of data to preappend
+@param inputDataToPostappend: The data to place in the ZMQ message after the serialized protobuf object
+@param inputDataToPostappendSize: How many bytes of data to postappend
+@return: true if the message was sent, false if it couldn't be (missing required fields, invalid arguments, ZMQ error or the send would block with ZMQ_DONTWAIT)
+*/
+bool pylongps::trySendProtobufMessage(zmq::socket_t &inputSocketToSendFrom, const google::protobuf::Message &inputMessage, int inputFlags, const char *inputDataToPreappend, int inputDataToPreappendSize, const char *inputDataToPostappend, int inputDataToPostappendSize)
+{
+if(inputDataToPreappendSize < 0 || inputDataToPostappendSize < 0 || (inputDataToPreappendSize > 0 && inputDataToPreappend == nullptr) || (inputDataToPostappendSize > 0 && inputDataToPostappend == nullptr))
+{
+return false;
+}
 
-if(!inputMessageBuffer.IsInitialized())
+if(!inputMessage.IsInitialized())
 {
-return std::tuple<bool, bool>(messageReceived, messageDeserialized);
+return false;
 }
 
-if(inputPostappendedDataSize > 0)
+//Computing the size caches the sizes of the submessages, which the serialization below reuses
+size_t protobufMessageSize = inputMessage.ByteSizeLong();
+
+try
 {
-int protobufMessageSize = inputMessageBuffer.ByteSize();
+zmq::message_t messageBuffer(inputDataToPreappendSize + protobufMessageSize + inputDataToPostappendSize);
+char *messageData = (char *) messageBuffer.data();
 
-if((protobufMessageSize+inputPreappendedDataSize+inputPostappendedDataSize) > messageBuffer->size())
+if(inputDataToPreappendSize > 0)
 {
-return std::tuple<bool, bool>(messageReceived, messageDeserialized);
+memcpy((void *) messageData, (const void *) inputDataToPreappend, inputDataToPreappendSize);
 }
-else
+
+inputMessage.SerializeWithCachedSizesToArray((google::protobuf::uint8 *) (messageData + inputDataToPreappendSize));
+
+if(inputDataToPostappendSize > 0)
 {
-memcpy((void *) inputPostappendedDataBuffer, (void *) (((char *) messageBuffer->data()) + protobufMessageSize + inputPreappendedDataSize), inputPostappendedDataSize);
-messageDeserialized = true;
+memcpy((void *) (messageData + inputDataToPreappendSize + protobufMessageSize), (const void *) inputDataToPostappend, inputDataToPostappendSize);
 }
 
+return inputSocketToSendFrom.send(messageBuffer, inputFlags);
+}
+catch(const zmq::error_t &)
+{ //Couldn't make or send the ZMQ message
+return false;
 }
-else
-{
-messageDeserialized = true;
 }
 
-return std::tuple<bool, bool>(messageReceived, messageDeserialized);
+/**
+This function is used to receive and deserialize a protobuf object from a ZMQ socket.
+@param inputSocketToReceiveFrom: This is the socket to receive the object from
+@param inputMessageBuffer: This is the buffer to place the received object in
+@param inputFlags: The flags to pass to the ZMQ socket
+@param inputPreappendedDataBuffer: The buffer to place x bytes before the message in
+@param inputPreappendedDataSize: How much data to expect to be preappended
+@param inputPostappendedDataBuffer: The buffer to place x bytes before the message in
+@param inputPostappendedDataSize: How much data to expect to be postappended
+@return: <true if message received, true if message deserialized correctly>
+
+@throws: This function can throw exceptions
+*/
+std::tuple<bool, bool> pylongps::receiveProtobufMessage(zmq::socket_t &inputSocketToReceiveFrom, google::protobuf::Message &inputMessageBuffer, int inputFlags, char *inputPreappendedDataBuffer, int inputPreappendedDataSize, char *inputPostappendedDataBuffer, int inputPostappendedDataSize)
+{
+//One shot receiver, use a protobufMessageReceiver directly to reuse the ZMQ message between calls
+protobufMessageReceiver receiver(inputSocketToReceiveFrom);
+
+SOM_TRY
+return receiver.receive(inputMessageBuffer, inputFlags, inputPreappendedDataBuffer, inputPreappendedDataSize, inputPostappendedDataBuffer, inputPostappendedDataSize);
+SOM_CATCH("Error receiving message\n")
 }
 
 /**
-This function sends the given protobuf object as a request using the given socket.  It then waits for a reply and deserializes the received object, placing it in the buffer.
+This function sends the given protobuf object as a request using the given socket.  It then waits (indefinitely) for a reply and deserializes the received object, placing it in the buffer.  Use asynchronousRemoteProcedureCallClient when calls need timeouts or shouldn't wait for each other.
 @param inputSocketToSendAndReceiveFrom: The ZMQ socket to send the request with and get back the reply from
 @param inputRequestMessage: The message to send to the other side of the connection
 @param inputMessageReplyBuffer: The buffer to place the deserialized reply in
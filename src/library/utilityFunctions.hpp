@@ -13,16 +13,35 @@ namespace pylongps
 {
 
 /**
-This function compactly allows binding a ZMQ socket to inproc address without needing to specify an exact address.  The function will try binding to addresses in the format: inproc://inputBaseString.inputExtensionNumberAsString and will try repeatedly while incrementing inputExtensionNumber until it succeeds or the maximum number of tries has been exceeded.
+This function compactly allows binding a ZMQ socket to inproc (or ipc) address without needing to specify an exact address.  The function will try binding to addresses in the format: inputTransport://inputBaseString.inputExtensionNumberAsString and will try repeatedly while incrementing inputExtensionNumber until it succeeds or the maximum number of tries has been exceeded.  For ipc the base string is a file system path (such as "/tmp/soaringPenVideo").  Note that ZMQ replaces stale (or live) ipc socket files rather than reporting that the address is in use, so ipc base strings should be unique to the application.
 @param inputSocket: The ZMQ socket to bind
 @param inputBaseString: The base string to use
 @param inputExtensionNumber: The extension number to start with
 @param inputMaximumNumberOfTries: How many times to try binding before giving up
+@param inputTransport: The transport to bind with ("inproc" or "ipc")
 @return: A tuple of form <connectionString ("inproc://etc"), extensionNumberThatWorked>
 
-@throws: This function can throw exceptions if the bind call throws something besides "address taken" or the number of tries are exceeded
+@throws: This function can throw exceptions if the bind call throws something besides "address taken", the transport isn't supported or the number of tries are exceeded
 */
-std::tuple<std::string, int> bindZMQSocketWithAutomaticAddressGeneration(zmq::socket_t &inputSocket, const std::string &inputBaseString = "", int inputExtensionNumber = 0, unsigned int inputMaximumNumberOfTries = 1000);
+std::tuple<std::string, int> bindZMQSocketWithAutomaticAddressGeneration(zmq::socket_t &inputSocket, const std::string &inputBaseString = "", int inputExtensionNumber = 0, unsigned int inputMaximumNumberOfTries = 1000, const std::string &inputTransport = "inproc");
+
+/**
+This function converts an endpoint to connect to into a full ZMQ endpoint.  Endpoints with a transport (such as "tcp://192.168.1.5:9001", "ipc:///tmp/soaringPenVideo" or "inproc://soaringPenVideo") are returned unchanged and endpoints without one ("ip:port") are assumed to be TCP.
+@param inputEndpoint: The endpoint to convert
+@return: The ZMQ endpoint
+
+@throws: This function can throw exceptions (such as if the endpoint is empty or the transport is unknown)
+*/
+std::string normalizeZMQConnectionEndpoint(const std::string &inputEndpoint);
+
+/**
+This function converts an endpoint to bind to into a full ZMQ endpoint.  Endpoints with a transport are returned unchanged, a plain port number (such as "9001") binds TCP on that port of every interface and anything else ("interface:port") is assumed to be TCP.
+@param inputEndpoint: The endpoint to convert
+@return: The ZMQ endpoint
+
+@throws: This function can throw exceptions (such as if the endpoint is empty or the transport is unknown)
+*/
+std::string normalizeZMQBindEndpoint(const std::string &inputEndpoint);
 
 template<typename inputClass> void print(const inputClass &inputObject)
 {
@@ -40,6 +59,19 @@ This function is used to send a protobuf object as a ZMQ message, with optional
 */
 void sendProtobufMessage(zmq::socket_t &inputSocketToSendFrom, const google::protobuf::Message &inputMessage, const std::string &inputDataToPreappend = "", const std::string &inputDataToPostAppend = "");
 
+/**
+This function is used to send a protobuf object as a ZMQ message, with optional preappended or postappended data.  The message is sized once and the object is serialized directly into the ZMQ message's buffer (along with the extra data), so no intermediate strings are made.  Failures are reported through the return value rather than exceptions, so it is suitable for high rate senders.
+@param inputSocketToSendFrom: The socket to send from
+@param inputMessage: The message to send
+@param inputFlags: The flags to pass to the ZMQ socket (such as ZMQ_DONTWAIT)
+@param inputDataToPreappend: The data to place in the ZMQ message before the serialized protobuf object
+@param inputDataToPreappendSize: How many bytes of data to preappend
+@param inputDataToPostappend: The data to place in the ZMQ message after the serialized protobuf object
+@param inputDataToPostappendSize: How many bytes of data to postappend
+@return: true if the message was sent, false if it couldn't be (missing required fields, invalid arguments, ZMQ error or the send would block with ZMQ_DONTWAIT)
+*/
+bool trySendProtobufMessage(zmq::socket_t &inputSocketToSendFrom, const google::protobuf::Message &inputMessage, int inputFlags = 0, const char *inputDataToPreappend = nullptr, int inputDataToPreappendSize = 0, const char *inputDataToPostappend = nullptr, int inputDataToPostappendSize = 0);
+
 /**
 This function is used to receive and deserialize a protobuf object from a ZMQ socket.
 @param inputSocketToReceiveFrom: This is the socket to receive the object from
@@ -56,7 +88,7 @@ This function is used to receive and deserialize a protobuf object from a ZMQ so
 std::tuple<bool, bool> receiveProtobufMessage(zmq::socket_t &inputSocketToReceiveFrom, google::protobuf::Message &inputMessageBuffer, int inputFlags = 0, char *inputPreappendedDataBuffer = nullptr, int inputPreappendedDataSize = 0, char *inputPostappendedDataBuffer = nullptr, int inputPostappendedDataSize = 0);
 
 /**
-This function sends the given protobuf object as a request using the given socket.  It then waits for a reply and deserializes the received object, placing it in the buffer.
+This function sends the given protobuf object as a request using the given socket.  It then waits (indefinitely) for a reply and deserializes the received object, placing it in the buffer.  Use asynchronousRemoteProcedureCallClient when calls need timeouts or shouldn't wait for each other.
 @param inputSocketToSendAndReceiveFrom: The ZMQ socket to send the request with and get back the reply from
 @param inputRequestMessage: The message to send to the other side of the connection
 @param inputMessageReplyBuffer: The buffer to place the deserialized reply in
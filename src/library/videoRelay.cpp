@@ -0,0 +1,378 @@
+#include "videoRelay.hpp"
+#include<cstddef>
+#include<sys/socket.h>
+#include<netinet/in.h>
+#include<linux/tcp.h>
+#include<arpa/inet.h>
+
+using namespace soaringPen;
+
+namespace
+{
+
+/**
+This function returns the address of the peer of a TCP connection.
+@param inputFileDescriptor: The connection's file descriptor
+@return: The peer's address as tcp://address:port (empty if it isn't a connected TCP socket)
+*/
+std::string getPeerAddress(int inputFileDescriptor)
+{
+struct sockaddr_storage peerAddress;
+socklen_t peerAddressSize = sizeof(peerAddress);
+if(getpeername(inputFileDescriptor, (struct sockaddr *) &peerAddress, &peerAddressSize) != 0)
+{
+return "";
+}
+
+char addressBuffer[INET6_ADDRSTRLEN];
+if(peerAddress.ss_family == AF_INET)
+{
+const struct sockaddr_in &address = *((const struct sockaddr_in *) &peerAddress);
+if(inet_ntop(AF_INET, &address.sin_addr, addressBuffer, sizeof(addressBuffer)) != nullptr)
+{
+return std::string("tcp://") + addressBuffer + ":" + std::to_string(ntohs(address.sin_port));
+}
+}
+else if(peerAddress.ss_family == AF_INET6)
+{
+const struct sockaddr_in6 &address = *((const struct sockaddr_in6 *) &peerAddress);
+if(inet_ntop(AF_INET6, &address.sin6_addr, addressBuffer, sizeof(addressBuffer)) != nullptr)
+{
+return std::string("tcp://[") + addressBuffer + "]:" + std::to_string(ntohs(address.sin6_port));
+}
+}
+
+return "";
+}
+
+}
+
+/**
+This function connects to the video source and binds the socket the subscribers connect to.
+@param inputContext: The ZMQ context to use (must outlive the relay)
+@param inputSourceEndpoint: The video publisher to connect to (see normalizeZMQConnectionEndpoint)
+@param inputSubscriberEndpoint: The endpoint to bind for the subscribers (see normalizeZMQBindEndpoint)
+@param inputStatisticsInterval: How often (seconds) to measure and print the throughput statistics (0 to not print them)
+@param inputCachedFrameInterval: How often (seconds) to update the frame given to new subscribers (0 to update it with every frame)
+
+@throws: This function can throw exceptions
+*/
+videoRelay::videoRelay(zmq::context_t &inputContext, const std::string &inputSourceEndpoint, const std::string &inputSubscriberEndpoint, double inputStatisticsInterval, double inputCachedFrameInterval) : statisticsInterval(inputStatisticsInterval), cachedFrameInterval(inputCachedFrameInterval)
+{
+if(statisticsInterval < 0.0 || cachedFrameInterval < 0.0)
+{
+throw SOMException("Negative interval\n", INVALID_FUNCTION_INPUT, __FILE__, __LINE__);
+}
+
+SOM_TRY //Initialize
+subscriberSocket.reset(new zmq::socket_t(inputContext, ZMQ_XPUB));
+SOM_CATCH("Error initializing subscriber socket\n")
+
+SOM_TRY
+int queueSize = VIDEO_RELAY_SUBSCRIBER_QUEUE_SIZE;
+subscriberSocket->setsockopt(ZMQ_SNDHWM, &queueSize, sizeof(queueSize));
+SOM_CATCH("Error setting subscriber socket options\n")
+
+//Monitor connections so each subscriber's statistics can be tracked
+std::string monitorEndpoint = "inproc://videoRelayMonitor" + std::to_string((uintptr_t) this);
+if(zmq_socket_monitor((void *) (*subscriberSocket), monitorEndpoint.c_str(), ZMQ_EVENT_ACCEPTED | ZMQ_EVENT_DISCONNECTED) != 0)
+{
+throw SOMException("Unable to monitor subscriber socket\n", ZMQ_ERROR, __FILE__, __LINE__);
+}
+
+SOM_TRY
+monitorSocket.reset(new zmq::socket_t(inputContext, ZMQ_PAIR));
+monitorSocket->connect(monitorEndpoint.c_str());
+SOM_CATCH("Error connecting to subscriber socket monitor\n")
+
+SOM_TRY //Bind
+std::string bindingAddress = pylongps::normalizeZMQBindEndpoint(inputSubscriberEndpoint);
+subscriberSocket->bind(bindingAddress.c_str());
+SOM_CATCH("Error binding subscriber socket\n")
+
+SOM_TRY //Initialize
+sourceSocket.reset(new zmq::socket_t(inputContext, ZMQ_XSUB));
+SOM_CATCH("Error initializing source socket\n")
+
+SOM_TRY //Connect
+std::string connectionAddress = pylongps::normalizeZMQConnectionEndpoint(inputSourceEndpoint);
+sourceSocket->connect(connectionAddress.c_str());
+SOM_CATCH("Error connecting to video source\n")
+
+lastStatisticsTime = monotonicMicroseconds();
+}
+
+/**
+This function relays video until shutdown is set.
+
+@throws: This function can throw exceptions
+*/
+void videoRelay::run()
+{
+zmq::pollitem_t pollItems[] = { {(void *) (*sourceSocket), 0, ZMQ_POLLIN, 0}, {(void *) (*subscriberSocket), 0, ZMQ_POLLIN, 0}, {(void *) (*monitorSocket), 0, ZMQ_POLLIN, 0} };
+
+while(!shutdown)
+{
+SOM_TRY //Wake up at least every 100 ms to check for shutdown
+zmq::poll(pollItems, 3, 100);
+SOM_CATCH("Error polling\n")
+
+if(pollItems[0].revents & ZMQ_POLLIN)
+{
+SOM_TRY
+relayFrame();
+SOM_CATCH("Error relaying frame\n")
+}
+
+if(pollItems[1].revents & ZMQ_POLLIN)
+{
+SOM_TRY
+relaySubscription();
+SOM_CATCH("Error relaying subscription\n")
+}
+
+if(pollItems[2].revents & ZMQ_POLLIN)
+{
+SOM_TRY
+processMonitorEvent();
+SOM_CATCH("Error processing monitor event\n")
+}
+
+int64_t currentTime = monotonicMicroseconds();
+if(statisticsInterval > 0.0 && (currentTime - lastStatisticsTime) >= statisticsInterval*1000000.0)
+{
+updateStatistics(currentTime);
+printStatistics();
+}
+}
+}
+
+/**
+This function returns the statistics of the currently connected subscribers.
+@return: The statistics, indexed by the file descriptor of the subscriber's connection
+*/
+const std::map<int, videoRelaySubscriberStatistics> &videoRelay::getSubscriberStatistics() const
+{
+return subscriberStatistics;
+}
+
+/**
+This function receives a frame from the source, caches it (updating the welcome message for new subscribers if cachedFrameInterval has passed) and sends it to the subscribers.
+
+@throws: This function can throw exceptions
+*/
+void videoRelay::relayFrame()
+{
+//Receive straight into the cache (reusing its messages), replacing the previous frame
+size_t numberOfPartsReceived = 0;
+bool morePartsToReceive = true;
+while(morePartsToReceive)
+{
+if(numberOfPartsReceived >= cachedFrame.size())
+{
+cachedFrame.emplace_back(new zmq::message_t);
+}
+
+zmq::message_t &part = *cachedFrame[numberOfPartsReceived];
+SOM_TRY //Failing to get the first part leaves the cached frame untouched
+if(!sourceSocket->recv(&part, numberOfPartsReceived == 0 ? ZMQ_DONTWAIT : 0))
+{
+return;
+}
+SOM_CATCH("Error receiving frame\n")
+
+morePartsToReceive = part.more();
+numberOfBytesRelayed += part.size();
+numberOfPartsReceived++;
+}
+
+numberOfCachedFrameParts = numberOfPartsReceived;
+numberOfFramesRelayed++;
+
+//ZMQ sends the welcome message to each subscriber as it connects and to no one else, so late joiners get a recent frame without the current subscribers seeing it twice (the welcome message is a single part, so multipart frames just aren't cached)
+int64_t currentTime = monotonicMicroseconds();
+if(numberOfCachedFrameParts == 1 && (!cachedFrameSet || (currentTime - lastCachedFrameUpdateTime) >= cachedFrameInterval*1000000.0))
+{ //ZMQ copies the frame, so only do it every so often
+SOM_TRY
+subscriberSocket->setsockopt(ZMQ_XPUB_WELCOME_MSG, cachedFrame[0]->data(), cachedFrame[0]->size());
+SOM_CATCH("Error caching frame for new subscribers\n")
+lastCachedFrameUpdateTime = currentTime;
+cachedFrameSet = true;
+}
+else if(numberOfCachedFrameParts != 1 && cachedFrameSet)
+{
+SOM_TRY
+subscriberSocket->setsockopt(ZMQ_XPUB_WELCOME_MSG, nullptr, 0);
+SOM_CATCH("Error clearing cached frame\n")
+cachedFrameSet = false;
+}
+
+SOM_TRY
+sendCachedFrame();
+SOM_CATCH("Error sending frame\n")
+}
+
+/**
+This function forwards a (un)subscription from a subscriber to the source.
+
+@throws: This function can throw exceptions
+*/
+void videoRelay::relaySubscription()
+{
+SOM_TRY
+if(!subscriberSocket->recv(&messageBuffer, ZMQ_DONTWAIT))
+{
+return;
+}
+SOM_CATCH("Error receiving subscription\n")
+
+if(messageBuffer.size() > 0 && ((const char *) messageBuffer.data())[0] == 1)
+{
+numberOfSubscriptions++;
+}
+
+SOM_TRY
+sourceSocket->send(messageBuffer);
+SOM_CATCH("Error forwarding subscription\n")
+}
+
+/**
+This function sends the cached frame to all of the current subscribers.
+
+@throws: This function can throw exceptions
+*/
+void videoRelay::sendCachedFrame()
+{
+for(size_t partIndex = 0; partIndex < numberOfCachedFrameParts; partIndex++)
+{
+//Copies share the (reference counted) data of large messages rather than duplicating it
+zmq::message_t part;
+part.copy(cachedFrame[partIndex].get());
+
+SOM_TRY
+subscriberSocket->send(part, (partIndex + 1) < numberOfCachedFrameParts ? ZMQ_SNDMORE : 0);
+SOM_CATCH("Error sending frame part\n")
+}
+}
+
+/**
+This function tracks subscribers connecting and disconnecting using the events from the subscriber socket's monitor.
+
+@throws: This function can throw exceptions
+*/
+void videoRelay::processMonitorEvent()
+{
+//Events are a 6 byte frame (16 bit event, 32 bit value which is the file descriptor) followed by the address
+uint16_t event = 0;
+int32_t fileDescriptor = 0;
+
+SOM_TRY
+if(!monitorSocket->recv(&messageBuffer, ZMQ_DONTWAIT))
+{
+return;
+}
+SOM_CATCH("Error receiving monitor event\n")
+
+bool eventValid = messageBuffer.size() >= (sizeof(event) + sizeof(fileDescriptor)) && messageBuffer.more();
+if(eventValid)
+{
+memcpy((void *) &event, messageBuffer.data(), sizeof(event));
+memcpy((void *) &fileDescriptor, ((const char *) messageBuffer.data()) + sizeof(event), sizeof(fileDescriptor));
+}
+
+while(messageBuffer.more())
+{
+SOM_TRY
+monitorSocket->recv(&messageBuffer);
+SOM_CATCH("Error receiving monitor event address\n")
+}
+
+if(!eventValid)
+{
+return;
+}
+
+if(event == ZMQ_EVENT_ACCEPTED)
+{
+videoRelaySubscriberStatistics &statistics = subscriberStatistics[fileDescriptor];
+statistics = videoRelaySubscriberStatistics();
+statistics.address = getPeerAddress(fileDescriptor);
+if(statistics.address.size() == 0)
+{ //Not TCP (or already closed), so use the endpoint from the event
+statistics.address = std::string((const char *) messageBuffer.data(), messageBuffer.size());
+}
+statistics.connectionTime = monotonicMicroseconds();
+}
+else if(event == ZMQ_EVENT_DISCONNECTED)
+{
+subscriberStatistics.erase(fileDescriptor);
+}
+}
+
+/**
+This function updates the throughput statistics from the kernel's counters for each subscriber connection.  The connections belong to ZMQ's I/O thread and are only known by file descriptor, which may have been closed and reused before the disconnect event arrives, so the counters are only used if the descriptor's peer address still matches the one recorded when the subscriber connected.
+@param inputCurrentTime: The current time (monotonicMicroseconds)
+*/
+void videoRelay::updateStatistics(int64_t inputCurrentTime)
+{
+double elapsedTime = (inputCurrentTime - lastStatisticsTime)/1000000.0;
+if(elapsedTime > 0.0)
+{
+sourceThroughput = (numberOfBytesRelayed - bytesRelayedAtLastStatistics)/elapsedTime;
+}
+bytesRelayedAtLastStatistics = numberOfBytesRelayed;
+
+for(std::pair<const int, videoRelaySubscriberStatistics> &subscriber : subscriberStatistics)
+{
+videoRelaySubscriberStatistics &statistics = subscriber.second;
+
+if(statistics.address != getPeerAddress(subscriber.first))
+{ //Descriptor closed (and maybe reused by another connection) before the disconnect event arrived
+statistics.tcpStatisticsAvailable = false;
+continue;
+}
+
+struct tcp_info information;
+socklen_t informationSize = sizeof(information);
+memset((void *) &information, 0, sizeof(information));
+
+//Older kernels return a shorter struct without the byte counters
+if(getsockopt(subscriber.first, IPPROTO_TCP, TCP_INFO, (void *) &information, &informationSize) != 0 || informationSize < (offsetof(struct tcp_info, tcpi_notsent_bytes) + sizeof(information.tcpi_notsent_bytes)))
+{ //Not TCP (ipc) or not supported
+statistics.tcpStatisticsAvailable = false;
+continue;
+}
+
+double sinceConnection = (inputCurrentTime - statistics.connectionTime)/1000000.0;
+uint64_t bytesAcknowledgedInInterval = information.tcpi_bytes_acked - statistics.bytesAcknowledged;
+double interval = statistics.tcpStatisticsAvailable ? elapsedTime : sinceConnection;
+
+statistics.throughput = interval > 0.0 ? bytesAcknowledgedInInterval/interval : 0.0;
+statistics.bytesAcknowledged = information.tcpi_bytes_acked;
+statistics.bytesQueued = information.tcpi_notsent_bytes;
+statistics.tcpStatisticsAvailable = true;
+}
+
+lastStatisticsTime = inputCurrentTime;
+}
+
+/**
+This function prints the relay's and each subscriber's statistics.
+*/
+void videoRelay::printStatistics() const
+{
+printf("Relayed %lu frames at %.1lf kB/s (%lu subscriptions), %lu subscribers connected\n", (unsigned long) numberOfFramesRelayed, sourceThroughput/1000.0, (unsigned long) numberOfSubscriptions, (unsigned long) subscriberStatistics.size());
+
+for(const std::pair<const int, videoRelaySubscriberStatistics> &subscriber : subscriberStatistics)
+{
+const videoRelaySubscriberStatistics &statistics = subscriber.second;
+if(statistics.tcpStatisticsAvailable)
+{
+printf("  %s: %.1lf kB/s, %lu bytes acknowledged, %lu bytes queued\n", statistics.address.c_str(), statistics.throughput/1000.0, (unsigned long) statistics.bytesAcknowledged, (unsigned long) statistics.bytesQueued);
+}
+else
+{
+printf("  %s: throughput not available (not TCP or disconnected)\n", statistics.address.c_str());
+}
+}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include<cstdio>
+#include<string>
+#include<vector>
+#include<map>
+#include<memory>
+#include<atomic>
+#include<zmq.hpp>
+#include "SOMException.hpp"
+#include "utilityFunctions.hpp"
+#include "linkQualityMonitor.hpp"
+
+namespace soaringPen
+{
+
+const double DEFAULT_VIDEO_RELAY_STATISTICS_INTERVAL = 5.0; //Seconds between statistics reports
+const double DEFAULT_VIDEO_RELAY_CACHED_FRAME_INTERVAL = .25; //Seconds between updates of the frame given to new subscribers (each update copies the frame)
+const int VIDEO_RELAY_SUBSCRIBER_QUEUE_SIZE = 4; //Frames queued per subscriber before frames are dropped for it, so slow viewers skip frames instead of falling behind
+
+/**
+This struct holds the throughput measurements for one subscriber of a videoRelay.  Byte counts come from the kernel's TCP statistics, so they are only available for TCP subscribers.
+*/
+struct videoRelaySubscriberStatistics
+{
+std::string address; //Address the subscriber connected from (or the relay's endpoint, if the peer address couldn't be read)
+int64_t connectionTime = 0; //When the subscriber connected (monotonicMicroseconds)
+bool tcpStatisticsAvailable = false;
+uint64_t bytesAcknowledged = 0; //Total bytes the subscriber has acknowledged
+uint64_t bytesQueued = 0; //Bytes sent to the subscriber's socket but not yet acknowledged
+double throughput = 0.0; //Bytes/second acknowledged over the last statistics interval
+};
+
+/**
+This class receives a video stream once and fans it out to any number of subscribers (GUIs, recorders), so each additional viewer doesn't cost more uplink bandwidth from the camera host.  It works as an XSUB/XPUB proxy which forwards subscriptions upstream and frames downstream.  A recent single part frame is kept as the XPUB socket's welcome message, so ZMQ gives it to each new subscriber as soon as it connects (and only to that subscriber) rather than making it wait for the next frame.  Setting the welcome message copies the frame, so it is only updated every cachedFrameInterval rather than with every frame.  This requires ZMQ 4.2 or later.
+*/
+class videoRelay
+{
+public:
+/**
+This function connects to the video source and binds the socket the subscribers connect to.
+@param inputContext: The ZMQ context to use (must outlive the relay)
+@param inputSourceEndpoint: The video publisher to connect to (see normalizeZMQConnectionEndpoint)
+@param inputSubscriberEndpoint: The endpoint to bind for the subscribers (see normalizeZMQBindEndpoint)
+@param inputStatisticsInterval: How often (seconds) to measure and print the throughput statistics (0 to not print them)
+@param inputCachedFrameInterval: How often (seconds) to update the frame given to new subscribers (0 to update it with every frame)
+
+@throws: This function can throw exceptions
+*/
+videoRelay(zmq::context_t &inputContext, const std::string &inputSourceEndpoint, const std::string &inputSubscriberEndpoint, double inputStatisticsInterval = DEFAULT_VIDEO_RELAY_STATISTICS_INTERVAL, double inputCachedFrameInterval = DEFAULT_VIDEO_RELAY_CACHED_FRAME_INTERVAL);
+
+/**
+This function relays video until shutdown is set.
+
+@throws: This function can throw exceptions
+*/
+void run();
+
+/**
+This function returns the statistics of the currently connected subscribers.
+@return: The statistics, indexed by the file descriptor of the subscriber's connection
+*/
+const std::map<int, videoRelaySubscriberStatistics> &getSubscriberStatistics() const;
+
+std::atomic<bool> shutdown{false}; //Set to make run() return
+uint64_t numberOfFramesRelayed = 0;
+uint64_t numberOfBytesRelayed = 0;
+uint64_t numberOfSubscriptions = 0; //Subscriptions forwarded to the source
+double sourceThroughput = 0.0; //Bytes/second received from the source over the last statistics interval
+
+protected:
+/**
+This function receives a frame from the source, caches it (updating the welcome message for new subscribers if cachedFrameInterval has passed) and sends it to the subscribers.
+
+@throws: This function can throw exceptions
+*/
+void relayFrame();
+
+/**
+This function forwards a (un)subscription from a subscriber to the source.
+
+@throws: This function can throw exceptions
+*/
+void relaySubscription();
+
+/**
+This function sends the cached frame to all of the current subscribers.
+
+@throws: This function can throw exceptions
+*/
+void sendCachedFrame();
+
+/**
+This function tracks subscribers connecting and disconnecting using the events from the subscriber socket's monitor.
+
+@throws: This function can throw exceptions
+*/
+void processMonitorEvent();
+
+/**
+This function updates the throughput statistics from the kernel's counters for each subscriber connection.  The connections belong to ZMQ's I/O thread and are only known by file descriptor, which may have been closed and reused before the disconnect event arrives, so the counters are only used if the descriptor's peer address still matches the one recorded when the subscriber connected.
+@param inputCurrentTime: The current time (monotonicMicroseconds)
+*/
+void updateStatistics(int64_t inputCurrentTime);
+
+/**
+This function prints the relay's and each subscriber's statistics.
+*/
+void printStatistics() const;
+
+double statisticsInterval;
+double cachedFrameInterval;
+int64_t lastCachedFrameUpdateTime = 0;
+bool cachedFrameSet = false; //True if the welcome message holds a frame
+int64_t lastStatisticsTime = 0;
+uint64_t bytesRelayedAtLastStatistics = 0;
+
+std::unique_ptr<zmq::socket_t> sourceSocket; //XSUB socket connected to the video publisher
+std::unique_ptr<zmq::socket_t> subscriberSocket; //XPUB socket the subscribers connect to
+std::unique_ptr<zmq::socket_t> monitorSocket; //PAIR socket receiving the subscriber socket's connection events
+
+std::vector<std::unique_ptr<zmq::message_t> > cachedFrame; //Parts of the last frame received (only the first numberOfCachedFrameParts are valid)
+size_t numberOfCachedFrameParts = 0;
+zmq::message_t messageBuffer;
+
+std::map<int, videoRelaySubscriberStatistics> subscriberStatistics;
+};
+
+}